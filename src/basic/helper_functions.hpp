@@ -11,6 +11,7 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <numeric>
 #include <sstream>
 #include <stack>
@@ -87,6 +88,41 @@ struct WaitController {
   bool isready = false;
 };
 
+// alignment for sample buffers, wide enough for any SIMD register we target(avx512).
+inline constexpr size_t simd_alignment = 64;
+
+// allocator for std::vector to keep sample buffers aligned for vector instructions.
+template <class T, size_t ALIGN = simd_alignment>
+struct AlignedAllocator {
+  using value_type = T;
+  template <class U>
+  struct rebind {
+    using other = AlignedAllocator<U, ALIGN>;
+  };
+  AlignedAllocator() noexcept = default;
+  template <class U>
+  AlignedAllocator(AlignedAllocator<U, ALIGN> const& /*unused*/) noexcept {}  // NOLINT
+  T* allocate(size_t n) {
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(ALIGN)));
+  }
+  void deallocate(T* p, size_t /*n*/) noexcept { ::operator delete(p, std::align_val_t(ALIGN)); }
+  template <class U>
+  bool operator==(AlignedAllocator<U, ALIGN> const& /*unused*/) const noexcept {
+    return true;
+  }
+  template <class U>
+  bool operator!=(AlignedAllocator<U, ALIGN> const& /*unused*/) const noexcept {
+    return false;
+  }
+};
+template <class T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+// total size of the elements of vectors, for memory reports.
+template <class... V>
+size_t getElementBytes(V const&... vectors) {
+  return (size_t(0) + ... + (vectors.size() * sizeof(typename V::value_type)));
+}
+
 // for ast
 template <class ElementType>
 static std::string join(std::deque<ElementType>& vec, std::string delim) {
@@ -0,0 +1,83 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/builtin/arrayops.hpp"
+#include <algorithm>
+#include "basic/helper_functions.hpp"
+
+namespace mimium::builtin::array {
+
+namespace {
+constexpr size_t num_partials = 4;
+
+template <typename F>
+void elementwise(double* dst, const double* a, const double* b, size_t size, F&& op) {
+  for (size_t i = 0; i < size; i++) { dst[i] = op(a[i], b[i]); }
+}
+
+// reduction with independent partial results, combined at the end.
+template <typename F>
+double reduce(const double* src, size_t size, double init, F&& op) {
+  double partial[num_partials] = {init, init, init, init};
+  size_t i = 0;
+  for (; i + num_partials <= size; i += num_partials) {
+    for (size_t j = 0; j < num_partials; j++) { partial[j] = op(partial[j], src[i + j]); }
+  }
+  for (; i < size; i++) { partial[0] = op(partial[0], src[i]); }
+  return op(op(partial[0], partial[1]), op(partial[2], partial[3]));
+}
+}  // namespace
+
+void fill(double* dst, double value, size_t size) { std::fill(dst, dst + size, value); }
+void copy(double* dst, const double* src, size_t size) {
+  if (dst != src) { std::copy(src, src + size, dst); }
+}
+void add(double* dst, const double* a, const double* b, size_t size) {
+  elementwise(dst, a, b, size, [](double x, double y) { return x + y; });
+}
+void sub(double* dst, const double* a, const double* b, size_t size) {
+  elementwise(dst, a, b, size, [](double x, double y) { return x - y; });
+}
+void mul(double* dst, const double* a, const double* b, size_t size) {
+  elementwise(dst, a, b, size, [](double x, double y) { return x * y; });
+}
+void div(double* dst, const double* a, const double* b, size_t size) {
+  elementwise(dst, a, b, size, [](double x, double y) { return x / y; });
+}
+void scale(double* dst, const double* src, double gain, double offset, size_t size) {
+  for (size_t i = 0; i < size; i++) { dst[i] = src[i] * gain + offset; }
+}
+
+double dot(const double* a, const double* b, size_t size) {
+  double partial[num_partials] = {0.0, 0.0, 0.0, 0.0};
+  size_t i = 0;
+  for (; i + num_partials <= size; i += num_partials) {
+    for (size_t j = 0; j < num_partials; j++) { partial[j] += a[i + j] * b[i + j]; }
+  }
+  for (; i < size; i++) { partial[0] += a[i] * b[i]; }
+  return (partial[0] + partial[1]) + (partial[2] + partial[3]);
+}
+double sum(const double* src, size_t size) {
+  return reduce(src, size, 0.0, [](double x, double y) { return x + y; });
+}
+double min(const double* src, size_t size) {
+  if (size == 0) { return 0.0; }
+  return reduce(src, size, src[0], [](double x, double y) { return std::min(x, y); });
+}
+double max(const double* src, size_t size) {
+  if (size == 0) { return 0.0; }
+  return reduce(src, size, src[0], [](double x, double y) { return std::max(x, y); });
+}
+
+void map(double* dst, const double* src, size_t size, MapFn fn) {
+  for (size_t i = 0; i < size; i++) { dst[i] = fn(src[i]); }
+}
+double fold(const double* src, size_t size, double init, FoldFn fn) {
+  // callback may not be associative, so it is folded from left in order.
+  double acc = init;
+  for (size_t i = 0; i < size; i++) { acc = fn(acc, src[i]); }
+  return acc;
+}
+
+}  // namespace mimium::builtin::array
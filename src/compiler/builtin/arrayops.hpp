@@ -0,0 +1,34 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstddef>
+
+namespace mimium::builtin::array {
+
+// Bulk operations on arrays of double. Element-wise kernels allow `dst` to be the same array as
+// a source. Loops are written so that the compiler vectorizes them; reductions keep several
+// partial results to break the dependency chain without relying on fast-math.
+
+void fill(double* dst, double value, size_t size);
+void copy(double* dst, const double* src, size_t size);
+void add(double* dst, const double* a, const double* b, size_t size);
+void sub(double* dst, const double* a, const double* b, size_t size);
+void mul(double* dst, const double* a, const double* b, size_t size);
+void div(double* dst, const double* a, const double* b, size_t size);
+// dst = src * gain + offset
+void scale(double* dst, const double* src, double gain, double offset, size_t size);
+
+double dot(const double* a, const double* b, size_t size);
+double sum(const double* src, size_t size);
+// returns 0 for an empty array.
+double min(const double* src, size_t size);
+double max(const double* src, size_t size);
+
+using MapFn = double (*)(double);
+using FoldFn = double (*)(double, double);
+void map(double* dst, const double* src, size_t size, MapFn fn);
+double fold(const double* src, size_t size, double init, FoldFn fn);
+
+}  // namespace mimium::builtin::array
@@ -0,0 +1,101 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/builtin/context.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+namespace mimium::builtin {
+
+namespace {
+thread_local bool preparing_thread = false;
+}  // namespace
+
+Context::~Context() {
+  // states may refer to cached objects and are released first, newest first.
+  while (!states.empty()) { states.pop_back(); }
+}
+
+bool Context::isPreparingThread() { return preparing_thread; }
+
+void Context::beginPrepare() {
+  preparing = true;
+  preparing_thread = true;
+  prepared.clear();
+  arrays_backup = arrays;
+}
+
+std::vector<std::pair<void**, void*>> Context::endPrepare() {
+  preparing = false;
+  preparing_thread = false;
+  // arrays allocated while preparing are kept as they are.
+  for (size_t idx = 0; idx < arrays_backup.size(); idx++) {
+    std::copy(arrays_backup[idx].cbegin(), arrays_backup[idx].cend(), arrays[idx].begin());
+  }
+  arrays_backup.clear();
+  for (auto* data : cleared_arrays) { std::fill_n(data, extents.at(data).first, 0.0); }
+  cleared_arrays.clear();
+  return std::move(prepared);
+}
+
+void* Context::addState(std::shared_ptr<void> state, void** slot) {
+  if (preparing) { prepared.emplace_back(slot, state.get()); }
+  if (running) { late_count++; }
+  return states.emplace_back(std::move(state)).get();
+}
+
+double* Context::allocateArray(size_t size, bool cleared) {
+  if (running) { late_count++; }
+  // at least 1 element to return a valid pointer. the data of a moved vector stays at the same
+  // address.
+  auto& array = arrays.emplace_back(std::max<size_t>(size, 1), 0.0);
+  array_bytes += getElementBytes(array);
+  registerArray(array.data(), size, true);
+  if (preparing && cleared) { cleared_arrays.push_back(array.data()); }
+  return array.data();
+}
+
+void Context::registerArray(const double* data, size_t size, bool writable) {
+  extents.insert_or_assign(data, std::pair(size, writable));
+}
+
+std::optional<Context::ArrayExtent> Context::findArray(const double* ptr) const {
+  auto iter = extents.upper_bound(ptr);
+  if (iter == extents.begin()) { return std::nullopt; }
+  --iter;
+  const auto [size, writable] = iter->second;
+  const auto offset = static_cast<size_t>(ptr - iter->first);
+  // an empty array still holds its first element.
+  if (offset >= std::max<size_t>(size, 1)) { return std::nullopt; }
+  return ArrayExtent{size - std::min(offset, size), writable};
+}
+
+size_t Context::clampSize(const double* data, size_t size, bool write) {
+  auto extent = findArray(data);
+  if (!extent) { return size; }
+  if (write && !extent->writable) {
+    rejected_writes++;
+    return 0;
+  }
+  return std::min(size, extent->size);
+}
+
+Context::CacheEntry& Context::findCache(std::string const& kind, const double* data,
+                                        size_t size) {
+  const std::string_view bytes(reinterpret_cast<const char*>(data), size * sizeof(double));
+  const size_t hash = std::hash<std::string_view>{}(bytes) ^ std::hash<std::string>{}(kind);
+  auto [begin, end] = cache.equal_range(hash);
+  auto iter = std::find_if(begin, end, [&](auto const& pair) {
+    auto const& entry = pair.second;
+    return entry.kind == kind && entry.data.size() == size &&
+           (size == 0 || std::memcmp(entry.data.data(), data, size * sizeof(double)) == 0);
+  });
+  if (iter != end) { return iter->second; }
+  return cache.emplace(hash, CacheEntry{kind, std::vector<double>(data, data + size), nullptr})
+      ->second;
+}
+
+}  // namespace mimium::builtin
@@ -0,0 +1,157 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "basic/helper_functions.hpp"
+
+namespace mimium::builtin {
+
+// Internal states of stateful builtins(convolve, stft, ...) and data shared between them, owned
+// by a runtime instance. Memory objects of mimium hold only a pointer to a state, as they are
+// released without calling destructors.
+// Before the audio thread starts, the runtime evaluates dsp once in the preparing mode, in which
+// builtins create their states and return without processing, and output builtins print nothing.
+// The arrays of the context are restored afterwards. States created later on the audio
+// thread(e.g. in a branch not taken at the first sample) are counted as late.
+// The context also knows the extents of arrays given to builtins: the ones it allocates, and the
+// ones registered by their owners(the runtime heap, samples). Lengths passed to array
+// builtins are clamped to them, and writes to read-only arrays are refused.
+class Context {
+ public:
+  Context() = default;
+  ~Context();
+  Context(Context const&) = delete;
+  Context& operator=(Context const&) = delete;
+
+  [[nodiscard]] bool isPreparing() const { return preparing; }
+  // true while a context prepares on the calling thread, for builtins without the context(print).
+  static bool isPreparingThread();
+  void beginPrepare();
+  // restores the arrays allocated before beginPrepare(), and returns the slots in memory objects
+  // and the states written to them while preparing, to restore them after the memory objects are
+  // reset.
+  std::vector<std::pair<void**, void*>> endPrepare();
+  // called when the audio thread starts and stops.
+  void setRunning(bool running) { this->running = running; }
+  // false when the audio is not processed in real time(e.g. offline rendering), where builtins
+  // may wait for their worker threads.
+  [[nodiscard]] bool isRealtime() const { return realtime; }
+  void setRealtime(bool realtime) { this->realtime = realtime; }
+  // sample rate of the audio driver for builtins which take frequency in Hz, set before the
+  // preparation.
+  [[nodiscard]] double getSampleRate() const { return samplerate; }
+  void setSampleRate(double samplerate) {
+    if (samplerate > 0.0) { this->samplerate = samplerate; }
+  }
+  [[nodiscard]] size_t getLateCount() const { return late_count; }
+  [[nodiscard]] size_t getStateCount() const { return states.size(); }
+  // memory held by the context, reported by `--mem-report`. states and shared objects are
+  // measured by their getBytes() when they are created.
+  [[nodiscard]] size_t getStateBytes() const { return state_bytes; }
+  [[nodiscard]] size_t getSharedCount() const { return cache.size(); }
+  [[nodiscard]] size_t getSharedBytes() const { return shared_bytes; }
+  [[nodiscard]] size_t getArrayCount() const { return arrays.size(); }
+  [[nodiscard]] size_t getArrayBytes() const { return array_bytes; }
+
+  struct ArrayExtent {
+    // number of elements from the given pointer to the end of the array.
+    size_t size;
+    bool writable;
+  };
+  // zero-filled array aligned for vector instructions, released with the context. arrays
+  // allocated while preparing keep their contents(e.g. loaded samples), unless `cleared`, which
+  // are filled with zeros again like the ones of states.
+  double* allocateArray(size_t size, bool cleared = false);
+  void registerArray(const double* data, size_t size, bool writable);
+  [[nodiscard]] std::optional<ArrayExtent> findArray(const double* ptr) const;
+  // size clamped to the extent of the array. arrays of unknown extent(e.g. on the stack) are
+  // trusted. returns 0 and counts a rejected write if the array is read-only.
+  size_t clampSize(const double* data, size_t size, bool write = false);
+  [[nodiscard]] size_t getRejectedWrites() const { return rejected_writes; }
+  // total size of the files mapped for the arrays(see DataFile).
+  [[nodiscard]] size_t getMappedBytes() const { return mapped_bytes; }
+  void addMappedBytes(size_t bytes) { mapped_bytes += bytes; }
+
+  // keeps an object backing arrays(e.g. a mapped file) until the context is released.
+  template <class T>
+  T* keep(std::unique_ptr<T> object) {
+    if (running) { late_count++; }
+    return static_cast<T*>(kept.emplace_back(std::shared_ptr<T>(std::move(object))).get());
+  }
+
+  // returns the state in the slot of a memory object, created by make() if the slot is empty.
+  template <class T, class F>
+  T* getState(void** slot, F&& make) {
+    if (*slot == nullptr) {
+      std::shared_ptr<T> state(make());
+      state_bytes += getObjectBytes(*state);
+      *slot = addState(std::move(state), slot);
+    }
+    return static_cast<T*>(*slot);
+  }
+
+  // returns the object made by make() from the array, shared between calls with the same kind
+  // and the same contents of the array.
+  template <class T, class F>
+  std::shared_ptr<const T> getCached(std::string const& kind, const double* data, size_t size,
+                                     F&& make) {
+    auto& entry = findCache(kind, data, size);
+    if (!entry.object) {
+      std::shared_ptr<const T> object(make());
+      shared_bytes += getObjectBytes(*object);
+      entry.object = std::move(object);
+    }
+    return std::static_pointer_cast<const T>(entry.object);
+  }
+
+ private:
+  struct CacheEntry {
+    std::string kind;
+    std::vector<double> data;
+    std::shared_ptr<const void> object;
+  };
+  bool preparing = false;
+  bool running = false;
+  bool realtime = true;
+  double samplerate = 48000.0;
+  size_t late_count = 0;
+  size_t rejected_writes = 0;
+  size_t mapped_bytes = 0;
+  size_t state_bytes = 0;
+  size_t shared_bytes = 0;
+  size_t array_bytes = 0;
+  std::vector<AlignedVector<double>> arrays;
+  std::vector<std::shared_ptr<void>> kept;
+  // keyed by the first element.
+  std::map<const double*, std::pair<size_t, bool>> extents;
+  std::vector<std::pair<void**, void*>> prepared;
+  std::vector<AlignedVector<double>> arrays_backup;
+  std::vector<double*> cleared_arrays;
+  // destroyed in the reverse order of creation.
+  std::vector<std::shared_ptr<void>> states;
+  std::unordered_multimap<size_t, CacheEntry> cache;
+  void* addState(std::shared_ptr<void> state, void** slot);
+  template <class T, class = void>
+  struct HasBytes : std::false_type {};
+  template <class T>
+  struct HasBytes<T, std::void_t<decltype(std::declval<T const&>().getBytes())>>
+      : std::true_type {};
+  // the object and its buffers if it tells them by getBytes().
+  template <class T>
+  static size_t getObjectBytes(T const& object) {
+    if constexpr (HasBytes<T>::value) { return sizeof(T) + object.getBytes(); }
+    return sizeof(T);
+  }
+  CacheEntry& findCache(std::string const& kind, const double* data, size_t size);
+};
+
+}  // namespace mimium::builtin
@@ -0,0 +1,248 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/builtin/convolver.hpp"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <utility>
+#include "compiler/builtin/context.hpp"
+
+namespace mimium::builtin {
+
+namespace {
+// writes spectra of `num` partitions of `block` taps starting from ir[offset].
+void transformPartitions(const double* ir, size_t offset, size_t end, size_t block, size_t num,
+                         AlignedVector<double>& re, AlignedVector<double>& im) {
+  RealFFT fft(block * 2);
+  const size_t bins = fft.getNumBins();
+  re.assign(bins * num, 0.0);
+  im.assign(bins * num, 0.0);
+  AlignedVector<double> frame(block * 2);
+  for (size_t p = 0; p < num; p++) {
+    std::fill(frame.begin(), frame.end(), 0.0);
+    const size_t begin = offset + p * block;
+    const size_t count = std::min(block, end - begin);
+    std::copy(ir + begin, ir + begin + count, frame.begin());
+    fft.forward(frame.data(), &re[p * bins], &im[p * bins]);
+  }
+}
+size_t divCeil(size_t a, size_t b) { return (a + b - 1) / b; }
+}  // namespace
+
+ConvolverIR::ConvolverIR(const double* ir, size_t irsize, size_t head_block, size_t tail_block)
+    : head_block(head_block),
+      tail_block(tail_block),
+      fir(head_block, 0.0),
+      head_bins(head_block + 1),
+      tail_bins(tail_block + 1) {
+  if (!RealFFT::isPowerOfTwo(head_block) || !RealFFT::isPowerOfTwo(tail_block) ||
+      head_block > tail_block) {
+    throw std::runtime_error("block sizes of convolver must be power of 2.");
+  }
+  const size_t firsize = std::min(irsize, head_block);
+  for (size_t i = 0; i < firsize; i++) { fir[head_block - 1 - i] = ir[i]; }
+  const size_t head_end = std::min(irsize, tail_block * 2);
+  if (head_end > head_block) {
+    num_head_partitions = divCeil(head_end - head_block, head_block);
+    transformPartitions(ir, head_block, head_end, head_block, num_head_partitions, head_re,
+                        head_im);
+  }
+  if (irsize > tail_block * 2) {
+    num_tail_partitions = divCeil(irsize - tail_block * 2, tail_block);
+    transformPartitions(ir, tail_block * 2, irsize, tail_block, num_tail_partitions, tail_re,
+                        tail_im);
+  }
+}
+
+size_t ConvolverIR::getBytes() const {
+  return getElementBytes(fir, head_re, head_im, tail_re, tail_im);
+}
+
+PartitionedConvolution::PartitionedConvolution(size_t block, size_t numpartitions,
+                                               const double* ir_re, const double* ir_im)
+    : block(block),
+      bins(block + 1),
+      numpartitions(numpartitions),
+      ir_re(ir_re),
+      ir_im(ir_im),
+      fft(block * 2),
+      frame(block * 2, 0.0),
+      fdl_re(bins * numpartitions, 0.0),
+      fdl_im(bins * numpartitions, 0.0),
+      acc_re(bins),
+      acc_im(bins),
+      result(block * 2) {}
+
+void PartitionedConvolution::process(const double* input, double* output) {
+  std::copy(input, input + block, std::next(frame.begin(), block));
+  fft.forward(frame.data(), &fdl_re[current * bins], &fdl_im[current * bins]);
+  std::fill(acc_re.begin(), acc_re.end(), 0.0);
+  std::fill(acc_im.begin(), acc_im.end(), 0.0);
+  for (size_t p = 0; p < numpartitions; p++) {
+    const size_t slot = (current + numpartitions - p) % numpartitions;
+    spectrumMulAdd(&fdl_re[slot * bins], &fdl_im[slot * bins], &ir_re[p * bins],
+                   &ir_im[p * bins], acc_re.data(), acc_im.data(), bins);
+  }
+  fft.inverse(acc_re.data(), acc_im.data(), result.data());
+  // overlap-save: latter half is the valid result of linear convolution.
+  std::copy(std::next(result.begin(), block), result.end(), output);
+  std::copy(input, input + block, frame.begin());
+  current = (current + 1) % numpartitions;
+}
+
+size_t PartitionedConvolution::getBytes() const {
+  return fft.getBytes() + getElementBytes(frame, fdl_re, fdl_im, acc_re, acc_im, result);
+}
+
+void PartitionedConvolution::reset() {
+  std::fill(frame.begin(), frame.end(), 0.0);
+  std::fill(fdl_re.begin(), fdl_re.end(), 0.0);
+  std::fill(fdl_im.begin(), fdl_im.end(), 0.0);
+  current = 0;
+}
+
+Convolver::Convolver(std::shared_ptr<const ConvolverIR> ir, bool threaded)
+    : ir(std::move(ir)),
+      head_block(this->ir->head_block),
+      tail_block(this->ir->tail_block),
+      history(head_block * 2, 0.0),
+      head_in(head_block, 0.0),
+      head_out(head_block, 0.0),
+      tail_in(tail_block, 0.0),
+      tail_out(tail_block, 0.0) {
+  if (this->ir->num_head_partitions > 0) {
+    head = std::make_unique<PartitionedConvolution>(head_block, this->ir->num_head_partitions,
+                                                    this->ir->head_re.data(),
+                                                    this->ir->head_im.data());
+  }
+  if (this->ir->num_tail_partitions > 0) {
+    tail = std::make_unique<PartitionedConvolution>(tail_block, this->ir->num_tail_partitions,
+                                                    this->ir->tail_re.data(),
+                                                    this->ir->tail_im.data());
+    for (auto& job : jobs) {
+      job.in.resize(tail_block, 0.0);
+      job.out.resize(tail_block, 0.0);
+    }
+    if (threaded) { worker = std::thread([&]() { workerLoop(); }); }
+  }
+}
+
+size_t Convolver::getBytes() const {
+  size_t res = getElementBytes(history, head_in, head_out, tail_in, tail_out);
+  for (const auto* conv : {head.get(), tail.get()}) {
+    if (conv != nullptr) { res += sizeof(*conv) + conv->getBytes(); }
+  }
+  for (const auto& job : jobs) { res += getElementBytes(job.in, job.out); }
+  return res;
+}
+
+Convolver::~Convolver() {
+  if (worker.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      quit = true;
+    }
+    cv.notify_all();
+    worker.join();
+  }
+  if (missed > 0) {
+    Logger::debug_log("convolve: " + std::to_string(missed) +
+                          " blocks of the tail missed the deadline and were muted",
+                      Logger::WARNING);
+  }
+}
+
+double Convolver::process(double input) {
+  history[history_pos] = input;
+  history[history_pos + head_block] = input;
+  const double* window = &history[history_pos + 1];
+  history_pos = (history_pos + 1) % head_block;
+  double res = std::inner_product(window, window + head_block, ir->fir.data(), 0.0);
+  if (head) {
+    res += head_out[head_pos];
+    head_in[head_pos] = input;
+    if (++head_pos == head_block) {
+      head->process(head_in.data(), head_out.data());
+      head_pos = 0;
+    }
+  }
+  if (tail) {
+    res += tail_out[tail_pos];
+    tail_in[tail_pos] = input;
+    if (++tail_pos == tail_block) {
+      tailBlockBoundary();
+      tail_pos = 0;
+    }
+  }
+  return res;
+}
+
+// the job submitted at the end of block n computes the output for block n+2, so the worker has
+// a period of one tail block to finish it.
+void Convolver::tailBlockBoundary() {
+  const size_t done = completed.load(std::memory_order_acquire);
+  if (has_pending && done > pending) {
+    std::copy(jobs[pending % num_jobs].out.begin(), jobs[pending % num_jobs].out.end(),
+              tail_out.begin());
+  } else {
+    std::fill(tail_out.begin(), tail_out.end(), 0.0);
+    if (has_pending) { missed++; }
+  }
+  const size_t next = submitted.load(std::memory_order_relaxed);
+  has_pending = next - done < num_jobs;
+  if (!has_pending) {
+    // the input of this block is lost, the history of the tail is cleared by the next job.
+    reset_tail = true;
+    return;
+  }
+  auto& job = jobs[next % num_jobs];
+  std::copy(tail_in.begin(), tail_in.end(), job.in.begin());
+  job.reset = std::exchange(reset_tail, false);
+  pending = next;
+  submitted.store(next + 1, std::memory_order_release);
+  if (!worker.joinable()) {
+    runJob(next);
+    return;
+  }
+  // the worker may be holding the lock only while it checks for jobs, and it wakes up by timeout
+  // if the notification is missed.
+  std::unique_lock<std::mutex> lock(mtx, std::try_to_lock);
+  cv.notify_one();
+}
+
+void Convolver::workerLoop() {
+  // sleeps at most this period when a notification is missed.
+  const auto timeout = std::chrono::milliseconds(1);
+  size_t next = 0;
+  std::unique_lock<std::mutex> lock(mtx);
+  while (true) {
+    cv.wait_for(lock, timeout, [&]() {
+      return quit || submitted.load(std::memory_order_acquire) > next;
+    });
+    if (quit) { break; }
+    if (submitted.load(std::memory_order_acquire) <= next) { continue; }
+    lock.unlock();
+    runJob(next++);
+    lock.lock();
+  }
+}
+
+void Convolver::runJob(size_t n) {
+  auto& job = jobs[n % num_jobs];
+  if (job.reset) { tail->reset(); }
+  tail->process(job.in.data(), job.out.data());
+  completed.store(n + 1, std::memory_order_release);
+}
+
+std::unique_ptr<Convolver> createConvolver(Context& ctx, const double* ir, size_t irsize) {
+  irsize = ctx.clampSize(ir, irsize);
+  auto cached = ctx.getCached<ConvolverIR>("convolver", ir, irsize, [&]() {
+    return std::make_unique<const ConvolverIR>(ir, irsize, Convolver::default_head_block,
+                                               Convolver::default_tail_block);
+  });
+  return std::make_unique<Convolver>(std::move(cached), ctx.isRealtime());
+}
+
+}  // namespace mimium::builtin
@@ -0,0 +1,131 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "compiler/builtin/fft.hpp"
+
+namespace mimium::builtin {
+class Context;
+
+// Impulse response split into partitions and transformed in advance.
+// It is shared between convolvers using the same impulse response.
+struct ConvolverIR {
+  ConvolverIR(const double* ir, size_t irsize, size_t head_block, size_t tail_block);
+  [[nodiscard]] size_t getBytes() const;
+  size_t head_block;
+  size_t tail_block;
+  // reversed first `head_block` taps for direct form FIR.
+  AlignedVector<double> fir;
+  // spectra of partitions, `bins` complex values for each.
+  size_t head_bins;
+  size_t num_head_partitions = 0;
+  AlignedVector<double> head_re;
+  AlignedVector<double> head_im;
+  size_t tail_bins;
+  size_t num_tail_partitions = 0;
+  AlignedVector<double> tail_re;
+  AlignedVector<double> tail_im;
+};
+
+// Frequency-domain delay line of uniformly partitioned overlap-save convolution.
+class PartitionedConvolution {
+ public:
+  PartitionedConvolution(size_t block, size_t numpartitions, const double* ir_re,
+                         const double* ir_im);
+  // takes a new input block and writes the output block which starts `block` samples later.
+  void process(const double* input, double* output);
+  // clears the input history.
+  void reset();
+  [[nodiscard]] size_t getBytes() const;
+
+ private:
+  size_t block;
+  size_t bins;
+  size_t numpartitions;
+  const double* ir_re;
+  const double* ir_im;
+  RealFFT fft;
+  size_t current = 0;
+  AlignedVector<double> frame;  // previous block and current block
+  AlignedVector<double> fdl_re;
+  AlignedVector<double> fdl_im;
+  AlignedVector<double> acc_re;
+  AlignedVector<double> acc_im;
+  AlignedVector<double> result;
+};
+
+// Convolution without additional latency for long impulse responses.
+// - the first `head_block` taps are computed by direct form FIR,
+// - taps until 2*`tail_block` are computed by partitioned convolution with `head_block` size,
+// - rest of taps are computed by partitioned convolution with `tail_block` size on a worker
+// thread, having a period of a tail block as a deadline.
+// process() never waits for the worker. A tail block which misses the deadline is output as
+// silence, and the tail is restarted if the worker falls behind by `num_jobs` blocks.
+// Without `threaded`(e.g. for offline rendering), the tail is computed in process() instead.
+class Convolver {
+ public:
+  explicit Convolver(std::shared_ptr<const ConvolverIR> ir, bool threaded = true);
+  ~Convolver();
+  Convolver(Convolver const&) = delete;
+  Convolver& operator=(Convolver const&) = delete;
+  double process(double input);
+  // number of tail blocks which missed the deadline.
+  [[nodiscard]] size_t getMissedBlocks() const { return missed; }
+  // excluding the impulse response shared in the context.
+  [[nodiscard]] size_t getBytes() const;
+
+  static constexpr size_t default_head_block = 64;
+  static constexpr size_t default_tail_block = 1024;
+  static constexpr size_t num_jobs = 4;
+
+ private:
+  std::shared_ptr<const ConvolverIR> ir;
+  const size_t head_block;
+  const size_t tail_block;
+  AlignedVector<double> history;  // input history for fir, written twice to be contiguous
+  size_t history_pos = 0;
+
+  std::unique_ptr<PartitionedConvolution> head;
+  AlignedVector<double> head_in;
+  AlignedVector<double> head_out;
+  size_t head_pos = 0;
+
+  std::unique_ptr<PartitionedConvolution> tail;
+  AlignedVector<double> tail_in;
+  AlignedVector<double> tail_out;
+  size_t tail_pos = 0;
+  void tailBlockBoundary();
+  void workerLoop();
+  void runJob(size_t n);
+  // ring of jobs. the job n uses jobs[n % num_jobs], written by the audio thread until
+  // `submitted` exceeds n and by the worker until `completed` exceeds n.
+  struct Job {
+    AlignedVector<double> in;
+    AlignedVector<double> out;
+    bool reset = false;
+  };
+  std::array<Job, num_jobs> jobs;
+  std::atomic<size_t> submitted = 0;
+  std::atomic<size_t> completed = 0;
+  std::atomic<bool> quit = false;
+  // the job whose output is played in the next tail block, if any. used by the audio thread.
+  bool has_pending = false;
+  size_t pending = 0;
+  bool reset_tail = false;
+  size_t missed = 0;
+  std::thread worker;
+  std::mutex mtx;
+  std::condition_variable cv;
+};
+
+// Transformed impulse responses are shared between convolvers in the context by the contents.
+std::unique_ptr<Convolver> createConvolver(Context& ctx, const double* ir, size_t irsize);
+
+}  // namespace mimium::builtin
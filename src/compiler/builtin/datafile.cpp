@@ -0,0 +1,112 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/builtin/datafile.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include "compiler/builtin/context.hpp"
+#include "compiler/builtin/samplepool.hpp"
+#include "utils/include_filesystem.hpp"
+
+#ifdef _WIN32
+#define MIMIUM_DATAFILE_NO_MMAP
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mimium::builtin {
+
+DataFile::DataFile(std::string const& filename) {
+#ifndef MIMIUM_DATAFILE_NO_MMAP
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) { throw std::runtime_error("cannot open"); }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("cannot get file size");
+  }
+  bytes = static_cast<size_t>(st.st_size);
+  if (bytes > 0) {
+    // pages are copied only when written, and the file is never modified. mapping starts at page
+    // boundary, which satisfies simd_alignment.
+    void* addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) { throw std::runtime_error("mmap failed"); }
+    mapped = addr;
+  } else {
+    ::close(fd);
+  }
+#else
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  if (!file) { throw std::runtime_error("cannot open"); }
+  bytes = static_cast<size_t>(file.tellg());
+  fallback.resize((bytes + sizeof(double) - 1) / sizeof(double));
+  file.seekg(0);
+  file.read(reinterpret_cast<char*>(fallback.data()), static_cast<std::streamsize>(bytes));
+#endif
+}
+
+DataFile::~DataFile() {
+#ifndef MIMIUM_DATAFILE_NO_MMAP
+  if (mapped != nullptr) { ::munmap(mapped, bytes); }
+#endif
+}
+
+double* DataFile::data() {
+  return mapped != nullptr ? static_cast<double*>(mapped) : fallback.data();
+}
+
+bool DataFile::isAudioFile(std::string const& filename) {
+  const auto dot = filename.rfind('.');
+  if (dot == std::string::npos) { return false; }
+  std::string ext = filename.substr(dot + 1);
+  std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) {
+    return static_cast<char>(std::tolower(c));
+  });
+  return has({"wav", "aif", "aiff", "flac", "ogg", "caf"}, ext);
+}
+
+DataArray DataFile::load(Context& ctx, std::string const& filename) {
+  if (isAudioFile(filename)) {
+    // samples in the pool are shared by runtimes, and copied like loadwav.
+    const auto& sample = SamplePool::load(filename);
+    const size_t size = sample.frames * sample.channels;
+    double* data = ctx.allocateArray(size);
+    std::copy_n(sample.data.data(), size, data);
+    return {data, size};
+  }
+  std::unique_ptr<DataFile> file;
+  try {
+    file = std::make_unique<DataFile>(filename);
+  } catch (std::exception& e) {
+    Logger::debug_log("failed to load " + filename + " : " + e.what(), Logger::ERROR_);
+    return {ctx.allocateArray(0), 0};
+  }
+  if (file->bytes % sizeof(double) != 0) {
+    Logger::debug_log(filename + " : trailing bytes which do not form a float64 are ignored",
+                      Logger::WARNING);
+  }
+  if (file->size() == 0) { return {ctx.allocateArray(0), 0}; }
+  const DataArray res{file->data(), file->size()};
+  ctx.registerArray(res.data, res.size, true);
+  ctx.addMappedBytes(file->bytes);
+  ctx.keep(std::move(file));
+  return res;
+}
+
+size_t DataFile::getSize(std::string const& filename) {
+  if (isAudioFile(filename)) {
+    const auto& sample = SamplePool::load(filename);
+    return sample.frames * sample.channels;
+  }
+  std::error_code ec;
+  const auto bytes = fs::file_size(filename, ec);
+  return ec ? 0 : static_cast<size_t>(bytes) / sizeof(double);
+}
+
+}  // namespace mimium::builtin
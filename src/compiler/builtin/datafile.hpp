@@ -0,0 +1,46 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <string>
+#include "basic/helper_functions.hpp"
+
+namespace mimium::builtin {
+
+class Context;
+
+struct DataArray {
+  double* data;
+  size_t size;
+};
+
+// Array imported from a file at runtime without passing it through the compiler.
+// Raw native-endian float64 files are memory-mapped copy-on-write, so large tables cost nothing
+// until they are read, and writes stay private to the program. Audio files(by extension) are
+// decoded through the sample pool and copied. Either way data is aligned at least to
+// simd_alignment, writable, and owned by the builtin context of the runtime.
+class DataFile {
+ public:
+  // throws std::runtime_error if the file can not be mapped.
+  explicit DataFile(std::string const& filename);
+  ~DataFile();
+  DataFile(DataFile const&) = delete;
+  DataFile& operator=(DataFile const&) = delete;
+  [[nodiscard]] double* data();
+  [[nodiscard]] size_t size() const { return bytes / sizeof(double); }
+  [[nodiscard]] size_t getBytes() const { return bytes; }
+
+  // an empty array if the file can not be read.
+  static DataArray load(Context& ctx, std::string const& filename);
+  // number of elements load() returns, without loading raw files.
+  static size_t getSize(std::string const& filename);
+  static bool isAudioFile(std::string const& filename);
+
+ private:
+  size_t bytes = 0;
+  void* mapped = nullptr;
+  AlignedVector<double> fallback;
+};
+
+}  // namespace mimium::builtin
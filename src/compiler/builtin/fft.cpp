@@ -0,0 +1,130 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/builtin/fft.hpp"
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+namespace mimium::builtin {
+
+RealFFT::RealFFT(size_t size)
+    : size(size),
+      half(size / 2),
+      tw_re(size / 2),
+      tw_im(size / 2),
+      split_re(size / 2 + 1),
+      split_im(size / 2 + 1),
+      bitrev(size / 2),
+      work_re(size / 2 + 1),
+      work_im(size / 2 + 1) {
+  if (size < 4 || !isPowerOfTwo(size)) {
+    throw std::runtime_error("size of fft must be power of 2 and larger than 4.");
+  }
+  const double pi2 = 2.0 * M_PI;
+  // the stage with butterfly span h uses tw[h-1 .. 2h-1).
+  for (size_t h = 1; h < half; h *= 2) {
+    for (size_t j = 0; j < h; j++) {
+      const double phase = -pi2 * static_cast<double>(j) / static_cast<double>(2 * h);
+      tw_re[h - 1 + j] = std::cos(phase);
+      tw_im[h - 1 + j] = std::sin(phase);
+    }
+  }
+  for (size_t k = 0; k <= half; k++) {
+    const double phase = -pi2 * static_cast<double>(k) / static_cast<double>(size);
+    split_re[k] = std::cos(phase);
+    split_im[k] = std::sin(phase);
+  }
+  size_t bits = 0;
+  while ((size_t(1) << bits) < half) { bits++; }
+  for (size_t i = 0; i < half; i++) {
+    uint32_t r = 0;
+    for (size_t b = 0; b < bits; b++) { r |= ((i >> b) & 1U) << (bits - 1 - b); }
+    bitrev[i] = r;
+  }
+}
+
+size_t RealFFT::getBytes() const {
+  return getElementBytes(tw_re, tw_im, split_re, split_im, bitrev, work_re, work_im);
+}
+
+// in-place forward complex fft of size `half`. inverse fft is done by swapping re and im.
+void RealFFT::complexFFT(double* re, double* im) {
+  for (size_t i = 0; i < half; i++) {
+    const size_t j = bitrev[i];
+    if (i < j) {
+      std::swap(re[i], re[j]);
+      std::swap(im[i], im[j]);
+    }
+  }
+  for (size_t h = 1; h < half; h *= 2) {
+    const double* wr = &tw_re[h - 1];
+    const double* wi = &tw_im[h - 1];
+    for (size_t start = 0; start < half; start += 2 * h) {
+      double* ar = re + start;
+      double* ai = im + start;
+      double* br = ar + h;
+      double* bi = ai + h;
+      for (size_t j = 0; j < h; j++) {
+        const double tr = br[j] * wr[j] - bi[j] * wi[j];
+        const double ti = br[j] * wi[j] + bi[j] * wr[j];
+        br[j] = ar[j] - tr;
+        bi[j] = ai[j] - ti;
+        ar[j] += tr;
+        ai[j] += ti;
+      }
+    }
+  }
+}
+
+void RealFFT::forward(const double* input, double* re, double* im) {
+  // pack even samples into real part and odd samples into imaginary part.
+  for (size_t i = 0; i < half; i++) {
+    work_re[i] = input[2 * i];
+    work_im[i] = input[2 * i + 1];
+  }
+  complexFFT(work_re.data(), work_im.data());
+  work_re[half] = work_re[0];
+  work_im[half] = work_im[0];
+  for (size_t k = 0; k <= half; k++) {
+    const double zr = work_re[k];
+    const double zi = work_im[k];
+    const double cr = work_re[half - k];
+    const double ci = -work_im[half - k];
+    // even = (z + conj(z[M-k]))/2, odd = (z - conj(z[M-k]))/2i
+    const double er = 0.5 * (zr + cr);
+    const double ei = 0.5 * (zi + ci);
+    const double or_ = 0.5 * (zi - ci);
+    const double oi = -0.5 * (zr - cr);
+    re[k] = er + split_re[k] * or_ - split_im[k] * oi;
+    im[k] = ei + split_re[k] * oi + split_im[k] * or_;
+  }
+}
+
+void RealFFT::inverse(const double* re, const double* im, double* output) {
+  for (size_t k = 0; k < half; k++) {
+    const double xr = re[k];
+    const double xi = im[k];
+    const double cr = re[half - k];
+    const double ci = -im[half - k];
+    const double er = 0.5 * (xr + cr);
+    const double ei = 0.5 * (xi + ci);
+    // odd = (x - conj(x[M-k])) / (2 * w^k), 1/w^k == conj(w^k)
+    const double dr = 0.5 * (xr - cr);
+    const double di = 0.5 * (xi - ci);
+    const double or_ = dr * split_re[k] + di * split_im[k];
+    const double oi = di * split_re[k] - dr * split_im[k];
+    // z = even + i * odd, stored swapped for inverse transform
+    work_im[k] = er - oi;
+    work_re[k] = ei + or_;
+  }
+  complexFFT(work_re.data(), work_im.data());
+  const double scale = 1.0 / static_cast<double>(half);
+  for (size_t i = 0; i < half; i++) {
+    output[2 * i] = work_im[i] * scale;
+    output[2 * i + 1] = work_re[i] * scale;
+  }
+}
+
+}  // namespace mimium::builtin
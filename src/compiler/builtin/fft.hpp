@@ -0,0 +1,56 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "basic/helper_functions.hpp"
+
+namespace mimium::builtin {
+
+// Radix-2 FFT for real signals, used by block-based builtins such as convolution and STFT.
+// Spectra are kept as separate arrays of real and imaginary parts(structure of arrays) so that
+// butterflies and spectral products are vectorized by the compiler without ISA-specific code.
+class RealFFT {
+ public:
+  // size must be power of 2 and larger than or equal to 4.
+  explicit RealFFT(size_t size);
+  [[nodiscard]] size_t getSize() const { return size; }
+  [[nodiscard]] size_t getNumBins() const { return size / 2 + 1; }
+  // takes `size` samples and writes `size/2+1` bins.
+  void forward(const double* input, double* re, double* im);
+  // takes `size/2+1` bins and writes `size` samples. inverse(forward(x)) == x.
+  void inverse(const double* re, const double* im, double* output);
+
+  // size of the buffers, excluding the object itself, for memory reports.
+  [[nodiscard]] size_t getBytes() const;
+
+  static bool isPowerOfTwo(size_t n) { return n != 0 && (n & (n - 1)) == 0; }
+
+ private:
+  size_t size;
+  size_t half;
+  // twiddle factors of complex fft, stored contiguously for each stage.
+  AlignedVector<double> tw_re;
+  AlignedVector<double> tw_im;
+  // twiddle factors to split/merge spectrum of half-sized complex fft.
+  AlignedVector<double> split_re;
+  AlignedVector<double> split_im;
+  std::vector<uint32_t> bitrev;
+  AlignedVector<double> work_re;
+  AlignedVector<double> work_im;
+  void complexFFT(double* re, double* im);
+};
+
+// multiply-accumulate of complex spectra: acc += a * b
+inline void spectrumMulAdd(const double* a_re, const double* a_im, const double* b_re,
+                           const double* b_im, double* acc_re, double* acc_im, size_t bins) {
+  for (size_t k = 0; k < bins; k++) {
+    acc_re[k] += a_re[k] * b_re[k] - a_im[k] * b_im[k];
+    acc_im[k] += a_re[k] * b_im[k] + a_im[k] * b_re[k];
+  }
+}
+
+}  // namespace mimium::builtin
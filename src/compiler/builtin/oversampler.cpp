@@ -0,0 +1,138 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/builtin/oversampler.hpp"
+#include <array>
+#include <cmath>
+#include <sstream>
+#include "compiler/builtin/arrayops.hpp"
+
+namespace mimium::builtin {
+
+namespace {
+// zeroth order modified bessel function of the first kind, for kaiser window.
+double besselI0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 50; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < sum * 1e-17) { break; }
+  }
+  return sum;
+}
+// lowpass at the nyquist frequency of the original rate, normalized to unity gain at dc.
+AlignedVector<double> makeCoeffs(size_t factor) {
+  constexpr double beta = 8.0;
+  const size_t size = Oversampler::taps_per_phase * factor;
+  const double cutoff = 0.5 / static_cast<double>(factor);
+  const double center = static_cast<double>(size - 1) / 2.0;
+  AlignedVector<double> res(size);
+  double sum = 0.0;
+  for (size_t i = 0; i < size; i++) {
+    const double t = static_cast<double>(i) - center;
+    const double x = 2.0 * M_PI * cutoff * t;
+    const double sinc = t == 0.0 ? 1.0 : std::sin(x) / x;
+    const double r = t / center;
+    const double window = besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(beta);
+    res[i] = sinc * window;
+    sum += res[i];
+  }
+  for (auto& c : res) { c /= sum; }
+  return res;
+}
+const AlignedVector<double>& getCoeffs(size_t factor) {
+  static const std::array<AlignedVector<double>, 3> tables = {makeCoeffs(2), makeCoeffs(4),
+                                                              makeCoeffs(8)};
+  switch (factor) {
+    case 2: return tables[0];
+    case 4: return tables[1];
+    case 8: return tables[2];
+    default: throw std::runtime_error("oversampling factor must be 2, 4 or 8");
+  }
+}
+}  // namespace
+
+Oversampler::Oversampler(size_t factor, size_t id, double samplerate)
+    : factor(factor),
+      id(id),
+      samplerate(samplerate),
+      coeffs(getCoeffs(factor)),
+      phases(coeffs.size()),
+      uphistory(taps_per_phase * 2, 0.0),
+      downhistory(coeffs.size() * 2, 0.0),
+      frame(factor, 0.0) {
+  // phase k has coeffs[k + j*factor] for the input delayed by j, scaled to keep the dc gain.
+  for (size_t k = 0; k < factor; k++) {
+    for (size_t j = 0; j < taps_per_phase; j++) {
+      phases[k * taps_per_phase + j] = coeffs[k + j * factor] * static_cast<double>(factor);
+    }
+  }
+}
+
+size_t Oversampler::getBytes() const {
+  return getElementBytes(phases, uphistory, downhistory, frame);
+}
+
+Oversampler::~Oversampler() {
+  if (measured == 0) { return; }
+  const double period = 1e9 / samplerate;
+  const double time = getAverageTime();
+  std::ostringstream ss;
+  ss << "oversample #" << id << " (x" << factor << "): " << time << " ns per sample ("
+     << time / period * 100.0 << "% of a sample period), latency " << latency << " samples";
+  Logger::debug_log(ss.str(), Logger::WARNING);
+}
+
+double* Oversampler::skip() {
+  skipping = true;
+  return frame.data();
+}
+
+double* Oversampler::upsample(double input) {
+  if (calls % measure_interval == 0) {
+    measuring = true;
+    start = std::chrono::steady_clock::now();
+  }
+  uppos = (uppos + taps_per_phase - 1) % taps_per_phase;
+  uphistory[uppos] = input;
+  uphistory[uppos + taps_per_phase] = input;
+  const double* window = uphistory.data() + uppos;
+  for (size_t k = 0; k < factor; k++) {
+    frame[k] = array::dot(phases.data() + k * taps_per_phase, window, taps_per_phase);
+  }
+  return frame.data();
+}
+
+double Oversampler::downsample() {
+  if (skipping) {
+    skipping = false;
+    return 0.0;
+  }
+  const size_t size = coeffs.size();
+  for (size_t k = 0; k < factor; k++) {
+    downpos = (downpos + size - 1) % size;
+    downhistory[downpos] = frame[k];
+    downhistory[downpos + size] = frame[k];
+  }
+  const double res = array::dot(coeffs.data(), downhistory.data() + downpos, size);
+  if (measuring) {
+    const auto end = std::chrono::steady_clock::now();
+    elapsed += std::chrono::duration<double, std::nano>(end - start).count();
+    measured++;
+    measuring = false;
+  }
+  calls++;
+  return res;
+}
+
+double Oversampler::getAverageTime() const {
+  return measured > 0 ? elapsed / static_cast<double>(measured) : 0.0;
+}
+
+std::unique_ptr<Oversampler> createOversampler(Context& ctx, size_t factor) {
+  return std::make_unique<Oversampler>(factor, ctx.getStateCount(), ctx.getSampleRate());
+}
+
+}  // namespace mimium::builtin
@@ -0,0 +1,68 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <chrono>
+#include <memory>
+#include "basic/helper_functions.hpp"
+#include "compiler/builtin/context.hpp"
+
+namespace mimium::builtin {
+
+// Upsampler and downsampler around a function evaluated at `factor` times of the sample rate.
+// Both use a linear phase lowpass FIR(Kaiser windowed sinc) of `taps_per_phase * factor` taps,
+// evaluated in polyphase form so that only the nonzero inputs(upsampling) or the kept outputs
+// (downsampling) are computed. The time spent between upsample() and downsample() is sampled, and
+// reported through Logger when the oversampler is released with the runtime, off the audio thread.
+class Oversampler {
+ public:
+  static constexpr size_t taps_per_phase = 32;
+  // delay of the up and down filters in samples at the original rate. the filters delay by
+  // `taps_per_phase * factor - 1` samples at the higher rate, and the output is taken at the last
+  // of `factor` samples, which makes it a whole number of samples regardless of the factor.
+  // compensated by LookaheadResolver as the latency of stft.
+  static constexpr size_t latency = taps_per_phase - 1;
+  static constexpr size_t measure_interval = 64;
+
+  Oversampler(size_t factor, size_t id, double samplerate);
+  ~Oversampler();
+  Oversampler(Oversampler const&) = delete;
+  Oversampler& operator=(Oversampler const&) = delete;
+  [[nodiscard]] size_t getFactor() const { return factor; }
+  // returns `factor` samples at the higher rate, which are processed in place before downsample().
+  double* upsample(double input);
+  double downsample();
+  // used instead of upsample() while the runtime is preparing. the frame is left as is, and the
+  // following downsample() returns 0 without changing the filters.
+  double* skip();
+  // average time of a call in nanoseconds, 0 before the first measurement.
+  [[nodiscard]] double getAverageTime() const;
+  // excluding the coefficients shared between oversamplers of the same factor.
+  [[nodiscard]] size_t getBytes() const;
+
+ private:
+  size_t factor;
+  size_t id;
+  double samplerate;
+  const AlignedVector<double>& coeffs;
+  // polyphase components of the coefficients for upsampling.
+  AlignedVector<double> phases;
+  // histories are written twice so that the latest `size` samples are always contiguous.
+  AlignedVector<double> uphistory;
+  size_t uppos = 0;
+  AlignedVector<double> downhistory;
+  size_t downpos = 0;
+  AlignedVector<double> frame;
+
+  size_t calls = 0;
+  size_t measured = 0;
+  double elapsed = 0.0;
+  bool measuring = false;
+  bool skipping = false;
+  std::chrono::steady_clock::time_point start;
+};
+// factor must be 2, 4 or 8.
+std::unique_ptr<Oversampler> createOversampler(Context& ctx, size_t factor);
+
+}  // namespace mimium::builtin
@@ -0,0 +1,71 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/builtin/recurrence.hpp"
+#include <array>
+
+namespace mimium::builtin::recurrence {
+
+namespace {
+using Lanes = std::array<double, lanes>;
+// y[i] = sum(h[i-j]*u[j]) + c1[i]*y[-1] + c2[i]*y[-2] for i in a group.
+struct BlockCoeffs {
+  Lanes h{};
+  Lanes c1{};
+  Lanes c2{};
+};
+BlockCoeffs makeBlockCoeffs(double b1, double b2) {
+  BlockCoeffs res;
+  // impulse response, and the responses to the initial states.
+  double h1 = 1.0;
+  double h2 = 0.0;
+  double p1 = 1.0;
+  double p2 = 0.0;
+  double q1 = 0.0;
+  double q2 = 1.0;
+  res.h[0] = 1.0;
+  for (size_t i = 0; i < lanes; i++) {
+    if (i > 0) {
+      res.h[i] = b1 * h1 + b2 * h2;
+      h2 = h1;
+      h1 = res.h[i];
+    }
+    res.c1[i] = b1 * p1 + b2 * p2;
+    p2 = p1;
+    p1 = res.c1[i];
+    res.c2[i] = b1 * q1 + b2 * q2;
+    q2 = q1;
+    q1 = res.c2[i];
+  }
+  return res;
+}
+}  // namespace
+
+void firstOrder(const double* u, double* y, size_t n, double b1, double& y1) {
+  double y2 = 0.0;
+  secondOrder(u, y, n, b1, 0.0, y1, y2);
+}
+
+void secondOrder(const double* u, double* y, size_t n, double b1, double b2, double& y1,
+                 double& y2) {
+  const auto c = makeBlockCoeffs(b1, b2);
+  size_t i = 0;
+  for (; i + lanes <= n; i += lanes) {
+    Lanes acc;
+    for (size_t k = 0; k < lanes; k++) { acc[k] = c.c1[k] * y1 + c.c2[k] * y2; }
+    for (size_t j = 0; j < lanes; j++) {
+      for (size_t k = j; k < lanes; k++) { acc[k] += c.h[k - j] * u[i + j]; }
+    }
+    for (size_t k = 0; k < lanes; k++) { y[i + k] = acc[k]; }
+    y2 = acc[lanes - 2];
+    y1 = acc[lanes - 1];
+  }
+  for (; i < n; i++) {
+    y[i] = u[i] + b1 * y1 + b2 * y2;
+    y2 = y1;
+    y1 = y[i];
+  }
+}
+
+}  // namespace mimium::builtin::recurrence
@@ -0,0 +1,23 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstddef>
+
+namespace mimium::builtin {
+
+// Block evaluation of linear recurrences `y[n] = u[n] + b1*y[n-1] + b2*y[n-2]` with coefficients
+// constant over the block. Each group of `lanes` outputs is computed at once from the inputs and
+// the last two outputs in state-space form, so that the serial dependency is only between groups
+// and the products inside a group are computed in vector lanes.
+namespace recurrence {
+inline constexpr size_t lanes = 4;
+// y1 holds the output before the block and is updated to the last output.
+void firstOrder(const double* u, double* y, size_t n, double b1, double& y1);
+// y1 and y2 hold y[-1] and y[-2], and they are updated to the last two outputs.
+void secondOrder(const double* u, double* y, size_t n, double b1, double b2, double& y1,
+                 double& y2);
+}  // namespace recurrence
+
+}  // namespace mimium::builtin
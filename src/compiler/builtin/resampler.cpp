@@ -0,0 +1,129 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/builtin/resampler.hpp"
+#include <cmath>
+
+namespace mimium::builtin {
+
+namespace {
+// modified Bessel function of the first kind, order 0.
+double besselI0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 50; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < sum * 1e-17) { break; }
+  }
+  return sum;
+}
+}  // namespace
+
+SincKernel::SincKernel(size_t taps, double beta, double cutoff)
+    : taps(taps), half(taps / 2), table((num_phases + 1) * taps), dense(taps * num_phases + 1) {
+  const double i0beta = besselI0(beta);
+  const auto h = [&](double t) {
+    const double x = t / static_cast<double>(half);
+    if (std::abs(x) >= 1.0) { return 0.0; }
+    const double w = besselI0(beta * std::sqrt(1.0 - x * x)) / i0beta;
+    const double arg = M_PI * cutoff * t;
+    const double sinc = (t == 0.0) ? 1.0 : std::sin(arg) / arg;
+    return cutoff * sinc * w;
+  };
+  // row p is for fractional offset p/num_phases, coefficient j multiplies src[i - half + 1 + j].
+  for (size_t p = 0; p <= num_phases; p++) {
+    const double frac = static_cast<double>(p) / num_phases;
+    for (size_t j = 0; j < taps; j++) {
+      table[p * taps + j] = h(frac + static_cast<double>(half) - 1.0 - static_cast<double>(j));
+    }
+  }
+  for (size_t u = 0; u < dense.size(); u++) {
+    dense[u] = h(static_cast<double>(u) / num_phases - static_cast<double>(half));
+  }
+}
+
+const SincKernel& SincKernel::get(ResampleQuality quality) {
+  static const SincKernel fast(8, 5.0, 0.85);
+  static const SincKernel medium(16, 7.0, 0.9);
+  static const SincKernel high(32, 8.6, 0.94);
+  static const SincKernel best(64, 10.0, 0.97);
+  switch (quality) {
+    case ResampleQuality::Fast: return fast;
+    case ResampleQuality::Medium: return medium;
+    case ResampleQuality::High: return high;
+    case ResampleQuality::Best: return best;
+  }
+  return high;
+}
+
+double SincKernel::read(const double* src, size_t size, double pos, double speed) const {
+  if (speed > 1.0) { return readStretched(src, size, pos, std::min(speed, max_speed)); }
+  return readPolyphase(src, size, pos);
+}
+
+double SincKernel::readPolyphase(const double* src, size_t size, double pos) const {
+  const double ipos = std::floor(pos);
+  const double phase = (pos - ipos) * num_phases;
+  const auto row = static_cast<size_t>(phase);
+  const double blend = phase - static_cast<double>(row);
+  const double* c0 = &table[row * taps];
+  const double* c1 = c0 + taps;
+  const auto start = static_cast<int64_t>(ipos) - static_cast<int64_t>(half) + 1;
+  const auto isize = static_cast<int64_t>(size);
+  double res = 0.0;
+  if (start >= 0 && start + static_cast<int64_t>(taps) <= isize) {
+    const double* s = src + start;
+    for (size_t j = 0; j < taps; j++) { res += s[j] * (c0[j] + blend * (c1[j] - c0[j])); }
+    return res;
+  }
+  for (size_t j = 0; j < taps; j++) {
+    const int64_t idx = start + static_cast<int64_t>(j);
+    if (idx >= 0 && idx < isize) { res += src[idx] * (c0[j] + blend * (c1[j] - c0[j])); }
+  }
+  return res;
+}
+
+double SincKernel::denseAt(double t) const {
+  const double u = (t + static_cast<double>(half)) * num_phases;
+  if (u <= 0.0 || u >= static_cast<double>(dense.size() - 1)) { return 0.0; }
+  const auto idx = static_cast<size_t>(u);
+  const double frac = u - static_cast<double>(idx);
+  return dense[idx] + frac * (dense[idx + 1] - dense[idx]);
+}
+
+double SincKernel::readStretched(const double* src, size_t size, double pos, double speed) const {
+  const double scale = 1.0 / speed;
+  const double width = static_cast<double>(half) * speed;
+  const auto first = static_cast<int64_t>(std::max(0.0, std::ceil(pos - width)));
+  const auto last = std::min(static_cast<int64_t>(size) - 1,
+                             static_cast<int64_t>(std::floor(pos + width)));
+  double res = 0.0;
+  for (int64_t k = first; k <= last; k++) {
+    res += src[k] * denseAt((pos - static_cast<double>(k)) * scale);
+  }
+  return res * scale;
+}
+
+size_t getResampledSize(size_t frames, double ratio) {
+  return static_cast<size_t>(std::ceil(static_cast<double>(frames) * ratio));
+}
+
+AlignedVector<double> resample(const double* src, size_t frames, size_t channels, double ratio,
+                               ResampleQuality quality) {
+  const auto& kernel = SincKernel::get(quality);
+  const size_t newframes = getResampledSize(frames, ratio);
+  AlignedVector<double> res(newframes * channels);
+  AlignedVector<double> channel(frames);
+  const double step = 1.0 / ratio;
+  for (size_t ch = 0; ch < channels; ch++) {
+    for (size_t i = 0; i < frames; i++) { channel[i] = src[i * channels + ch]; }
+    for (size_t i = 0; i < newframes; i++) {
+      res[i * channels + ch] = kernel.read(channel.data(), frames, i * step, step);
+    }
+  }
+  return res;
+}
+
+}  // namespace mimium::builtin
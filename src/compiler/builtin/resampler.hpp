@@ -0,0 +1,44 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include "basic/helper_functions.hpp"
+
+namespace mimium::builtin {
+
+enum class ResampleQuality { Fast = 0, Medium, High, Best };
+
+// Kaiser-windowed sinc interpolation kernel tabulated in polyphase form.
+// Tables are generated once for each quality and shared read-only.
+class SincKernel {
+ public:
+  static const SincKernel& get(ResampleQuality quality);
+  [[nodiscard]] size_t getTaps() const { return taps; }
+  // interpolated value of src at fractional position pos. samples outside of src are 0.
+  // speed(> 1) lowers the cutoff frequency to avoid aliasing on faster playback.
+  double read(const double* src, size_t size, double pos, double speed = 1.0) const;
+
+  static constexpr size_t num_phases = 256;
+  static constexpr double max_speed = 8.0;
+
+ private:
+  SincKernel(size_t taps, double beta, double cutoff);
+  size_t taps;
+  size_t half;
+  // polyphase table, (num_phases + 1) rows of `taps` coefficients.
+  AlignedVector<double> table;
+  // kernel sampled densely from -half to half, for the stretched kernel.
+  AlignedVector<double> dense;
+  double readPolyphase(const double* src, size_t size, double pos) const;
+  double readStretched(const double* src, size_t size, double pos, double speed) const;
+  [[nodiscard]] double denseAt(double t) const;
+};
+
+// converts interleaved samples to a new rate. ratio = target rate / source rate.
+AlignedVector<double> resample(const double* src, size_t frames, size_t channels, double ratio,
+                               ResampleQuality quality);
+// number of frames after resample()
+size_t getResampledSize(size_t frames, double ratio);
+
+}  // namespace mimium::builtin
@@ -0,0 +1,67 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/builtin/samplepool.hpp"
+#include <map>
+#include "compiler/builtin/resampler.hpp"
+#include "sndfile.h"
+
+namespace mimium::builtin {
+
+namespace {
+std::mutex pool_mtx;
+// std::map does not move the elements so references to them are kept valid.
+std::map<std::pair<std::string, double>, SampleData> pool;
+
+SampleData loadFile(std::string const& filename) {
+  SampleData res;
+  SF_INFO sfinfo;
+  auto* sfile = sf_open(filename.c_str(), SFM_READ, &sfinfo);
+  if (sfile == nullptr) {
+    Logger::debug_log("failed to load " + filename + " : " + sf_strerror(sfile), Logger::ERROR_);
+    res.data.resize(1, 0.0);
+    return res;
+  }
+  res.frames = sfinfo.frames;
+  res.channels = sfinfo.channels;
+  res.samplerate = sfinfo.samplerate;
+  res.data.resize(std::max<size_t>(res.frames * res.channels, 1), 0.0);
+  sf_readf_double(sfile, res.data.data(), sfinfo.frames);
+  sf_close(sfile);
+  return res;
+}
+}  // namespace
+
+const SampleData& SamplePool::load(std::string const& filename) {
+  std::lock_guard<std::mutex> lock(pool_mtx);
+  auto iter = pool.find({filename, 0.0});
+  if (iter == pool.end()) { iter = pool.emplace(std::pair(filename, 0.0), loadFile(filename)).first; }
+  return iter->second;
+}
+
+const SampleData& SamplePool::loadResampled(std::string const& filename, double samplerate) {
+  const auto& src = load(filename);
+  if (src.frames == 0 || src.samplerate == samplerate) { return src; }
+  std::lock_guard<std::mutex> lock(pool_mtx);
+  auto iter = pool.find({filename, samplerate});
+  if (iter == pool.end()) {
+    const double ratio = samplerate / src.samplerate;
+    SampleData res;
+    res.data = resample(src.data.data(), src.frames, src.channels, ratio, ResampleQuality::Best);
+    res.frames = getResampledSize(src.frames, ratio);
+    res.channels = src.channels;
+    res.samplerate = samplerate;
+    iter = pool.emplace(std::pair(filename, samplerate), std::move(res)).first;
+  }
+  return iter->second;
+}
+
+size_t SamplePool::getLoadedBytes() {
+  std::lock_guard<std::mutex> lock(pool_mtx);
+  size_t res = 0;
+  for (const auto& [key, sample] : pool) { res += sample.data.size() * sizeof(double); }
+  return res;
+}
+
+}  // namespace mimium::builtin
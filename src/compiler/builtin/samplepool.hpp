@@ -0,0 +1,31 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <string>
+#include "basic/helper_functions.hpp"
+
+namespace mimium::builtin {
+
+struct SampleData {
+  // interleaved samples. it has at least 1 element even if the file could not be loaded.
+  AlignedVector<double> data;
+  size_t frames = 0;
+  size_t channels = 1;
+  double samplerate = 0;
+};
+
+// Audio files loaded by builtin functions. Each file(and each converted sample rate) is loaded
+// only once and kept during the lifetime of the process. The samples are shared by runtimes and
+// must not be modified: programs get copies of them(see loadwav).
+class SamplePool {
+ public:
+  static const SampleData& load(std::string const& filename);
+  // loads file converted to `samplerate` with the best quality of the resampler.
+  static const SampleData& loadResampled(std::string const& filename, double samplerate);
+  // total size of the samples loaded so far.
+  static size_t getLoadedBytes();
+};
+
+}  // namespace mimium::builtin
@@ -0,0 +1,82 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/builtin/sos.hpp"
+#include <cmath>
+
+namespace mimium::builtin {
+
+namespace sos {
+
+void smoothCoeffs(double* current, const double* target, size_t num, double& factor,
+                  double samplerate) {
+  if (factor == 0.0) {
+    std::copy(target, target + num, current);
+    factor = 1.0 - std::exp(-1.0 / (smoothing_time * samplerate));
+    return;
+  }
+  for (size_t i = 0; i < num; i++) { current[i] += factor * (target[i] - current[i]); }
+}
+
+double process(double input, const double* coeffs, size_t nsections, double* state,
+               double samplerate) {
+  nsections = std::min(nsections, max_sections);
+  double* current = state + coeffs_offset;
+  double* z = state + z_offset;
+  smoothCoeffs(current, coeffs, nsections * coeffs_per_section, state[0], samplerate);
+  double x = input;
+  for (size_t s = 0; s < nsections; s++) {
+    const double* c = current + s * coeffs_per_section;
+    double& z1 = z[s * 2];
+    double& z2 = z[s * 2 + 1];
+    const double y = c[0] * x + z1;
+    z1 = c[1] * x - c[3] * y + z2;
+    z2 = c[2] * x - c[4] * y;
+    x = y;
+  }
+  return x;
+}
+
+}  // namespace sos
+
+SosFilter::SosFilter(size_t channels, double samplerate)
+    : channels(channels),
+      samplerate(samplerate),
+      z1(channels * sos::max_sections, 0.0),
+      z2(channels * sos::max_sections, 0.0),
+      frame(channels, 0.0) {}
+
+size_t SosFilter::getBytes() const { return getElementBytes(z1, z2, frame); }
+
+const double* SosFilter::process(const double* input, const double* coeffs, size_t nsections) {
+  nsections = std::min(nsections, sos::max_sections);
+  sos::smoothCoeffs(current.data(), coeffs, nsections * sos::coeffs_per_section, factor,
+                    samplerate);
+  std::copy(input, input + channels, frame.begin());
+  double* x = frame.data();
+  for (size_t s = 0; s < nsections; s++) {
+    const double* c = current.data() + s * sos::coeffs_per_section;
+    const double b0 = c[0];
+    const double b1 = c[1];
+    const double b2 = c[2];
+    const double a1 = c[3];
+    const double a2 = c[4];
+    double* __restrict s1 = z1.data() + s * channels;
+    double* __restrict s2 = z2.data() + s * channels;
+    // independent for each channel, vectorized across channels.
+    for (size_t ch = 0; ch < channels; ch++) {
+      const double y = b0 * x[ch] + s1[ch];
+      s1[ch] = b1 * x[ch] - a1 * y + s2[ch];
+      s2[ch] = b2 * x[ch] - a2 * y;
+      x[ch] = y;
+    }
+  }
+  return frame.data();
+}
+
+std::unique_ptr<SosFilter> createSosFilter(size_t channels, double samplerate) {
+  return std::make_unique<SosFilter>(std::max<size_t>(channels, 1), samplerate);
+}
+
+}  // namespace mimium::builtin
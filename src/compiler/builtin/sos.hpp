@@ -0,0 +1,60 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <array>
+#include <memory>
+#include "basic/helper_functions.hpp"
+
+namespace mimium::builtin {
+
+// Cascade of second-order sections in transposed direct form II.
+// Coefficients are given as `b0,b1,b2,a1,a2` for each section(a0 is normalized to 1), and they are
+// smoothed toward the given values with a one-pole filter so that they can be modulated.
+namespace sos {
+inline constexpr size_t max_sections = 8;
+inline constexpr size_t coeffs_per_section = 5;
+// smoothing time of the coefficients in seconds.
+inline constexpr double smoothing_time = 0.005;
+
+// layout of the flat state used by the single channel builtin:
+// [smoothing factor(0 before the first call), smoothed coefficients(5 * max_sections), z1 and z2
+// (2 * max_sections)]
+inline constexpr size_t coeffs_offset = 1;
+inline constexpr size_t z_offset = coeffs_offset + coeffs_per_section * max_sections;
+inline constexpr size_t state_size = z_offset + 2 * max_sections;
+
+// moves current coefficients toward target. they jump to target at the first call, where the
+// factor of the one-pole filter is computed from the sample rate.
+void smoothCoeffs(double* current, const double* target, size_t num, double& factor,
+                  double samplerate);
+// single channel, using the flat state above.
+double process(double input, const double* coeffs, size_t nsections, double* state,
+               double samplerate);
+}  // namespace sos
+
+// Multichannel version. All channels share the same coefficients, and the states are laid out
+// with channels innermost so that channels are processed in vector lanes.
+class SosFilter {
+ public:
+  SosFilter(size_t channels, double samplerate);
+  [[nodiscard]] size_t getChannels() const { return channels; }
+  // processes one frame of `channels` samples and returns the output frame, which is valid until
+  // the next call.
+  const double* process(const double* input, const double* coeffs, size_t nsections);
+  [[nodiscard]] const double* getFrame() const { return frame.data(); }
+  [[nodiscard]] size_t getBytes() const;
+
+ private:
+  size_t channels;
+  double samplerate;
+  double factor = 0.0;
+  std::array<double, sos::coeffs_per_section * sos::max_sections> current{};
+  AlignedVector<double> z1;
+  AlignedVector<double> z2;
+  AlignedVector<double> frame;
+};
+std::unique_ptr<SosFilter> createSosFilter(size_t channels, double samplerate);
+
+}  // namespace mimium::builtin
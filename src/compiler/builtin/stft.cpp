@@ -0,0 +1,107 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/builtin/stft.hpp"
+#include <cmath>
+
+namespace mimium::builtin {
+
+AlignedVector<double> makeWindow(WindowType type, size_t size) {
+  AlignedVector<double> res(size);
+  const double n = static_cast<double>(size);
+  for (size_t i = 0; i < size; i++) {
+    const double x = 2.0 * M_PI * static_cast<double>(i) / n;
+    switch (type) {
+      case WindowType::Hann: res[i] = 0.5 - 0.5 * std::cos(x); break;
+      case WindowType::Hamming: res[i] = 0.54 - 0.46 * std::cos(x); break;
+      case WindowType::Blackman:
+        res[i] = 0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x);
+        break;
+      case WindowType::Rectangular: res[i] = 1.0; break;
+    }
+  }
+  return res;
+}
+
+Stft::Stft(size_t fftsize, size_t hop, WindowType window)
+    : fftsize(fftsize),
+      hop(hop),
+      fft(fftsize),
+      window(makeWindow(window, fftsize)),
+      synth_window(fftsize),
+      input_buf(fftsize * 2, 0.0),
+      output_buf(fftsize, 0.0),
+      frame(fftsize),
+      re(fftsize / 2 + 1),
+      im(fftsize / 2 + 1),
+      mag(fftsize / 2 + 1),
+      phase(fftsize / 2 + 1) {
+  AlignedVector<double> norm(hop, 0.0);
+  for (size_t i = 0; i < fftsize; i++) { norm[i % hop] += this->window[i] * this->window[i]; }
+  for (size_t i = 0; i < fftsize; i++) {
+    const double n = norm[i % hop];
+    synth_window[i] = n > 1e-9 ? this->window[i] / n : 0.0;
+  }
+}
+
+size_t Stft::getBytes() const {
+  return fft.getBytes() + getElementBytes(window, synth_window, input_buf, output_buf, frame, re,
+                                          im, mag, phase);
+}
+
+double Stft::process(double input, SpectralFn fn) {
+  input_buf[input_pos] = input;
+  input_buf[input_pos + fftsize] = input;
+  input_pos = (input_pos + 1) % fftsize;
+  const double res = output_buf[output_pos];
+  output_buf[output_pos] = 0.0;
+  output_pos = (output_pos + 1) % fftsize;
+  if (++hop_count == hop) {
+    processFrame(fn);
+    hop_count = 0;
+  }
+  return res;
+}
+
+void Stft::processFrame(SpectralFn fn) {
+  // last `fftsize` samples from the oldest.
+  const double* last = &input_buf[input_pos];
+  for (size_t i = 0; i < fftsize; i++) { frame[i] = last[i] * window[i]; }
+  fft.forward(frame.data(), re.data(), im.data());
+  const size_t bins = fft.getNumBins();
+  for (size_t k = 0; k < bins; k++) {
+    mag[k] = std::hypot(re[k], im[k]);
+    phase[k] = std::atan2(im[k], re[k]);
+  }
+  fn(mag.data(), phase.data(), static_cast<double>(bins));
+  for (size_t k = 0; k < bins; k++) {
+    re[k] = mag[k] * std::cos(phase[k]);
+    im[k] = mag[k] * std::sin(phase[k]);
+  }
+  fft.inverse(re.data(), im.data(), frame.data());
+  // the frame is output from the next sample.
+  for (size_t i = 0; i < fftsize; i++) {
+    output_buf[(output_pos + i) % fftsize] += frame[i] * synth_window[i];
+  }
+}
+
+size_t Stft::getFftSize(double fftsize) {
+  size_t size = 4;
+  while (static_cast<double>(size) < fftsize) { size *= 2; }
+  return size;
+}
+
+std::unique_ptr<Stft> createStft(double fftsize, double hop, double window) {
+  const size_t size = Stft::getFftSize(fftsize);
+  if (static_cast<double>(size) != fftsize) {
+    Logger::debug_log("fft size of stft must be power of 2, using " + std::to_string(size),
+                      Logger::WARNING);
+  }
+  auto hopsize = static_cast<size_t>(std::clamp(hop, 1.0, static_cast<double>(size)));
+  auto wtype = static_cast<WindowType>(
+      std::clamp(static_cast<int>(window), 0, static_cast<int>(WindowType::Rectangular)));
+  return std::make_unique<Stft>(size, hopsize, wtype);
+}
+
+}  // namespace mimium::builtin
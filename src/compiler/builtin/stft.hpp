@@ -0,0 +1,53 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include "compiler/builtin/fft.hpp"
+
+namespace mimium::builtin {
+
+enum class WindowType { Hann = 0, Hamming, Blackman, Rectangular };
+// periodic window function for overlap-add.
+AlignedVector<double> makeWindow(WindowType type, size_t size);
+
+// callback for each spectral frame: (magnitudes, phases, number of bins). both arrays are
+// modified in place and resynthesized.
+using SpectralFn = void (*)(double*, double*, double);
+
+// Short-time Fourier analysis and overlap-add resynthesis running sample by sample.
+// A spectral frame is computed at every `hop` samples, and the output is delayed by `fftsize`
+// samples(see getLatency()).
+class Stft {
+ public:
+  Stft(size_t fftsize, size_t hop, WindowType window);
+  double process(double input, SpectralFn fn);
+  [[nodiscard]] size_t getLatency() const { return fftsize; }
+  // fft size used for the requested one, the next power of 2 from 4.
+  static size_t getFftSize(double fftsize);
+  [[nodiscard]] size_t getBytes() const;
+
+ private:
+  size_t fftsize;
+  size_t hop;
+  RealFFT fft;
+  AlignedVector<double> window;
+  // window for resynthesis, normalized by the sum of squared windows overlapped.
+  AlignedVector<double> synth_window;
+  AlignedVector<double> input_buf;  // written twice to read the last frame contiguously
+  AlignedVector<double> output_buf;
+  AlignedVector<double> frame;
+  AlignedVector<double> re;
+  AlignedVector<double> im;
+  AlignedVector<double> mag;
+  AlignedVector<double> phase;
+  size_t input_pos = 0;
+  size_t output_pos = 0;
+  size_t hop_count = 0;
+  void processFrame(SpectralFn fn);
+};
+
+// Invalid parameters are corrected with warnings.
+std::unique_ptr<Stft> createStft(double fftsize, double hop, double window);
+
+}  // namespace mimium::builtin
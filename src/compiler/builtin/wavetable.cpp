@@ -0,0 +1,133 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/builtin/wavetable.hpp"
+#include <cmath>
+#include "compiler/builtin/fft.hpp"
+
+namespace mimium::builtin {
+
+namespace {
+constexpr size_t num_bins = MipMappedTable::table_size / 2 + 1;
+
+// spectrum of a sum of sines, amplitude(k) for k-th harmonic.
+template <typename F>
+MipMappedTable makeAdditive(F&& amplitude) {
+  std::vector<double> re(num_bins, 0.0);
+  std::vector<double> im(num_bins, 0.0);
+  const double scale = static_cast<double>(MipMappedTable::table_size) / 2.0;
+  for (size_t k = 1; k <= MipMappedTable::max_harmonics; k++) {
+    im[k] = -amplitude(static_cast<double>(k)) * scale;
+  }
+  return MipMappedTable(re.data(), im.data());
+}
+}  // namespace
+
+MipMappedTable::MipMappedTable(const double* re, const double* im) {
+  RealFFT fft(table_size);
+  std::vector<double> band_re(num_bins);
+  std::vector<double> band_im(num_bins);
+  for (size_t level = 0; level < num_levels; level++) {
+    const size_t limit = max_harmonics >> level;
+    for (size_t k = 0; k < num_bins; k++) {
+      band_re[k] = k <= limit ? re[k] : 0.0;
+      band_im[k] = k <= limit ? im[k] : 0.0;
+    }
+    auto& table = levels[level];
+    table.resize(table_size + 1);
+    fft.inverse(band_re.data(), band_im.data(), table.data());
+    table[table_size] = table[0];
+  }
+}
+
+size_t MipMappedTable::getBytes() const {
+  size_t res = 0;
+  for (const auto& level : levels) { res += getElementBytes(level); }
+  return res;
+}
+
+MipMappedTable MipMappedTable::fromWaveform(Waveform waveform) {
+  switch (waveform) {
+    case Waveform::Square:
+      return makeAdditive(
+          [](double k) { return std::fmod(k, 2.0) == 1.0 ? 4.0 / (M_PI * k) : 0.0; });
+    case Waveform::Triangle:
+      return makeAdditive([](double k) {
+        if (std::fmod(k, 2.0) == 0.0) { return 0.0; }
+        const double sign = std::fmod(k, 4.0) == 1.0 ? 1.0 : -1.0;
+        return sign * 8.0 / (M_PI * M_PI * k * k);
+      });
+    case Waveform::Saw:
+    default:
+      return makeAdditive(
+          [](double k) { return (std::fmod(k, 2.0) == 1.0 ? 2.0 : -2.0) / (M_PI * k); });
+  }
+}
+
+MipMappedTable MipMappedTable::fromArray(const double* array, size_t size) {
+  // fit the cycle into table_size samples with linear interpolation, then take its spectrum.
+  std::vector<double> cycle(table_size, 0.0);
+  if (size > 0) {
+    for (size_t i = 0; i < table_size; i++) {
+      const double pos = static_cast<double>(i) * size / table_size;
+      const auto idx = static_cast<size_t>(pos);
+      const double frac = pos - static_cast<double>(idx);
+      cycle[i] = array[idx] + frac * (array[(idx + 1) % size] - array[idx]);
+    }
+  }
+  RealFFT fft(table_size);
+  std::vector<double> re(num_bins);
+  std::vector<double> im(num_bins);
+  fft.forward(cycle.data(), re.data(), im.data());
+  return MipMappedTable(re.data(), im.data());
+}
+
+size_t MipMappedTable::getLevel(double increment) {
+  // the highest harmonic of level l must stay below nyquist: (max_harmonics >> l) * inc < 0.5
+  const double inc = std::abs(increment);
+  if (inc * max_harmonics < 0.5) { return 0; }
+  const auto level = static_cast<size_t>(std::ceil(std::log2(inc * max_harmonics * 2.0)));
+  return std::min(level, num_levels - 1);
+}
+
+double MipMappedTable::read(double phase, double increment) const {
+  const double* table = levels[getLevel(increment)].data();
+  const double pos = phase * table_size;
+  const auto idx = std::min(static_cast<size_t>(pos), table_size - 1);
+  const double frac = pos - static_cast<double>(idx);
+  return table[idx] + frac * (table[idx + 1] - table[idx]);
+}
+
+double processOscillator(MipMappedTable const& table, double increment, double& phase) {
+  // wrap with floor to allow negative frequencies.
+  const double res = table.read(phase, increment);
+  phase += increment;
+  phase -= std::floor(phase);
+  return res;
+}
+
+std::shared_ptr<const MipMappedTable> MipMappedTable::get(Waveform waveform) {
+  // built once on first use and shared by every runtime, as they do not depend on the sample rate.
+  static const std::array<std::shared_ptr<const MipMappedTable>, 3> tables = {
+      std::make_shared<const MipMappedTable>(fromWaveform(Waveform::Saw)),
+      std::make_shared<const MipMappedTable>(fromWaveform(Waveform::Square)),
+      std::make_shared<const MipMappedTable>(fromWaveform(Waveform::Triangle))};
+  return tables[static_cast<size_t>(waveform)];
+}
+
+std::unique_ptr<WavetableOscillator> createOscillator(Context& /*ctx*/, Waveform waveform) {
+  return std::make_unique<WavetableOscillator>(
+      WavetableOscillator{MipMappedTable::get(waveform), 0.0});
+}
+
+std::unique_ptr<WavetableOscillator> createOscillator(Context& ctx, const double* array,
+                                                      size_t size) {
+  size = ctx.clampSize(array, size);
+  auto table = ctx.getCached<MipMappedTable>("wavetable", array, size, [&]() {
+    return std::make_unique<MipMappedTable>(MipMappedTable::fromArray(array, size));
+  });
+  return std::make_unique<WavetableOscillator>(WavetableOscillator{std::move(table), 0.0});
+}
+
+}  // namespace mimium::builtin
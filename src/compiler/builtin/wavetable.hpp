@@ -0,0 +1,64 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <array>
+#include <memory>
+#include "basic/helper_functions.hpp"
+#include "compiler/builtin/context.hpp"
+
+namespace mimium::builtin {
+
+enum class Waveform { Saw = 0, Square, Triangle };
+
+// Single-cycle wavetable band-limited for each octave(mip-map). Level l contains harmonics up to
+// max_harmonics >> l, and read() picks the richest level which does not alias at the given
+// frequency. Tables are immutable after construction and shared by oscillators.
+class MipMappedTable {
+ public:
+  static constexpr size_t table_size = 2048;
+  static constexpr size_t max_harmonics = 512;
+  static constexpr size_t num_levels = 10;
+  // from a spectrum of `table_size/2+1` bins in the same form as RealFFT::forward.
+  MipMappedTable(const double* re, const double* im);
+
+  // table of a classic waveform.
+  static MipMappedTable fromWaveform(Waveform waveform);
+  // process-wide table of a classic waveform, shared by all runtimes.
+  static std::shared_ptr<const MipMappedTable> get(Waveform waveform);
+  // table from an arbitrary single cycle.
+  static MipMappedTable fromArray(const double* array, size_t size);
+
+  // phase in [0,1), increment is frequency in cycles per sample.
+  [[nodiscard]] double read(double phase, double increment) const;
+  [[nodiscard]] static size_t getLevel(double increment);
+  [[nodiscard]] const double* getTable(size_t level) const { return levels[level].data(); }
+  [[nodiscard]] size_t getBytes() const;
+
+ private:
+  // each level has one extra sample at the end for interpolation without wrapping.
+  std::array<AlignedVector<double>, num_levels> levels;
+};
+
+// one step of an oscillator: returns the value at `phase` and advances it by increment(frequency
+// in cycles per sample).
+double processOscillator(MipMappedTable const& table, double increment, double& phase);
+
+// state of an oscillator. only the phase is owned by each instance.
+struct WavetableOscillator {
+  std::shared_ptr<const MipMappedTable> table;
+  double phase = 0.0;
+  double process(double freq, double samplerate) {
+    return processOscillator(*table, freq / samplerate, phase);
+  }
+  // the table is shared with other instances.
+  [[nodiscard]] size_t getBytes() const { return 0; }
+};
+// tables of classic waveforms are shared by the process, tables from arrays are cached in the
+// context by the contents of the array.
+std::unique_ptr<WavetableOscillator> createOscillator(Context& ctx, Waveform waveform);
+std::unique_ptr<WavetableOscillator> createOscillator(Context& ctx, const double* array,
+                                                      size_t size);
+
+}  // namespace mimium::builtin
@@ -7,6 +7,7 @@
 #include "compiler/codegen/typeconverter.hpp"
 #include "compiler/collect_memoryobjs.hpp"
 #include "compiler/ffi.hpp"
+#include "runtime/runtime_defs.hpp"
 
 namespace mimium {
 using OpId = ast::OpId;
@@ -120,11 +121,12 @@ llvm::Value* CodeGenVisitor::getLlvmValForFcallArgs(mir::valueptr mirval) {
 }
 
 std::vector<llvm::Value*> CodeGenVisitor::makeFcallArgs(llvm::Type* ft,
-                                                        std::list<mir::valueptr> const& args) {
+                                                        std::list<mir::valueptr> const& args,
+                                                        unsigned int param_offset) {
   auto* functiontype = llvm::cast<llvm::FunctionType>(
       ft->isPointerTy() ? llvm::cast<llvm::PointerType>(ft)->getElementType() : ft);
   std::vector<llvm::Value*> res;
-  const auto* ft_iter = functiontype->params().begin();
+  const auto* ft_iter = std::next(functiontype->params().begin(), param_offset);
   for (const auto& a : args) {
     auto* targettype = *ft_iter;
     auto callargtype = mir::getType(*a);
@@ -152,6 +154,7 @@ llvm::Value* CodeGenVisitor::createAllocation(bool isglobal, llvm::Type* type,
     llvm::Type* t = type;
     auto rawname = "ptr_" + name.str() + "_raw";
     auto size = G.module->getDataLayout().getTypeAllocSize(t);
+    G.memory_report.addHeap(size);
     const int bitsize = 64;
     auto* sizeinst = llvm::ConstantInt::get(G.ctx, llvm::APInt(bitsize, size, false));
     auto* rawres = G.builder->CreateCall(G.module->getFunction("mimium_malloc"),
@@ -241,26 +244,39 @@ llvm::Value* CodeGenVisitor::operator()(minst::Function& i) {
   mirfv_to_llvm.clear();
   memobj_to_llvm.clear();
   assert(memobjqueue.empty());
+  idle_context = std::nullopt;
+  // functions without memory objects are not in the map, and must not see self of the previous one.
+  context_hasself = false;
   bool hascapture = !i.freevariables.empty();
 
   auto fobjtree = funobj_map->find(getValPtr(&i));
   bool hasmemobj = false;
   if (fobjtree != funobj_map->end()) {
     context_hasself = fobjtree->second->hasself;
-    hasmemobj = !fobjtree->second->memobjs.empty() || context_hasself;
+    hasmemobj = !fobjtree->second->memobjs.empty() || context_hasself || fobjtree->second->idle;
   }
   bool isdsp = i.name == "dsp";
   if (isdsp) { G.checkDspFunctionType(i); }
   auto* ft = !isdsp ? createFunctionType(i) : createDspFnType(i, hascapture, hasmemobj);
   auto* f = createFunction(ft, i);
+  if (isdsp) {
+    // output and input buffers given by the audio driver never overlap each other.
+    const unsigned int numbuffers = i.args.ret_ptr ? 2 : 1;
+    for (unsigned int idx = 0; idx < numbuffers; idx++) {
+      f->addParamAttr(idx, llvm::Attribute::NoAlias);
+      f->addParamAttr(idx, llvm::Attribute::NoCapture);
+    }
+  }
   recursivefn_ptr = &i;
   G.curfunc = f;
   G.createNewBasicBlock("entry", f);
   addArgstoMap(f, i, hascapture, hasmemobj);
+  if (idle_context) { createIdleCheck(i, f); }
 
   for (auto& cinsts : i.body->instructions) { G.visitInstructions(cinsts, false); }
 
   if (G.builder->GetInsertBlock()->getTerminator() == nullptr && ft->getReturnType()->isVoidTy()) {
+    if (idle_context) { updateIdleCounter(nullptr); }
     G.builder->CreateRetVoid();
   }
   G.switchToMainFun();
@@ -299,8 +315,10 @@ llvm::FunctionType* CodeGenVisitor::createFunctionType(minst::Function& i) {
   return llvm::cast<llvm::FunctionType>((*G.typeconverter)(mmmfntype));
 }
 
+// only dsp is looked up by the runtime. other functions are called directly or through addresses
+// given to the runtime, so that unused ones can be removed by the optimizer.
 llvm::Function* CodeGenVisitor::createFunction(llvm::FunctionType* type, minst::Function& i) {
-  auto link = llvm::Function::ExternalLinkage;
+  auto link = i.name == "dsp" ? llvm::Function::ExternalLinkage : llvm::Function::InternalLinkage;
   auto* f = llvm::Function::Create(type, link, i.name, *G.module);
   return f;
 }
@@ -354,6 +372,62 @@ void CodeGenVisitor::setMemObjsToMap(mir::valueptr fun, llvm::Value* memarg) {
     auto* selfval = G.builder->CreateLoad(gep, "self");
     fun_to_selfval.emplace(fun, selfval);
   }
+  if (fobjtree->idle) {
+    auto* gep = G.builder->CreateStructGEP(memarg, count++, "ptr_idle");
+    idle_context = IdleContext{gep, nullptr, nullptr, fobjtree->idle.value()};
+  }
+}
+
+// returns 0 without evaluating the body if the watched inputs are below the threshold and the
+// counter of silent samples reached the hold time.
+void CodeGenVisitor::createIdleCheck(minst::Function& i, llvm::Function* f) {
+  auto& ctx = idle_context.value();
+  auto* rettype = f->getReturnType();
+  if (!rettype->isVoidTy() && !rettype->isDoubleTy()) {
+    throw std::runtime_error("idle can be used only in a function returning float or void");
+  }
+  auto* threshold = G.getConstDouble(ctx.params.threshold);
+  llvm::Value* level = G.getConstDouble(0.0);
+  size_t idx = 0;
+  for (auto& a : i.args.args) {
+    const bool watched = ctx.params.watched.at(idx++);
+    auto* arg = getLlvmVal(std::make_shared<mir::Value>(a));
+    if (!watched || !arg->getType()->isDoubleTy()) { continue; }
+    auto* absval = G.builder->CreateUnaryIntrinsic(llvm::Intrinsic::fabs, arg);
+    level = G.builder->CreateBinaryIntrinsic(llvm::Intrinsic::maxnum, level, absval);
+  }
+  ctx.counter = G.builder->CreateLoad(ctx.counterptr, "idle_counter");
+  ctx.quiet = G.builder->CreateFCmpOLT(level, threshold, "idle_quiet");
+  auto* asleep =
+      G.builder->CreateFCmpOGE(ctx.counter, G.getConstDouble(ctx.params.holdtime), "idle_asleep");
+  auto* skip = G.builder->CreateAnd(ctx.quiet, asleep, "idle_skip");
+  auto* skipbb = llvm::BasicBlock::Create(G.ctx, i.name + "_idle", f);
+  auto* bodybb = llvm::BasicBlock::Create(G.ctx, i.name + "_body", f);
+  G.builder->CreateCondBr(skip, skipbb, bodybb);
+  G.builder->SetInsertPoint(skipbb);
+  if (rettype->isVoidTy()) {
+    G.builder->CreateRetVoid();
+  } else {
+    G.builder->CreateRet(G.getConstDouble(0.0));
+  }
+  G.builder->SetInsertPoint(bodybb);
+}
+
+// counts up while inputs and output are silent, and resets otherwise.
+void CodeGenVisitor::updateIdleCounter(llvm::Value* output) {
+  auto& ctx = idle_context.value();
+  auto* threshold = G.getConstDouble(ctx.params.threshold);
+  auto* holdtime = G.getConstDouble(ctx.params.holdtime);
+  llvm::Value* quiet = ctx.quiet;
+  if (output != nullptr) {
+    auto* absval = G.builder->CreateUnaryIntrinsic(llvm::Intrinsic::fabs, output);
+    quiet = G.builder->CreateAnd(quiet, G.builder->CreateFCmpOLT(absval, threshold));
+  }
+  auto* increment = G.builder->CreateFAdd(ctx.counter, G.getConstDouble(1.0));
+  auto* notfull = G.builder->CreateFCmpOLT(ctx.counter, holdtime);
+  auto* counted = G.builder->CreateSelect(notfull, increment, ctx.counter);
+  auto* next = G.builder->CreateSelect(quiet, counted, G.getConstDouble(0.0), "idle_next");
+  G.builder->CreateStore(next, ctx.counterptr);
 }
 
 void CodeGenVisitor::setFvsToMap(minst::Function& i, llvm::Value* clsarg) {
@@ -368,6 +442,9 @@ void CodeGenVisitor::setFvsToMap(minst::Function& i, llvm::Value* clsarg) {
 }
 
 llvm::Value* CodeGenVisitor::operator()(minst::Fcall& i) {
+  if (i.ftype == EXTERNAL && mir::getName(*i.fname) == "oversample") {
+    return createOversample(i);
+  }
   const bool isclosure = i.ftype == CLOSURE;
   bool isrecursive = false;
   mir::valueptr mmmfn = i.fname;
@@ -382,43 +459,62 @@ llvm::Value* CodeGenVisitor::operator()(minst::Fcall& i) {
       mmmfn = clsptr->fname;
     }
   }
+  const auto fname = mir::getName(*i.fname);
+  // mimium_main has no memobj: a stateful builtin called on the top level runs once and its state
+  // slot is allocated in the heap.
+  const auto memobjtype =
+      i.ftype == EXTERNAL ? LLVMBuiltin::getMemobjType(fname) : std::nullopt;
+  const bool toplevelstate = memobjtype.has_value() && G.curfunc == G.mainentry->getParent();
   auto fobjtree_iter = funobj_map->find(mmmfn);
-  const bool hasmemobj = fobjtree_iter != funobj_map->end();
+  const bool hasmemobj = fobjtree_iter != funobj_map->end() || toplevelstate;
 
   auto* fun = isrecursive ? G.curfunc : getFunForFcall(i);
   // prepare arguments
   std::vector<llvm::Value*> args = {};
-  if (mir::getName(*i.fname) == "mimium_getnow") { args.push_back(G.getRuntimeInstance()); }
+  const bool takesruntime =
+      fname == "mimium_getnow" || (i.ftype == EXTERNAL && LLVMBuiltin::takesRuntime(fname));
+  const bool takescontext = i.ftype == EXTERNAL && LLVMBuiltin::takesContext(fname);
   if (i.time.has_value()) {
-    auto* timeval = getLlvmVal(i.time.value());
-    llvm::Value* ptrtofn = G.builder->CreateBitCast(fun, G.geti8PtrTy(), fun->getName() + "_i8");
-    args = {G.getRuntimeInstance(), timeval, ptrtofn};
-    if (i.args.empty()) { args.emplace_back(llvm::ConstantFP::get(G.ctx, llvm::APFloat(0.0))); }
-    if (i.args.size() > 1) {
-      throw std::runtime_error(
-          "currently function call with @ operator can accept only one argument with float type");
+    if (hasmemobj || takesruntime || takescontext) {
+      throw std::runtime_error("function " + fname +
+                               " cannot be called with @ operator as it has internal states");
+    }
+    llvm::Value* capptr = nullptr;
+    if (isclosure) {
+      capptr = isrecursive ? std::prev(G.curfunc->arg_end())
+                           : G.builder->CreateStructGEP(getLlvmVal(i.fname), 1, i.name + ".cap");
     }
-    // addTask should be declared in preprocess;
-    fun = G.module->getFunction(isclosure ? "addTask_cls" : "addTask");
+    return createScheduledCall(i, fun, capptr);
   }
+  if (takesruntime) { args.push_back(G.getRuntimeInstance()); }
+  if (takescontext) { args.push_back(G.getBuiltinContext()); }
   {
-    auto tmparg = makeFcallArgs(fun->getType(), i.args);
+    const auto offset = static_cast<unsigned int>(args.size());
+    auto tmparg = makeFcallArgs(fun->getType(), i.args, offset);
+    if (i.ftype == EXTERNAL) {
+      checkCallbackArgs(fun, tmparg, offset);
+      clampArraySize(fname, i.args, tmparg);
+    }
     std::copy(tmparg.begin(), tmparg.end(), std::back_inserter(args));
   }
   if (isclosure) {
     auto* capptr = isrecursive
                        ? std::prev(G.curfunc->arg_end(), (hasmemobj) ? 2 : 1)
                        : G.builder->CreateStructGEP(getLlvmVal(i.fname), 1, i.name + ".cap");
-    if (i.time.has_value()) {
-      capptr = G.builder->CreateBitCast(capptr, G.geti8PtrTy(), i.name + ".capi8");
-    }
     args.emplace_back(capptr);
   }
 
   if (hasmemobj) {
     // auto res = memobj_to_llvm.find(fobjtree_iter->second->fname);
     // if (res != memobj_to_llvm.end()) { args.emplace_back(res->second); }
-    args.emplace_back(popMemobjInContext());
+    if (toplevelstate) {
+      auto* slottype = G.getType(memobjtype.value());
+      auto* slot = createAllocation(true, slottype, nullptr, i.name + ".mem");
+      G.builder->CreateStore(llvm::Constant::getNullValue(slottype), slot);
+      args.emplace_back(slot);
+    } else {
+      args.emplace_back(popMemobjInContext());
+    }
   }
   auto* funtype_raw = fun->getType();
   if (funtype_raw->isPointerTy()) {
@@ -433,6 +529,153 @@ llvm::Value* CodeGenVisitor::operator()(minst::Fcall& i) {
   }
   return G.builder->CreateCall(ft, fun, args, i.name);
 }
+// arguments of a call with @ are stored into a payload on the stack, which is copied into the task
+// queue by addTask. tuples passed by pointer are stored by value.
+llvm::StructType* CodeGenVisitor::getTaskPayloadType(llvm::Function* fun, size_t numargs) {
+  std::vector<llvm::Type*> fields;
+  for (size_t idx = 0; idx < numargs; idx++) {
+    auto* ptype = fun->getFunctionType()->getParamType(idx);
+    const bool isstructptr =
+        ptype->isPointerTy() && llvm::cast<llvm::PointerType>(ptype)->getElementType()->isStructTy();
+    fields.emplace_back(isstructptr ? llvm::cast<llvm::PointerType>(ptype)->getElementType()
+                                    : ptype);
+  }
+  return llvm::StructType::get(G.ctx, fields);
+}
+// `fname.task(payload,cls)` unpacks the payload into the arguments of fname.
+llvm::Function* CodeGenVisitor::getTaskTrampoline(llvm::Function* fun, size_t numargs,
+                                                  bool isclosure) {
+  auto name = fun->getName().str() + ".task";
+  if (auto* res = G.module->getFunction(name)) { return res; }
+  auto* payloadtype = getTaskPayloadType(fun, numargs);
+  auto* fntype =
+      llvm::FunctionType::get(G.builder->getVoidTy(), {G.geti8PtrTy(), G.geti8PtrTy()}, false);
+  auto* res = llvm::Function::Create(fntype, llvm::Function::InternalLinkage, name, *G.module);
+  llvm::IRBuilder<> builder(llvm::BasicBlock::Create(G.ctx, "entry", res));
+  auto* payload = builder.CreateBitCast(res->arg_begin(), payloadtype->getPointerTo());
+  std::vector<llvm::Value*> args;
+  for (size_t idx = 0; idx < numargs; idx++) {
+    auto* ptr = builder.CreateStructGEP(payloadtype, payload, idx);
+    auto* fieldtype = payloadtype->getElementType(idx);
+    const bool byvalue = fun->getFunctionType()->getParamType(idx) != ptr->getType();
+    args.emplace_back(byvalue ? builder.CreateLoad(fieldtype, ptr) : ptr);
+  }
+  if (isclosure) {
+    auto* captype = fun->getFunctionType()->getParamType(numargs);
+    args.emplace_back(builder.CreatePointerCast(std::next(res->arg_begin()), captype));
+  }
+  builder.CreateCall(fun, args);
+  builder.CreateRetVoid();
+  return res;
+}
+llvm::Value* CodeGenVisitor::createScheduledCall(minst::Fcall& i, llvm::Value* fnval,
+                                                 llvm::Value* capptr) {
+  auto* fun = llvm::dyn_cast<llvm::Function>(fnval);
+  if (fun == nullptr) {
+    throw std::runtime_error("function passed as an argument cannot be called with @ operator");
+  }
+  const auto numargs = i.args.size();
+  auto* payloadtype = getTaskPayloadType(fun, numargs);
+  const auto size = G.module->getDataLayout().getTypeAllocSize(payloadtype);
+  if (size > task_payload_size) {
+    throw std::runtime_error("arguments of function call with @ operator must fit in " +
+                             std::to_string(task_payload_size) + " bytes");
+  }
+  // allocated in the entry block so that calls in a loop or a recursion do not grow the stack.
+  auto& entry = G.builder->GetInsertBlock()->getParent()->getEntryBlock();
+  llvm::IRBuilder<> entrybuilder(&entry, entry.begin());
+  auto* payload = entrybuilder.CreateAlloca(payloadtype, nullptr, i.name + ".payload");
+  auto args = makeFcallArgs(fun->getType(), i.args);
+  for (size_t idx = 0; idx < numargs; idx++) {
+    auto* ptr = G.builder->CreateStructGEP(payloadtype, payload, idx);
+    auto* fieldtype = payloadtype->getElementType(idx);
+    auto* val = args[idx]->getType() == fieldtype ? args[idx]
+                                                  : G.builder->CreateLoad(fieldtype, args[idx]);
+    G.builder->CreateStore(val, ptr);
+  }
+  auto* trampoline = getTaskTrampoline(fun, numargs, capptr != nullptr);
+  auto* i8ptr = G.geti8PtrTy();
+  auto* cls = capptr != nullptr ? G.builder->CreateBitCast(capptr, i8ptr, i.name + ".capi8")
+                                : llvm::ConstantPointerNull::get(i8ptr);
+  // addTask is declared in preprocess.
+  G.builder->CreateCall(G.module->getFunction("addTask"),
+                        {G.getRuntimeInstance(), getLlvmVal(i.time.value()),
+                         G.builder->CreateBitCast(trampoline, i8ptr),
+                         G.builder->CreateBitCast(payload, i8ptr), G.builder->getInt64(size), cls});
+  return nullptr;
+}
+// calls fn for each sample between the up and down filters. the memobj of fn is placed after the
+// state of the filters in the memobj of the call.
+llvm::Value* CodeGenVisitor::createOversample(minst::Fcall& i) {
+  auto argiter = i.args.begin();
+  auto fnval = *argiter++;
+  auto* input = getLlvmVal(*argiter++);
+  auto* factorval = llvm::dyn_cast<llvm::ConstantFP>(getLlvmVal(*argiter));
+  const double factor = factorval != nullptr ? factorval->getValueAPF().convertToDouble() : 0.0;
+  if (factor != 2.0 && factor != 4.0 && factor != 8.0) {
+    throw std::runtime_error("the factor of oversample must be a constant 2, 4 or 8");
+  }
+  auto innerfn = MemoryObjsCollector::getOversampledFun(i);
+  if (!innerfn) {
+    throw std::runtime_error("oversample can take only a function defined in the source");
+  }
+  auto* fun = llvm::cast<llvm::Function>(getLlvmVal(innerfn.value()));
+  std::vector<llvm::Value*> extraargs;
+  if (mir::isInstA<minst::MakeClosure>(fnval)) {
+    extraargs.emplace_back(G.builder->CreateStructGEP(getLlvmVal(fnval), 1, i.name + ".cap"));
+  }
+  auto* memobj = popMemobjInContext();
+  auto* state = G.builder->CreateStructGEP(memobj, 0, i.name + ".state");
+  if (funobj_map->count(innerfn.value()) > 0) {
+    auto* innermem = G.builder->CreateStructGEP(memobj, 1, i.name + ".innermem");
+    auto* paramtype = std::prev(fun->arg_end())->getType();
+    extraargs.emplace_back(G.builder->CreatePointerCast(innermem, paramtype));
+  }
+  std::vector<llvm::Value*> upargs = {G.getBuiltinContext(), input, G.getConstDouble(factor),
+                                      state};
+  auto* frame =
+      G.builder->CreateCall(G.getRuntimeFunction("mimium_oversample_up"), upargs, i.name + ".up");
+  for (int k = 0; k < static_cast<int>(factor); k++) {
+    auto* ptr = G.builder->CreateConstInBoundsGEP1_32(G.getDoubleTy(), frame, k);
+    std::vector<llvm::Value*> args = {G.builder->CreateLoad(G.getDoubleTy(), ptr)};
+    std::copy(extraargs.begin(), extraargs.end(), std::back_inserter(args));
+    G.builder->CreateStore(G.builder->CreateCall(fun, args), ptr);
+  }
+  return G.builder->CreateCall(G.getRuntimeFunction("mimium_oversample_down"), {state}, i.name);
+}
+// builtin functions can take only plain function pointers as callbacks.
+void CodeGenVisitor::clampArraySize(std::string const& fname, std::list<mir::valueptr> const& args,
+                                    std::vector<llvm::Value*>& llargs) {
+  auto sizearg = LLVMBuiltin::getArraySizeArg(fname);
+  if (!sizearg || sizearg.value() >= llargs.size()) { return; }
+  std::optional<int> length;
+  for (const auto& a : args) {
+    auto type = mir::getType(*a);
+    if (rv::holds_alternative<types::Pointer>(type)) { type = rv::get<types::Pointer>(type).val; }
+    if (!rv::holds_alternative<types::Array>(type)) { continue; }
+    const auto& arr = rv::get<types::Array>(type);
+    if (!types::isArraySizeVariable(arr)) {
+      length = std::min(length.value_or(arr.size), arr.size);
+    }
+  }
+  if (!length) { return; }
+  auto*& size = llargs[sizearg.value()];
+  size = G.builder->CreateMinNum(size, G.getConstDouble(length.value()), "arraysize");
+}
+void CodeGenVisitor::checkCallbackArgs(llvm::Value* fun, std::vector<llvm::Value*> const& args,
+                                       unsigned int param_offset) {
+  auto* ft = llvm::cast<llvm::Function>(fun)->getFunctionType();
+  for (unsigned int idx = 0; idx < args.size() && idx + param_offset < ft->getNumParams(); idx++) {
+    auto* ptype = ft->getParamType(idx + param_offset);
+    const bool isfnptr = ptype->isPointerTy() &&
+                         llvm::cast<llvm::PointerType>(ptype)->getElementType()->isFunctionTy();
+    if (isfnptr && args[idx]->getType() != ptype) {
+      throw std::runtime_error(
+          "a function passed to builtin function cannot capture variables or use self, mem and "
+          "delay internally.");
+    }
+  }
+}
 llvm::Value* CodeGenVisitor::getFunForFcall(minst::Fcall const& i) {
   switch (i.ftype) {
     case DIRECT: return getDirFun(i);
@@ -462,6 +705,9 @@ llvm::Value* CodeGenVisitor::getClsFun(minst::Fcall const& i) {
 }
 llvm::Value* CodeGenVisitor::getExtFun(minst::Fcall const& i) {
   auto fun = std::get<mir::ExternalSymbol>(*i.fname);
+  if (fun.name == "idle") {
+    throw std::runtime_error("idle must be called on the top level of a function body");
+  }
   if (LLVMBuiltin::ftable.count(fun.name) > 0) { return G.getForeignFunction(fun.name); }
   if (G.runtime_fun_names.count(fun.name) > 0) { return G.getRuntimeFunction(fun.name); }
   assert(false);
@@ -483,6 +729,7 @@ llvm::Value* CodeGenVisitor::operator()(minst::MakeClosure& i) {
   auto* closuretype = G.getType(i.type);
   // // always heap allocation!
   auto* closure_ptr = createAllocation(true, closuretype, nullptr, i.name);
+  G.memory_report.addClosure(G.module->getDataLayout().getTypeAllocSize(closuretype));
   if (!isdsp) {
     auto* fun_ptr = G.builder->CreateStructGEP(closure_ptr, 0, i.name + "_fun_ptr");
     G.builder->CreateStore(targetf, fun_ptr);
@@ -506,12 +753,41 @@ llvm::Value* CodeGenVisitor::operator()(minst::MakeClosure& i) {
 }
 llvm::Value* CodeGenVisitor::operator()(minst::Array& i) {
   auto* atype = G.getArrayType(i.type);
-  auto* gvalue = llvm::cast<llvm::GlobalVariable>(G.module->getOrInsertGlobal(i.name, atype));
-  auto values =
-      fmap(i.args, [&](mir::valueptr v) { return llvm::cast<llvm::Constant>(getLlvmVal(v)); });
-  auto* constantarray = llvm::ConstantArray::get(atype, values);
-  gvalue->setInitializer(constantarray);
-  return gvalue;
+  auto values = fmap(i.args, [&](mir::valueptr v) { return getLlvmVal(v); });
+  const bool isconstant = std::all_of(values.cbegin(), values.cend(),
+                                      [](llvm::Value* v) { return llvm::isa<llvm::Constant>(v); });
+  if (isconstant) {
+    auto* gvalue = llvm::cast<llvm::GlobalVariable>(G.module->getOrInsertGlobal(i.name, atype));
+    const bool isnumbers = atype->getElementType()->isDoubleTy() &&
+                           std::all_of(values.cbegin(), values.cend(), [](llvm::Value* v) {
+                             return llvm::isa<llvm::ConstantFP>(v);
+                           });
+    if (isnumbers) {
+      // packed data is much cheaper to build and optimize than an array of constant objects.
+      auto numbers = fmap(values, [](llvm::Value* v) {
+        return llvm::cast<llvm::ConstantFP>(v)->getValueAPF().convertToDouble();
+      });
+      gvalue->setInitializer(llvm::ConstantDataArray::get(G.ctx, llvm::ArrayRef<double>(numbers)));
+    } else {
+      auto constvalues =
+          fmap(values, [](llvm::Value* v) { return llvm::cast<llvm::Constant>(v); });
+      gvalue->setInitializer(llvm::ConstantArray::get(atype, constvalues));
+    }
+    gvalue->setAlignment(llvm::MaybeAlign(simd_alignment));
+    return gvalue;
+  }
+  // array containing runtime values(e.g. multichannel output of dsp) is filled element-wise.
+  auto* arrptr = createAllocation(isglobal, atype, nullptr, i.name);
+  if (auto* alloca = llvm::dyn_cast<llvm::AllocaInst>(arrptr)) {
+    alloca->setAlignment(llvm::Align(simd_alignment));
+  }
+  uint64_t index = 0;
+  for (auto* v : values) {
+    auto* elemptr = G.builder->CreateConstInBoundsGEP2_64(atype, arrptr, 0, index++,
+                                                          i.name + "_elem");
+    G.builder->CreateStore(v, elemptr);
+  }
+  return arrptr;
 }
 llvm::Value* CodeGenVisitor::operator()(minst::ArrayAccess& i) {
   auto* target = getLlvmVal(i.target);
@@ -597,6 +873,7 @@ llvm::Value* CodeGenVisitor::operator()(minst::Return& i) {
     auto* selfptr = fun_to_selfptr.at(i.parent->parent.value());
     G.builder->CreateStore(res, selfptr);
   }
+  if (idle_context) { updateIdleCounter(res); }
   return G.builder->CreateRet(res);
 }
 }  // namespace mimium
\ No newline at end of file
@@ -42,7 +42,15 @@ struct CodeGenVisitor {
 
   llvm::Value* getLlvmVal(mir::valueptr mirval);
   llvm::Value* getLlvmValForFcallArgs(mir::valueptr mirval);
-  std::vector<llvm::Value*> makeFcallArgs(llvm::Type* ft,std::list<mir::valueptr>const& args);
+  // param_offset: number of parameters preceding args(e.g. runtime instance).
+  std::vector<llvm::Value*> makeFcallArgs(llvm::Type* ft, std::list<mir::valueptr> const& args,
+                                          unsigned int param_offset = 0);
+  // clamps the size argument of an array builtin to the length of fixed-size arrays(literals and
+  // arrays on the stack), which are not known to the builtin context.
+  void clampArraySize(std::string const& fname, std::list<mir::valueptr> const& args,
+                      std::vector<llvm::Value*>& llargs);
+  static void checkCallbackArgs(llvm::Value* fun, std::vector<llvm::Value*> const& args,
+                                unsigned int param_offset = 0);
 
   std::unordered_map<mir::valueptr, llvm::Value*> mir_to_llvm;
 
@@ -64,6 +72,10 @@ struct CodeGenVisitor {
   llvm::Value* getClsFun(minst::Fcall const& i);
   llvm::Value* getExtFun(minst::Fcall const& i);
   llvm::Value* popMemobjInContext();
+  llvm::Value* createOversample(minst::Fcall& i);
+  llvm::Value* createScheduledCall(minst::Fcall& i, llvm::Value* fnval, llvm::Value* capptr);
+  llvm::StructType* getTaskPayloadType(llvm::Function* fun, size_t numargs);
+  llvm::Function* getTaskTrampoline(llvm::Function* fun, size_t numargs, bool isclosure);
   llvm::FunctionType* createFunctionType(minst::Function& i);
   llvm::FunctionType* createDspFnType(minst::Function& i,bool hascapture,bool hasmemobj);
 
@@ -72,6 +84,16 @@ struct CodeGenVisitor {
 
   void setFvsToMap(minst::Function& i, llvm::Value* clsarg);
   void setMemObjsToMap(mir::valueptr fun, llvm::Value* memarg);
+  // skipping function body while inputs and state are silent, enabled by idle().
+  struct IdleContext {
+    llvm::Value* counterptr = nullptr;
+    llvm::Value* counter = nullptr;
+    llvm::Value* quiet = nullptr;
+    IdleParams params;
+  };
+  std::optional<IdleContext> idle_context;
+  void createIdleCheck(minst::Function& i, llvm::Function* f);
+  void updateIdleCounter(llvm::Value* output);
   llvm::Value* createAllocation(bool isglobal, llvm::Type* type, llvm::Value* array_size,
                                 const llvm::Twine& name);
   llvm::Value* createIfBody(mir::blockptr& block);
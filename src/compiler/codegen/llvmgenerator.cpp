@@ -25,7 +25,16 @@ LLVMGenerator::LLVMGenerator(llvm::LLVMContext& ctx)
             llvm::FunctionType::get(
                 getDoubleTy(), {llvm::PointerType::get(getDoubleTy(), 0), getDoubleTy()}, false)},
            {"mimium_malloc",
-            llvm::FunctionType::get(geti8PtrTy(), {geti8PtrTy(), geti64Ty()}, false)}}) {}
+            llvm::FunctionType::get(geti8PtrTy(), {geti8PtrTy(), geti64Ty()}, false)},
+           {"mimium_getbuiltincontext",
+            llvm::FunctionType::get(geti8PtrTy(), {geti8PtrTy()}, false)},
+           {"mimium_oversample_up",
+            llvm::FunctionType::get(llvm::PointerType::get(getDoubleTy(), 0),
+                                    {geti8PtrTy(), getDoubleTy(), getDoubleTy(),
+                                     geti8PtrTy()->getPointerTo()},
+                                    false)},
+           {"mimium_oversample_down",
+            llvm::FunctionType::get(getDoubleTy(), {geti8PtrTy()->getPointerTo()}, false)}}) {}
 
 llvm::Module& LLVMGenerator::getModule() { return *this->module; }
 std::unique_ptr<llvm::Module> LLVMGenerator::moveModule() { return std::move(this->module); }
@@ -85,15 +94,39 @@ void LLVMGenerator::switchToMainFun() {
   curfunc = mainentry->getParent();
 }
 llvm::Function* LLVMGenerator::getForeignFunction(const std::string& name) {
-  const auto& [type, targetname] = LLVMBuiltin::ftable.find(name)->second;
+  const auto& [type, targetname, memobjtype, takes_runtime, takes_context] =
+      LLVMBuiltin::ftable.find(name)->second;
+  if (targetname.empty()) { throw std::runtime_error(name + " can only be called directly"); }
   auto ftype = rv::get<types::Function>(type);
-  if (name == "delay") { ftype.arg_types.emplace_back(types::Ref{types::getDelayStruct()}); }
-  if (name == "mem") { ftype.arg_types.emplace_back(types::Ref{types::Float{}}); }
+  if (memobjtype) { ftype.arg_types.emplace_back(types::Ref{memobjtype.value()}); }
+  if (takes_runtime || takes_context) {
+    ftype.arg_types.insert(ftype.arg_types.begin(), types::Ref{types::Void{}});
+  }
+  // callback function for builtin is passed as a function pointer, and array as a pointer to
+  // the elements.
+  auto array_to_pointer = [](types::Value& t) {
+    if (std::holds_alternative<types::rArray>(t)) { t = types::Pointer{t}; }
+  };
+  for (auto& atype : ftype.arg_types) {
+    if (auto* cbtype = std::get_if<types::rFunction>(&atype)) {
+      // arrays given to the callback are the ones the user function receives.
+      auto cb = cbtype->getraw();
+      for (auto& t : cb.arg_types) { array_to_pointer(t); }
+      atype = types::Pointer{cb};
+    }
+    array_to_pointer(atype);
+  }
   if (!types::isPrimitive(ftype.ret_type)) {
     // for loadwavfile
     ftype.ret_type = types::Ref{ftype.ret_type};
   }
-  return getFunction(targetname, getType(ftype));
+  auto* fn = getFunction(targetname, getType(ftype));
+  // lets the optimizer move and vectorize math functions.
+  if (LLVMBuiltin::isPure(name)) {
+    fn->setDoesNotAccessMemory();
+    fn->setDoesNotThrow();
+  }
+  return fn;
 }
 llvm::Function* LLVMGenerator::getRuntimeFunction(const std::string& name) {
   const auto& type = runtime_fun_names.at(name);
@@ -145,21 +178,17 @@ void LLVMGenerator::createMainFun() {
   mainfun->addAttributes(llvm::AttributeList::FunctionIndex, aset);
   mainentry = llvm::BasicBlock::Create(ctx, "entry", mainfun);
 }
-void LLVMGenerator::createTaskRegister(bool isclosure = false) {
+void LLVMGenerator::createTaskRegister() {
   std::vector<llvm::Type*> argtypes = {
       builder->getInt8PtrTy(),  // address to runtime instance
       builder->getDoubleTy(),   // time
-      builder->getInt8PtrTy(),  // address to function
-      builder->getDoubleTy()    // argument(single)
+      builder->getInt8PtrTy(),  // address to trampoline function
+      builder->getInt8PtrTy(),  // address to arguments
+      builder->getInt64Ty(),    // size of arguments
+      builder->getInt8PtrTy()   // address to closure args(null for non-closure function)
   };
-  std::string name = "addTask";
-  if (isclosure) {
-    argtypes.emplace_back(
-        builder->getInt8PtrTy());  // address to closure args(instead of void* type)
-    name = "addTask_cls";
-  }
   auto* fntype = llvm::FunctionType::get(builder->getVoidTy(), argtypes, false);
-  auto addtask = module->getOrInsertFunction(name, fntype);
+  auto addtask = module->getOrInsertFunction("addTask", fntype);
   auto* addtaskfun = llvm::cast<llvm::Function>(addtask.getCallee());
 
   addtaskfun->setCallingConv(llvm::CallingConv::C);
@@ -186,6 +215,15 @@ std::optional<int> LLVMGenerator::getDspFnChannelNumForType(types::Value const&
       }
       return ttype.arg_types.size();
     }
+    // fixed-size array of float, mainly for the large number of channels.
+    if (rv::holds_alternative<types::Array>(ptype.val)) {
+      const auto& atype = rv::get<types::Array>(ptype.val);
+      if (!std::holds_alternative<types::Float>(atype.elem_type) ||
+          types::isArraySizeVariable(atype)) {
+        return std::nullopt;
+      }
+      return atype.size;
+    }
   }
   if (std::holds_alternative<types::Void>(t)) { return 0; }
   return std::nullopt;
@@ -216,10 +254,14 @@ void LLVMGenerator::checkDspFunctionType(minst::Function const& i) {
       throw std::runtime_error("Number of Arguments for dsp function must be 0 or 1.");
       break;
   }
-  if (!inchs) { throw std::runtime_error("Arguments for dsp function must be 1 Tuple of Floats"); }
+  if (!inchs) {
+    throw std::runtime_error(
+        "Arguments for dsp function must be 1 Tuple of Floats or fixed-size Array of Float");
+  }
   if (!outchs) {
     throw std::runtime_error(
-        "Return type for dsp function must be either of Void or Tuple of Floats");
+        "Return type for dsp function must be either of Void, Tuple of Floats or fixed-size Array "
+        "of Float");
   }
   runtime_dspfninfo.in_numchs = inchs.value();
   runtime_dspfninfo.out_numchs = outchs.value();
@@ -235,6 +277,9 @@ void LLVMGenerator::createRuntimeSetDspFn(llvm::Type* memobjtype) {
   auto* dspclsaddress = (runtime_dspfninfo.capptr != nullptr)
                             ? builder->CreateBitCast(runtime_dspfninfo.capptr, voidptrtype)
                             : llvm::ConstantPointerNull::get(voidptrtype);
+  auto* dspblockaddress = (runtime_dspfninfo.blockfn != nullptr)
+                             ? builder->CreateBitCast(runtime_dspfninfo.blockfn, voidptrtype)
+                             : constantnull;
   llvm::Value* dspmemobjaddress = constantnull;
   if (memobjtype != nullptr) {
     auto* dspmemobjptr = codegenvisitor->createAllocation(true, memobjtype, nullptr, "dsp.mem");
@@ -252,13 +297,86 @@ void LLVMGenerator::createRuntimeSetDspFn(llvm::Type* memobjtype) {
       "setDspParams",
       llvm::FunctionType::get(
           builder->getVoidTy(),
-          {voidptrtype, voidptrtype, voidptrtype, voidptrtype, int32ty, int32ty}, false));
+          {voidptrtype, voidptrtype, voidptrtype, voidptrtype, int32ty, int32ty, int32ty,
+           voidptrtype},
+          false));
   constexpr int bitsize = 32;
   auto* inchs_const = getConstInt(runtime_dspfninfo.in_numchs, bitsize);
   auto* outchs_const = getConstInt(runtime_dspfninfo.out_numchs, bitsize);
+  auto* latency_const = getConstInt(runtime_dspfninfo.latency, bitsize);
 
   builder->CreateCall(setdsp, {getRuntimeInstance(), dspfnaddress, dspclsaddress, dspmemobjaddress,
-                               inchs_const, outchs_const});
+                               inchs_const, outchs_const, latency_const, dspblockaddress});
+}
+
+// functions reading the current time can not be processed by block.
+bool LLVMGenerator::isTimeIndependent(llvm::Function* f,
+                                      std::unordered_set<llvm::Function*>& visited) {
+  if (!visited.insert(f).second) { return true; }
+  for (auto& bb : *f) {
+    for (auto& inst : bb) {
+      auto* call = llvm::dyn_cast<llvm::CallInst>(&inst);
+      if (call == nullptr) { continue; }
+      auto* callee = call->getCalledFunction();
+      // closures called via pointer can not be tracked.
+      if (callee == nullptr) { return false; }
+      const auto name = callee->getName();
+      if (name == "mimium_getnow" || name == "addTask") { return false; }
+      if (!callee->isDeclaration() && !isTimeIndependent(callee, visited)) { return false; }
+    }
+  }
+  return true;
+}
+
+// dsp.block(out,in,cls,memobj,nframes) calls dsp for consecutive frames. dsp is inlined into the
+// loop, and stateless parts of it are split into separate loops by the optimizer to be vectorized
+// across samples(see SampleLoopSplitter).
+void LLVMGenerator::createDspBlockFn(llvm::Function* dspfn) {
+  std::unordered_set<llvm::Function*> visited;
+  if (dspfn->arg_size() != 4 || !isTimeIndependent(dspfn, visited)) { return; }
+  auto* dblptr = llvm::PointerType::get(getDoubleTy(), 0);
+  auto* int32ty = builder->getInt32Ty();
+  auto* fntype = llvm::FunctionType::get(
+      builder->getVoidTy(), {dblptr, dblptr, geti8PtrTy(), geti8PtrTy(), int32ty}, false);
+  auto* blockfn =
+      llvm::Function::Create(fntype, llvm::Function::ExternalLinkage, "dsp.block", *module);
+  auto* args = blockfn->arg_begin();
+  auto* out = args;
+  auto* in = std::next(args, 1);
+  auto* cls = std::next(args, 2);
+  auto* mem = std::next(args, 3);
+  auto* nframes = std::next(args, 4);
+  for (unsigned int idx = 0; idx < 2; idx++) {
+    blockfn->addParamAttr(idx, llvm::Attribute::NoAlias);
+    blockfn->addParamAttr(idx, llvm::Attribute::NoCapture);
+  }
+  dspfn->addFnAttr(llvm::Attribute::AlwaysInline);
+
+  auto* entry = llvm::BasicBlock::Create(ctx, "entry", blockfn);
+  auto* loop = llvm::BasicBlock::Create(ctx, "frame", blockfn);
+  auto* exit = llvm::BasicBlock::Create(ctx, "exit", blockfn);
+  builder->SetInsertPoint(entry);
+  builder->CreateCondBr(builder->CreateICmpSGT(nframes, getConstInt(0, 32)), loop, exit);
+  builder->SetInsertPoint(loop);
+  auto* index = builder->CreatePHI(int32ty, 2, "frameindex");
+  index->addIncoming(getConstInt(0, 32), entry);
+  auto framepointer = [&](llvm::Value* buf, int numchs, llvm::Type* ptype) {
+    auto* offset = builder->CreateMul(index, getConstInt(numchs, 32));
+    auto* ptr = builder->CreateInBoundsGEP(getDoubleTy(), buf, offset);
+    return builder->CreatePointerCast(ptr, ptype);
+  };
+  auto* dspft = dspfn->getFunctionType();
+  builder->CreateCall(dspft, dspfn,
+                      {framepointer(out, runtime_dspfninfo.out_numchs, dspft->getParamType(0)),
+                       framepointer(in, runtime_dspfninfo.in_numchs, dspft->getParamType(1)),
+                       builder->CreatePointerCast(cls, dspft->getParamType(2)),
+                       builder->CreatePointerCast(mem, dspft->getParamType(3))});
+  auto* next = builder->CreateAdd(index, getConstInt(1, 32), "nextframe", false, true);
+  index->addIncoming(next, loop);
+  builder->CreateCondBr(builder->CreateICmpSLT(next, nframes), loop, exit);
+  builder->SetInsertPoint(exit);
+  builder->CreateRetVoid();
+  runtime_dspfninfo.blockfn = blockfn;
 }
 
 llvm::Value* LLVMGenerator::getRuntimeInstance() {
@@ -267,11 +385,29 @@ llvm::Value* LLVMGenerator::getRuntimeInstance() {
   return builder->CreateLoad(var, "runtimeptr");
 }
 
+// the context is requested from the runtime at the beginning of mimium_main, only by modules
+// calling builtins which take it.
+llvm::Value* LLVMGenerator::getBuiltinContext() {
+  auto* var = module->getNamedGlobal("global_builtin_context");
+  if (var == nullptr) {
+    module->getOrInsertGlobal("global_builtin_context", geti8PtrTy());
+    var = module->getNamedGlobal("global_builtin_context");
+    var->setLinkage(llvm::GlobalValue::LinkageTypes::PrivateLinkage);
+    var->setInitializer(llvm::ConstantPointerNull::get(geti8PtrTy()));
+    llvm::IRBuilder<> initbuilder(ctx);
+    // after storing global_runtime.
+    initbuilder.SetInsertPoint(mainentry, std::next(mainentry->begin()));
+    auto* context = initbuilder.CreateCall(getRuntimeFunction("mimium_getbuiltincontext"),
+                                           {mainentry->getParent()->args().begin()});
+    initbuilder.CreateStore(context, var);
+  }
+  return builder->CreateLoad(var, "builtincontext");
+}
+
 void LLVMGenerator::preprocess() {
   createMainFun();
   createMiscDeclarations();
-  createTaskRegister(true);   // for non-closure function
-  createTaskRegister(false);  // for closure
+  createTaskRegister();
   setBB(mainentry);
   builder->CreateStore(mainentry->getParent()->args().begin(),
                        module->getNamedGlobal("global_runtime"), false);
@@ -287,21 +423,67 @@ void LLVMGenerator::visitInstructions(mir::valueptr inst, bool isglobal) {
 
 void LLVMGenerator::generateCode(mir::blockptr mir, const funobjmap* funobjs) {
   codegenvisitor = std::make_shared<CodeGenVisitor>(*this, funobjs);
+  memory_report = MemoryReport{};
+  memory_report.has_static = true;
   preprocess();
   llvm::Type* memobjtype = nullptr;
   for (auto& inst : mir->instructions) {
     visitInstructions(inst, true);
     if (mir::getName(*inst) == "dsp") {
       auto&& iter = funobjs->find(inst);
-      if (iter != funobjs->end()) { memobjtype = getType(iter->second->objtype); }
+      if (iter != funobjs->end()) {
+        memobjtype = getType(iter->second->objtype);
+        memory_report.memobj_bytes = module->getDataLayout().getTypeAllocSize(memobjtype);
+        addMemObjsToReport(*iter->second, memobjtype, "dsp");
+      }
     }
   }
+  if (auto* dspfn = module->getFunction("dsp")) {
+    auto* mainbb = builder->GetInsertBlock();
+    createDspBlockFn(dspfn);
+    setBB(mainbb);
+  }
   // create a call for setDspParams regardless dsp fn is present
   createRuntimeSetDspFn(memobjtype);
   // main always return null for now;
   builder->CreateRet(llvm::ConstantPointerNull::get(builder->getInt8PtrTy()));
 }
 
+// the memobj of a function consists of the memobjs of its calls in order, followed by self and the
+// counter of idle. oversample holds the state of its filters before the memobj of the function.
+void LLVMGenerator::addMemObjsToReport(FunObjTree const& tree, llvm::Type* type,
+                                       std::string const& path) {
+  const auto& dl = module->getDataLayout();
+  bool isdelay = false;
+  unsigned int offset = 0;
+  if (const auto* ext = std::get_if<mir::ExternalSymbol>(tree.fname.get())) {
+    isdelay = ext->name == "delay" || ext->name == "lookahead";
+    offset = ext->name == "oversample" ? 1 : 0;
+  }
+  auto* stype = llvm::dyn_cast<llvm::StructType>(type);
+  const unsigned int nchildren =
+      stype != nullptr
+          ? std::min<unsigned int>(tree.memobjs.size(), stype->getNumElements() - offset)
+          : 0;
+  size_t childbytes = 0;
+  for (unsigned int idx = 0; idx < nchildren; idx++) {
+    childbytes += dl.getTypeAllocSize(stype->getElementType(idx + offset));
+  }
+  memory_report.addMemObj(path, dl.getTypeAllocSize(type) - childbytes, isdelay);
+  // the same function called more than once is distinguished by the index.
+  std::unordered_map<std::string, int> namecount;
+  auto child = tree.memobjs.cbegin();
+  for (unsigned int idx = 0; idx < nchildren; idx++, child++) {
+    const auto& fname = (*child)->fname;
+    auto name = std::holds_alternative<mir::ExternalSymbol>(*fname)
+                    ? std::get<mir::ExternalSymbol>(*fname).name
+                    : mir::getInstRef<minst::Function>(fname).name;
+    const int count = namecount[name]++;
+    if (count > 0) { name += "[" + std::to_string(count) + "]"; }
+    addMemObjsToReport(**child, stype->getElementType(idx + offset), path + "/" + name);
+  }
+}
+
 void LLVMGenerator::outputToStream(llvm::raw_ostream& stream) {
   module->print(stream, nullptr, false, true);
 }
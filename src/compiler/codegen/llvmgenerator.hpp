@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <unordered_set>
 #include "basic/mir.hpp"
+#include "compiler/codegen/memory_report.hpp"
 namespace llvm {
 class LLVMContext;
 class Module;
@@ -43,8 +45,13 @@ class MIMIUM_DLL_PUBLIC LLVMGenerator {
   std::unique_ptr<llvm::Module> moveModule();
   void init(std::string filename);
   void setDataLayout(const llvm::DataLayout& dl);
+  // latency of dsp function in samples, reported to the runtime.
+  void setLatency(int latency) { runtime_dspfninfo.latency = latency; }
   void reset(std::string filename);
 
+  // sizes of memobjs and heap allocations of the last generated module.
+  [[nodiscard]] MemoryReport const& getMemoryReport() const { return memory_report; }
+
   void outputToStream(llvm::raw_ostream& ostream);
   static void dumpvar(llvm::Value* v);
   static void dumpvar(llvm::Type* v);
@@ -58,6 +65,7 @@ class MIMIUM_DLL_PUBLIC LLVMGenerator {
   llvm::BasicBlock* currentblock;
   std::unique_ptr<TypeConverter> typeconverter;
   std::shared_ptr<CodeGenVisitor> codegenvisitor;
+  MemoryReport memory_report;
 
   llvm::Type* getType(types::Value const& type);
   // Used for getting Arraytype which is not pointer of elementtype
@@ -72,6 +80,8 @@ class MIMIUM_DLL_PUBLIC LLVMGenerator {
     llvm::Value* memobjptr = nullptr;
     int in_numchs = 0;
     int out_numchs = 0;
+    int latency = 0;
+    llvm::Function* blockfn = nullptr;
   } runtime_dspfninfo;
 
   void switchToMainFun();
@@ -82,16 +92,20 @@ class MIMIUM_DLL_PUBLIC LLVMGenerator {
 
   void createMiscDeclarations();
   void createRuntimeSetDspFn(llvm::Type* memobjtype);
+  void createDspBlockFn(llvm::Function* dspfn);
+  void addMemObjsToReport(FunObjTree const& tree, llvm::Type* type, std::string const& path);
+  static bool isTimeIndependent(llvm::Function* f, std::unordered_set<llvm::Function*>& visited);
   void checkDspFunctionType(minst::Function const& i);
   static std::optional<int> getDspFnChannelNumForType(types::Value const& t);
   void createMainFun();
-  void createTaskRegister(bool isclosure);
+  void createTaskRegister();
   void createNewBasicBlock(std::string name, llvm::Function* f);
   void visitInstructions(mir::valueptr inst, bool isglobal);
   void setBB(llvm::BasicBlock* newblock);
   void dropAllReferences();
 
   llvm::Value* getRuntimeInstance();
+  llvm::Value* getBuiltinContext();
 
   llvm::Type* getDoubleTy();
   llvm::PointerType* geti8PtrTy();
@@ -0,0 +1,101 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/codegen/memory_report.hpp"
+#include <array>
+#include <cstdio>
+
+namespace mimium {
+
+namespace {
+std::string formatBytes(size_t bytes) {
+  constexpr std::array<const char*, 4> units = {"B", "KiB", "MiB", "GiB"};
+  auto value = static_cast<double>(bytes);
+  size_t unit = 0;
+  while (value >= 1024.0 && unit + 1 < units.size()) {
+    value /= 1024.0;
+    unit++;
+  }
+  std::array<char, 32> buf{};
+  if (unit == 0) {
+    std::snprintf(buf.data(), buf.size(), "%zu B", bytes);
+  } else {
+    std::snprintf(buf.data(), buf.size(), "%.1f %s", value, units[unit]);
+  }
+  return buf.data();
+}
+
+void printLine(std::ostream& out, std::string const& label, std::string const& value,
+               int indent = 2) {
+  std::array<char, 256> buf{};
+  std::snprintf(buf.data(), buf.size(), "%*s%-*s %12s", indent, "", 36 - indent, label.c_str(),
+                value.c_str());
+  out << buf.data();
+}
+}  // namespace
+
+void MemoryReport::addMemObj(std::string path, size_t bytes, bool isdelay) {
+  if (isdelay) {
+    delay_count++;
+    delay_bytes += bytes;
+  }
+  memobjs.emplace_back(MemObj{std::move(path), bytes, isdelay});
+}
+
+void MemoryReport::addHeap(size_t bytes) {
+  heap_count++;
+  heap_bytes += bytes;
+}
+
+void MemoryReport::addClosure(size_t bytes) {
+  closure_count++;
+  closure_bytes += bytes;
+}
+
+void MemoryReport::print(std::ostream& out) const {
+  if (has_static) {
+    out << "memory report(compile time):\n";
+    printLine(out, "memobj of dsp", formatBytes(memobj_bytes));
+    out << "\n";
+    for (const auto& m : memobjs) {
+      if (m.bytes == 0) { continue; }
+      printLine(out, m.path, formatBytes(m.bytes), 4);
+      out << (m.isdelay ? " (delay buffer)\n" : "\n");
+    }
+    printLine(out, "delay buffers", formatBytes(delay_bytes));
+    out << " in " << delay_count << "\n";
+    printLine(out, "closures", formatBytes(closure_bytes));
+    out << " in " << closure_count << "\n";
+    printLine(out, "heap allocated by mimium_main", formatBytes(heap_bytes));
+    out << " in " << heap_count << "\n";
+  }
+  if (!measured) { return; }
+  const auto& m = measured.value();
+  out << "memory report(after preparing dsp):\n";
+  printLine(out, "global heap", formatBytes(m.heap_bytes));
+  out << " in " << m.heap_count << "\n";
+  printLine(out, "sample data", formatBytes(m.sample_bytes));
+  out << "\n";
+  printLine(out, "mapped data files", formatBytes(m.mapped_bytes));
+  out << "\n";
+  printLine(out, "builtin states", formatBytes(m.state_bytes));
+  out << " in " << m.state_count << "\n";
+  printLine(out, "builtin shared tables", formatBytes(m.shared_bytes));
+  out << " in " << m.shared_count << "\n";
+  printLine(out, "builtin arrays", formatBytes(m.array_bytes));
+  out << " in " << m.array_count << "\n";
+  printLine(out, "jit code", formatBytes(m.code_bytes));
+  out << "\n";
+  printLine(out, "jit data", formatBytes(m.data_bytes));
+  out << "\n";
+  printLine(out, "total(excluding mapped files)", formatBytes(getTotal(m)));
+  out << std::endl;
+}
+
+size_t MemoryReport::getTotal(Measured const& m) {
+  return m.heap_bytes + m.sample_bytes + m.state_bytes + m.shared_bytes + m.array_bytes +
+         m.code_bytes + m.data_bytes;
+}
+
+}  // namespace mimium
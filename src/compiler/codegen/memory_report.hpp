@@ -0,0 +1,66 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "export.hpp"
+
+namespace mimium {
+
+// Breakdown of the memory used by a program, printed by `--mem-report`.
+// The static part is collected by the code generator with the data layout of the target, and the
+// runtime part is measured after `mimium_main` returned and dsp was prepared, when builtins have
+// allocated their states.
+struct MIMIUM_DLL_PUBLIC MemoryReport {
+  struct MemObj {
+    // path of calls from dsp like "dsp/osc/delay".
+    std::string path;
+    // state of the function itself, excluding the memobjs of the functions it calls.
+    size_t bytes = 0;
+    bool isdelay = false;
+  };
+  // memobj of dsp in the order of the layout.
+  std::vector<MemObj> memobjs;
+  size_t memobj_bytes = 0;
+  size_t delay_count = 0;
+  size_t delay_bytes = 0;
+  // allocations through mimium_malloc in mimium_main, including closures and memobjs.
+  size_t closure_count = 0;
+  size_t closure_bytes = 0;
+  size_t heap_count = 0;
+  size_t heap_bytes = 0;
+  bool has_static = false;
+
+  struct Measured {
+    size_t heap_count = 0;
+    size_t heap_bytes = 0;
+    // decoded audio files in the sample pool.
+    size_t sample_bytes = 0;
+    // raw data files are mapped and paged in only when they are read.
+    size_t mapped_bytes = 0;
+    // held by builtin::Context: states of builtins, objects shared between them(e.g. transformed
+    // impulse responses and wavetables) and arrays allocated by builtins.
+    size_t state_count = 0;
+    size_t state_bytes = 0;
+    size_t shared_count = 0;
+    size_t shared_bytes = 0;
+    size_t array_count = 0;
+    size_t array_bytes = 0;
+    size_t code_bytes = 0;
+    size_t data_bytes = 0;
+  };
+  std::optional<Measured> measured;
+
+  void addMemObj(std::string path, size_t bytes, bool isdelay);
+  void addHeap(size_t bytes);
+  // closures are also counted by addHeap.
+  void addClosure(size_t bytes);
+  void print(std::ostream& out) const;
+  [[nodiscard]] static size_t getTotal(Measured const& m);
+};
+
+}  // namespace mimium
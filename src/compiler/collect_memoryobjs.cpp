@@ -23,12 +23,111 @@ std::optional<mir::valueptr> MemoryObjsCollector::tryFindFunByName(
   return (res == fnset.end()) ? std::nullopt : std::optional(*res);
 }
 
+double MemoryObjsCollector::getConstantParam(mir::valueptr v) {
+  if (mir::isInstA<minst::Number>(v)) { return mir::getInstRef<minst::Number>(v).val; }
+  if (auto* c = std::get_if<mir::Constants>(v.get())) {
+    if (auto* d = std::get_if<double>(c)) { return *d; }
+    if (auto* i = std::get_if<int>(c)) { return *i; }
+  }
+  throw std::runtime_error("parameters of idle must be constant numbers");
+}
+
+// removes idle() calls on the top level of the function body.
+std::optional<IdleParams> MemoryObjsCollector::extractIdleParams(minst::Function& f) {
+  std::optional<IdleParams> res;
+  auto& insts = f.body->instructions;
+  for (auto iter = insts.begin(); iter != insts.end();) {
+    auto* fcall =
+        mir::isInstA<minst::Fcall>(*iter) ? &mir::getInstRef<minst::Fcall>(*iter) : nullptr;
+    auto* ext = fcall != nullptr ? std::get_if<mir::ExternalSymbol>(fcall->fname.get()) : nullptr;
+    if (ext == nullptr || ext->name != "idle") {
+      ++iter;
+      continue;
+    }
+    if (f.name == "dsp") { throw std::runtime_error("idle cannot be used in dsp function"); }
+    res = IdleParams{getConstantParam(fcall->args.front()),
+                     getConstantParam(*std::next(fcall->args.begin()))};
+    iter = insts.erase(iter);
+  }
+  return res;
+}
+
+namespace {
+bool isConstantArg(mir::valueptr const& v) {
+  return mir::isInstA<minst::Number>(v) || std::holds_alternative<mir::Constants>(*v);
+}
+// the function referred by a value, which is a function or a closure of it.
+const mir::Value* getFunOf(mir::valueptr const& v) {
+  if (mir::isInstA<minst::Function>(v)) { return v.get(); }
+  if (mir::isInstA<minst::MakeClosure>(v)) {
+    return mir::getInstRef<minst::MakeClosure>(v).fname.get();
+  }
+  return nullptr;
+}
+}  // namespace
+
+void MemoryObjsCollector::collectSignalArgs(mir::blockptr block) {
+  auto escape = [&](mir::valueptr const& v) {
+    if (const auto* fn = getFunOf(v)) { escaped_funs.emplace(fn); }
+  };
+  for (auto& inst : block->instructions) {
+    auto* i = std::get_if<mir::Instructions>(inst.get());
+    if (i == nullptr) { continue; }
+    std::visit(overloaded{[&](minst::Function& f) { collectSignalArgs(f.body); },
+                          [&](minst::If& f) {
+                            collectSignalArgs(f.thenblock);
+                            if (f.elseblock) { collectSignalArgs(f.elseblock.value()); }
+                          },
+                          [&](minst::Fcall& f) {
+                            for (auto& a : f.args) { escape(a); }
+                            const auto* fn = getFunOf(f.fname);
+                            if (fn == nullptr) { return; }
+                            auto& args = signal_args[fn];
+                            args.resize(std::max(args.size(), f.args.size()), false);
+                            size_t idx = 0;
+                            for (auto& a : f.args) {
+                              if (!isConstantArg(a)) { args[idx] = true; }
+                              idx++;
+                            }
+                          },
+                          [&](minst::Store& s) { escape(s.value); },
+                          [&](minst::Return& r) { escape(r.val); },
+                          [&](minst::Array& a) {
+                            for (auto& e : a.args) { escape(e); }
+                          },
+                          [&](minst::MakeClosure& c) {
+                            for (auto& e : c.captures) { escape(e); }
+                          },
+                          [](auto& /*i*/) {}},
+               *i);
+  }
+}
+
+std::optional<mir::valueptr> MemoryObjsCollector::getOversampledFun(minst::Fcall const& i) {
+  auto fn = i.args.front();
+  if (mir::isInstA<minst::Function>(fn)) { return fn; }
+  if (mir::isInstA<minst::MakeClosure>(fn)) {
+    return mir::getInstRef<minst::MakeClosure>(fn).fname;
+  }
+  return std::nullopt;
+}
+
 std::shared_ptr<FunObjTree> MemoryObjsCollector::traverseFunTree(mir::valueptr fun) {
   assert(mir::isInstA<minst::Function>(fun));
 
   if (result_map.count(fun) > 0) { return result_map.at(fun); }
 
   auto& f = mir::getInstRef<minst::Function>(fun);
+  auto idle = extractIdleParams(f);
+  if (idle) {
+    auto iter = signal_args.find(fun.get());
+    const bool escaped = escaped_funs.count(fun.get()) > 0;
+    for (size_t idx = 0; idx < f.args.args.size(); idx++) {
+      const bool watched = iter != signal_args.end() && idx < iter->second.size() &&
+                           iter->second[idx];
+      idle->watched.push_back(escaped || watched);
+    }
+  }
   CollectMemVisitor visitor(*this);
   auto res = visitor.visitInsts(f.body);
   if (res.hasself) {
@@ -36,8 +135,14 @@ std::shared_ptr<FunObjTree> MemoryObjsCollector::traverseFunTree(mir::valueptr f
     auto& resulttype = CollectMemVisitor::getTupleFromAlias(res.objtype);
     resulttype.arg_types.emplace_back(rettype);
   }
-  auto objptr = std::make_shared<FunObjTree>(FunObjTree{fun, res.hasself, res.objs, res.objtype});
-  if (res.hasself || !res.objs.empty()) {
+  // counter of silent samples is put after self.
+  if (idle) {
+    auto& resulttype = CollectMemVisitor::getTupleFromAlias(res.objtype);
+    resulttype.arg_types.emplace_back(types::Float{});
+  }
+  auto objptr =
+      std::make_shared<FunObjTree>(FunObjTree{fun, res.hasself, res.objs, res.objtype, idle});
+  if (res.hasself || !res.objs.empty() || idle) {
     result_map.emplace(fun, objptr);
     auto& ftype = rv::get<types::Function>(f.type);
     ftype.arg_types.emplace_back(types::Ref{objptr->objtype});
@@ -46,6 +151,7 @@ std::shared_ptr<FunObjTree> MemoryObjsCollector::traverseFunTree(mir::valueptr f
 }
 
 funobjmap MemoryObjsCollector::process(mir::blockptr toplevel) {
+  collectSignalArgs(toplevel);
   auto& insts = toplevel->instructions;
   std::shared_ptr<FunObjTree> res;
   std::unordered_set<mir::valueptr> alloca_container;
@@ -54,7 +160,7 @@ funobjmap MemoryObjsCollector::process(mir::blockptr toplevel) {
       if (!std::holds_alternative<mir::ExternalSymbol>(*inst)) {
         res = traverseFunTree(inst);
         auto memtype = res->objtype;
-        if (!res->memobjs.empty() || res->hasself) {
+        if (!res->memobjs.empty() || res->hasself || res->idle) {
           alloca_container.emplace(std::make_shared<mir::Value>(
               minst::Allocate{{mir::getName(*inst) + ".mem", types::Pointer{memtype}}}));
         }
@@ -164,20 +270,17 @@ ResultT MemoryObjsCollector::CollectMemVisitor::operator()(minst::Fcall& i) {
                               assert(fun != nullptr);
                               if (!mir::getInstRef<minst::Function>(fun).isrecursive) {
                                 auto ret = M.traverseFunTree(fun);
-                                if (!ret->memobjs.empty() || ret->hasself) { return ret; }
+                                if (!ret->memobjs.empty() || ret->hasself || ret->idle) {
+                                  return ret;
+                                }
                               }
                               return std::nullopt;
                             },
                             [&](const mir::ExternalSymbol& e) -> opt_objtreeptr {
-                              if (e.name == "delay") {
+                              if (e.name == "oversample") { return M.makeOversampleTree(i); }
+                              if (auto memtype = LLVMBuiltin::getMemobjType(e.name)) {
                                 auto res = std::make_shared<FunObjTree>(
-                                    FunObjTree{i.fname, false, {}, types::getDelayStruct()});
-                                M.result_map.emplace(i.fname, res);
-                                return res;
-                              }
-                              if(e.name == "mem"){
-                                auto res = std::make_shared<FunObjTree>(
-                                    FunObjTree{i.fname, false, {}, types::Float{}});
+                                    FunObjTree{i.fname, false, {}, memtype.value()});
                                 M.result_map.emplace(i.fname, res);
                                 return res;
                               }
@@ -204,6 +307,22 @@ ResultT MemoryObjsCollector::CollectMemVisitor::operator()(minst::Fcall& i) {
   }
   return res;
 }
+// the state of the filters, followed by the memobj of the inner function.
+std::shared_ptr<FunObjTree> MemoryObjsCollector::makeOversampleTree(minst::Fcall& i) {
+  auto res = std::make_shared<FunObjTree>(
+      FunObjTree{i.fname, false, {}, types::Alias{"", types::Tuple{{types::Ref{types::Void{}}}}}});
+  auto fun = getOversampledFun(i);
+  if (fun && !mir::getInstRef<minst::Function>(fun.value()).isrecursive) {
+    auto inner = traverseFunTree(fun.value());
+    if (!inner->memobjs.empty() || inner->hasself || inner->idle) {
+      res->memobjs.emplace_back(inner);
+      CollectMemVisitor::getTupleFromAlias(res->objtype).arg_types.emplace_back(inner->objtype);
+    }
+  }
+  result_map.emplace(i.fname, res);
+  return res;
+}
+
 ResultT MemoryObjsCollector::CollectMemVisitor::operator()(minst::MakeClosure& i) {
   return makeResfromHasSelf(false);
 }
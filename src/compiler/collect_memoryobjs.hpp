@@ -5,13 +5,24 @@
 #pragma once
 #include <unordered_set>
 #include "basic/mir.hpp"
+#include "compiler/ffi.hpp"
 namespace mimium {
 namespace minst = mir::instruction;
+// set by `idle(threshold,holdtime)` in a function body. The call site skips evaluation while
+// inputs and output have been below threshold for holdtime samples.
+struct IdleParams {
+  double threshold;
+  double holdtime;
+  // arguments measured as inputs, the ones given a non-constant value at some call site.
+  // parameters like a constant frequency do not keep the function awake.
+  std::vector<bool> watched = {};
+};
 struct FunObjTree {
   mir::valueptr fname;
   bool hasself = false;
   std::list<std::shared_ptr<FunObjTree>> memobjs;
   types::Value objtype;
+  std::optional<IdleParams> idle = std::nullopt;
 };
 
 using funobjmap = std::unordered_map<mir::valueptr, std::shared_ptr<FunObjTree>>;
@@ -20,6 +31,8 @@ class MemoryObjsCollector {
  public:
   MemoryObjsCollector() = default;
   funobjmap process(mir::blockptr toplevel);
+  // the function passed to oversample(fn,input,factor), if it is a known function or closure.
+  static std::optional<mir::valueptr> getOversampledFun(minst::Fcall const& i);
 
 #ifdef MIMIUM_DEBUG_BUILD
   void dump() const;
@@ -28,8 +41,16 @@ class MemoryObjsCollector {
 #endif
  private:
   std::shared_ptr<FunObjTree> traverseFunTree(mir::valueptr fun);
+  std::shared_ptr<FunObjTree> makeOversampleTree(minst::Fcall& i);
   static std::string indentHelper(int indent);
   static std::unordered_set<mir::valueptr> collectToplevelFuns(mir::blockptr toplevel);
+  static std::optional<IdleParams> extractIdleParams(minst::Function& f);
+  // finds the arguments of functions taking non-constant values at some call site, for idle.
+  void collectSignalArgs(mir::blockptr block);
+  std::unordered_map<const mir::Value*, std::vector<bool>> signal_args;
+  // functions used as values, whose call sites are unknown.
+  std::unordered_set<const mir::Value*> escaped_funs;
+  static double getConstantParam(mir::valueptr v);
   static std::optional<mir::valueptr> tryFindFunByName(std::unordered_set<mir::valueptr> fnset,
                                                        std::string const& name);
 
@@ -83,7 +104,7 @@ class MemoryObjsCollector {
    private:
     static bool isSelf(mir::valueptr val) { return std::holds_alternative<mir::Self>(*val); };
     static bool isExternalFunMemobj(const mir::ExternalSymbol& s) {
-      return s.name == "delay" || s.name == "mem";
+      return LLVMBuiltin::getMemobjType(s.name).has_value();
     }
     static ResultT makeResfromHasSelf(bool hasself);
     static void mergeResultTs(ResultT& dest, ResultT& src);
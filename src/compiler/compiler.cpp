@@ -45,12 +45,17 @@ AstPtr Compiler::loadSourceFile(const std::string& filename) {
 AstPtr Compiler::renameSymbols(AstPtr ast) { return symbolrenamer.rename(*ast); }
 TypeEnv& Compiler::typeInfer(AstPtr ast) { return typeinferer.infer(*ast); }
 
-mir::blockptr Compiler::generateMir(AstPtr ast) { return mirgenerator.generate(*ast); }
+mir::blockptr Compiler::generateMir(AstPtr ast) {
+  auto mir = mirgenerator.generate(*ast);
+  latency = lookaheadresolver.process(mir);
+  return mir;
+}
 mir::blockptr Compiler::closureConvert(mir::blockptr mir) { return closureconverter->convert(mir); }
 
 funobjmap Compiler::collectMemoryObjs(mir::blockptr mir) { return memobjcollector.process(mir); }
 
 llvm::Module& Compiler::generateLLVMIr(mir::blockptr mir, funobjmap const& funobjs) {
+  llvmgenerator.setLatency(latency);
   llvmgenerator.generateCode(mir, &funobjs);
   return llvmgenerator.getModule();
 }
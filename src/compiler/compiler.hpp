@@ -15,6 +15,7 @@
 #include "compiler/closure_convert.hpp"
 #include "compiler/codegen/llvmgenerator.hpp"
 #include "compiler/collect_memoryobjs.hpp"
+#include "compiler/lookahead_resolver.hpp"
 #include "compiler/mirgenerator.hpp"
 #include "compiler/symbolrenamer.hpp"
 #include "compiler/type_infer_visitor.hpp"
@@ -39,8 +40,14 @@ class MIMIUM_DLL_PUBLIC Compiler {
   mir::blockptr generateMir(AstPtr ast);
   mir::blockptr closureConvert(mir::blockptr mir);
   funobjmap collectMemoryObjs(mir::blockptr mir);
+  // latency added by lookahead, available after generateMir.
+  [[nodiscard]] int getLatency() const { return latency; }
 
   llvm::Module& generateLLVMIr(mir::blockptr mir, funobjmap const& funobjs);
+  // memory used by the program generated by generateLLVMIr.
+  [[nodiscard]] MemoryReport const& getMemoryReport() const {
+    return llvmgenerator.getMemoryReport();
+  }
   void dumpLLVMModule(std::ostream& out);
   std::unique_ptr<llvm::LLVMContext> moveLLVMCtx();
   std::unique_ptr<llvm::Module> moveLLVMModule() ;
@@ -51,6 +58,8 @@ class MIMIUM_DLL_PUBLIC Compiler {
   SymbolRenamer symbolrenamer;
   TypeInferer typeinferer;
   MirGenerator mirgenerator;
+  LookaheadResolver lookaheadresolver;
+  int latency = 0;
   std::shared_ptr<ClosureConverter> closureconverter;
   MemoryObjsCollector memobjcollector;
   LLVMGenerator llvmgenerator;
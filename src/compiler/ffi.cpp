@@ -4,17 +4,64 @@
 
 #include "compiler/ffi.hpp"
 #include <cmath>
-#include "sndfile.h"
+#include "compiler/builtin/arrayops.hpp"
+#include "compiler/builtin/context.hpp"
+#include "compiler/builtin/convolver.hpp"
+#include "compiler/builtin/datafile.hpp"
+#include "compiler/builtin/oversampler.hpp"
+#include "compiler/builtin/recurrence.hpp"
+#include "compiler/builtin/resampler.hpp"
+#include "compiler/builtin/samplepool.hpp"
+#include "compiler/builtin/sos.hpp"
+#include "compiler/builtin/stft.hpp"
+#include "compiler/builtin/wavetable.hpp"
+
+namespace {
+using mimium::builtin::Context;
+// array sizes are passed as double from mimium code.
+size_t toSize(double size) { return static_cast<size_t>(std::max(0.0, size)); }
+// length of an array operation, clamped to the extents of the arrays. nothing is processed for
+// writes to read-only arrays and while preparing.
+size_t arraySize(Context* ctx, double size, double* dst,
+                 std::initializer_list<const double*> srcs) {
+  if (ctx->isPreparing()) { return 0; }
+  size_t res = toSize(size);
+  if (dst != nullptr) { res = ctx->clampSize(dst, res, true); }
+  for (const auto* src : srcs) { res = ctx->clampSize(src, res); }
+  return res;
+}
+// samples in the pool are shared by runtimes, so the program gets a private copy it may modify.
+double* copySample(Context* ctx, mimium::builtin::SampleData const& sample) {
+  const size_t size = sample.frames * sample.channels;
+  double* res = ctx->allocateArray(size);
+  std::copy_n(sample.data.data(), size, res);
+  return res;
+}
+// state of newarray. the array itself is owned by the context.
+struct NewArray {
+  double* data;
+};
+}  // namespace
 
 extern "C"{
 MIMIUM_DLL_PUBLIC void dumpaddress(void* a) { std::cerr << a << "\n"; }
 
-MIMIUM_DLL_PUBLIC void printdouble(double d) { std::cout << d; }
-MIMIUM_DLL_PUBLIC void printlndouble(double d) { std::cout << d << "\n"; }
+// output and the random sequence are left untouched while the runtime prepares dsp.
+MIMIUM_DLL_PUBLIC void printdouble(double d) {
+  if (!Context::isPreparingThread()) { std::cout << d; }
+}
+MIMIUM_DLL_PUBLIC void printlndouble(double d) {
+  if (!Context::isPreparingThread()) { std::cout << d << "\n"; }
+}
 
-MIMIUM_DLL_PUBLIC void printlnstr(char* str) { std::cout << str << "\n"; }
+MIMIUM_DLL_PUBLIC void printlnstr(char* str) {
+  if (!Context::isPreparingThread()) { std::cout << str << "\n"; }
+}
 
-MIMIUM_DLL_PUBLIC double mimiumrand() { return ((double)rand() / RAND_MAX) * 2 - 1; }
+MIMIUM_DLL_PUBLIC double mimiumrand() {
+  if (Context::isPreparingThread()) { return 0.0; }
+  return ((double)rand() / RAND_MAX) * 2 - 1;
+}
 
 MIMIUM_DLL_PUBLIC bool mimium_dtob(double d) { return d > 0; }
 MIMIUM_DLL_PUBLIC int64_t mimium_dtoi(double d) { return static_cast<int64_t>(d); }
@@ -66,26 +113,189 @@ MIMIUM_DLL_PUBLIC double mimium_delayprim(double in, double time, MmmRingBuf* rb
   return access_array_lin_interp(rbuf->buf, readi);
 }
 
+// idle() is removed by the compiler and never called. defined so that every builtin resolves.
+MIMIUM_DLL_PUBLIC void mimium_idle(double /*threshold*/, double /*holdtime*/) {}
+
+// convolver is created at first call, pointer to it is held in the memory object.
+MIMIUM_DLL_PUBLIC double mimium_convolve(mimium::builtin::Context* ctx, double in, double* ir,
+                                         double irsize, void** state) {
+  auto* conv = ctx->getState<mimium::builtin::Convolver>(
+      state, [&]() { return mimium::builtin::createConvolver(*ctx, ir, toSize(irsize)); });
+  return ctx->isPreparing() ? 0.0 : conv->process(in);
+}
+
+// parameters are fixed at first call. fn is called for each frame at every hop.
+MIMIUM_DLL_PUBLIC double mimium_stft(mimium::builtin::Context* ctx, double in, double fftsize,
+                                     double hop, double window, mimium::builtin::SpectralFn fn,
+                                     void** state) {
+  auto* stft = ctx->getState<mimium::builtin::Stft>(
+      state, [&]() { return mimium::builtin::createStft(fftsize, hop, window); });
+  return ctx->isPreparing() ? 0.0 : stft->process(in, fn);
+}
+
+namespace {
+// band-limited oscillators. the table is shared by the calls in a runtime.
+double processBandLimited(mimium::builtin::Context* ctx, mimium::builtin::Waveform waveform,
+                          double freq, void** state) {
+  using namespace mimium::builtin;  // NOLINT
+  auto* osc = ctx->getState<WavetableOscillator>(
+      state, [&]() { return createOscillator(*ctx, waveform); });
+  return ctx->isPreparing() ? 0.0 : osc->process(freq, ctx->getSampleRate());
+}
+}  // namespace
+MIMIUM_DLL_PUBLIC double mimium_blsaw(mimium::builtin::Context* ctx, double freq, void** state) {
+  return processBandLimited(ctx, mimium::builtin::Waveform::Saw, freq, state);
+}
+MIMIUM_DLL_PUBLIC double mimium_blsquare(mimium::builtin::Context* ctx, double freq,
+                                         void** state) {
+  return processBandLimited(ctx, mimium::builtin::Waveform::Square, freq, state);
+}
+MIMIUM_DLL_PUBLIC double mimium_bltri(mimium::builtin::Context* ctx, double freq, void** state) {
+  return processBandLimited(ctx, mimium::builtin::Waveform::Triangle, freq, state);
+}
+// the table is generated from the array at first call and shared with calls with the same array
+// contents.
+MIMIUM_DLL_PUBLIC double mimium_wavetable(mimium::builtin::Context* ctx, double freq,
+                                          double* array, double size, void** state) {
+  using namespace mimium::builtin;  // NOLINT
+  auto* osc = ctx->getState<WavetableOscillator>(
+      state, [&]() { return createOscillator(*ctx, array, toSize(size)); });
+  return ctx->isPreparing() ? 0.0 : osc->process(freq, ctx->getSampleRate());
+}
+
+// cascade of biquads. coeffs has b0,b1,b2,a1,a2 for each section.
+MIMIUM_DLL_PUBLIC double mimium_sos(mimium::builtin::Context* ctx, double in, double* coeffs,
+                                    double nsections, double* state) {
+  return mimium::builtin::sos::process(in, coeffs, toSize(nsections), state,
+                                       ctx->getSampleRate());
+}
+// the number of channels is fixed at first call. returns the output frame.
+MIMIUM_DLL_PUBLIC double* mimium_sosmulti(mimium::builtin::Context* ctx, double* in, double nch,
+                                          double* coeffs, double nsections, void** state) {
+  auto* filter = ctx->getState<mimium::builtin::SosFilter>(state, [&]() {
+    return mimium::builtin::createSosFilter(toSize(nch), ctx->getSampleRate());
+  });
+  const double* res =
+      ctx->isPreparing() ? filter->getFrame() : filter->process(in, coeffs, toSize(nsections));
+  return const_cast<double*>(res);
+}
+
+// called around the inner function of oversample(fn,input,factor). see CodeGenVisitor.
+MIMIUM_DLL_PUBLIC double* mimium_oversample_up(mimium::builtin::Context* ctx, double in,
+                                               double factor, void** state) {
+  auto* os = ctx->getState<mimium::builtin::Oversampler>(
+      state, [&]() { return mimium::builtin::createOversampler(*ctx, toSize(factor)); });
+  return ctx->isPreparing() ? os->skip() : os->upsample(in);
+}
+MIMIUM_DLL_PUBLIC double mimium_oversample_down(void** state) {
+  return static_cast<mimium::builtin::Oversampler*>(*state)->downsample();
+}
+
+// block evaluation of recurrences found in the frame loop of dsp.block by SampleLoopSplitter.
+MIMIUM_DLL_PUBLIC void mimium_recurrence1(const double* u, double* y, int32_t n, double b1,
+                                          double* y1) {
+  mimium::builtin::recurrence::firstOrder(u, y, static_cast<size_t>(n), b1, *y1);
+}
+MIMIUM_DLL_PUBLIC void mimium_recurrence2(const double* u, double* y, int32_t n, double b1,
+                                          double b2, double* y1, double* y2) {
+  mimium::builtin::recurrence::secondOrder(u, y, static_cast<size_t>(n), b1, b2, *y1, *y2);
+}
+
+// bulk array operations. functions writing to an array return the destination for chaining.
+// each call site of newarray owns one array allocated at its first call, so calling it in dsp
+// does not allocate on the audio thread. the size is fixed at first call.
+MIMIUM_DLL_PUBLIC double* mimium_newarray(Context* ctx, double size, void** state) {
+  return ctx->getState<NewArray>(state, [&]() {
+    return std::make_unique<NewArray>(NewArray{ctx->allocateArray(toSize(size), true)});
+  })->data;
+}
+MIMIUM_DLL_PUBLIC double* mimium_arrayfill(Context* ctx, double* dst, double value, double size) {
+  mimium::builtin::array::fill(dst, value, arraySize(ctx, size, dst, {}));
+  return dst;
+}
+MIMIUM_DLL_PUBLIC double* mimium_arraycopy(Context* ctx, double* dst, double* src, double size) {
+  mimium::builtin::array::copy(dst, src, arraySize(ctx, size, dst, {src}));
+  return dst;
+}
+MIMIUM_DLL_PUBLIC double* mimium_arrayadd(Context* ctx, double* dst, double* a, double* b,
+                                          double size) {
+  mimium::builtin::array::add(dst, a, b, arraySize(ctx, size, dst, {a, b}));
+  return dst;
+}
+MIMIUM_DLL_PUBLIC double* mimium_arraysub(Context* ctx, double* dst, double* a, double* b,
+                                          double size) {
+  mimium::builtin::array::sub(dst, a, b, arraySize(ctx, size, dst, {a, b}));
+  return dst;
+}
+MIMIUM_DLL_PUBLIC double* mimium_arraymul(Context* ctx, double* dst, double* a, double* b,
+                                          double size) {
+  mimium::builtin::array::mul(dst, a, b, arraySize(ctx, size, dst, {a, b}));
+  return dst;
+}
+MIMIUM_DLL_PUBLIC double* mimium_arraydiv(Context* ctx, double* dst, double* a, double* b,
+                                          double size) {
+  mimium::builtin::array::div(dst, a, b, arraySize(ctx, size, dst, {a, b}));
+  return dst;
+}
+MIMIUM_DLL_PUBLIC double* mimium_arrayscale(Context* ctx, double* dst, double* src, double gain,
+                                            double offset, double size) {
+  mimium::builtin::array::scale(dst, src, gain, offset, arraySize(ctx, size, dst, {src}));
+  return dst;
+}
+MIMIUM_DLL_PUBLIC double mimium_arraydot(Context* ctx, double* a, double* b, double size) {
+  return mimium::builtin::array::dot(a, b, arraySize(ctx, size, nullptr, {a, b}));
+}
+MIMIUM_DLL_PUBLIC double mimium_arraysum(Context* ctx, double* src, double size) {
+  return mimium::builtin::array::sum(src, arraySize(ctx, size, nullptr, {src}));
+}
+MIMIUM_DLL_PUBLIC double mimium_arraymin(Context* ctx, double* src, double size) {
+  return mimium::builtin::array::min(src, arraySize(ctx, size, nullptr, {src}));
+}
+MIMIUM_DLL_PUBLIC double mimium_arraymax(Context* ctx, double* src, double size) {
+  return mimium::builtin::array::max(src, arraySize(ctx, size, nullptr, {src}));
+}
+MIMIUM_DLL_PUBLIC double* mimium_arraymap(Context* ctx, double* dst, double* src, double size,
+                                          mimium::builtin::array::MapFn fn) {
+  mimium::builtin::array::map(dst, src, arraySize(ctx, size, dst, {src}), fn);
+  return dst;
+}
+MIMIUM_DLL_PUBLIC double mimium_arrayfold(Context* ctx, double* src, double size, double init,
+                                          mimium::builtin::array::FoldFn fn) {
+  return mimium::builtin::array::fold(src, arraySize(ctx, size, nullptr, {src}), init, fn);
+}
+
 MIMIUM_DLL_PUBLIC double libsndfile_loadwavsize(char* filename) {
-  SF_INFO sfinfo;
-  auto* sfile = sf_open(filename, SFM_READ, &sfinfo);
-  if (sfile == nullptr) { std::cerr << sf_strerror(sfile) << "\n"; }
-  auto res = sfinfo.frames;
-  sf_close(sfile);
-  return res;
+  return mimium::builtin::SamplePool::load(filename).frames;
+}
+
+// each call returns its own copy, released with the runtime.
+MIMIUM_DLL_PUBLIC double* libsndfile_loadwav(Context* ctx, char* filename) {
+  return copySample(ctx, mimium::builtin::SamplePool::load(filename));
+}
+
+MIMIUM_DLL_PUBLIC double libsndfile_loadwavsize_sr(char* filename, double samplerate) {
+  return mimium::builtin::SamplePool::loadResampled(filename, samplerate).frames;
 }
 
-MIMIUM_DLL_PUBLIC double* libsndfile_loadwav(char* filename) {
-  SF_INFO sfinfo;
-  auto* sfile = sf_open(filename, SFM_READ, &sfinfo);
-  if (sfile == nullptr) { std::cerr << sf_strerror(sfile) << "\n"; }
+MIMIUM_DLL_PUBLIC double* libsndfile_loadwav_sr(Context* ctx, char* filename, double samplerate) {
+  return copySample(ctx, mimium::builtin::SamplePool::loadResampled(filename, samplerate));
+}
 
-  const int bufsize = sfinfo.frames * sfinfo.channels;
-  double* buffer = new double[bufsize];
-  sf_readf_double(sfile, buffer, bufsize);
-  // sf_close(sfile);
-  // std::cerr<< filename << "(" << size << ") is succecfully loaded";
-  return buffer;
+// each call imports a private copy, released with the runtime.
+MIMIUM_DLL_PUBLIC double* mimium_loaddata(Context* ctx, char* filename) {
+  return mimium::builtin::DataFile::load(*ctx, filename).data;
+}
+MIMIUM_DLL_PUBLIC double mimium_loaddatasize(char* filename) {
+  return static_cast<double>(mimium::builtin::DataFile::getSize(filename));
+}
+
+// band-limited interpolation for variable-rate playback. quality: 0(fast) to 3(best)
+MIMIUM_DLL_PUBLIC double mimium_readsinc(Context* ctx, double* array, double size, double pos,
+                                         double speed, double quality) {
+  auto q = static_cast<mimium::builtin::ResampleQuality>(std::clamp(
+      static_cast<int>(quality), 0, static_cast<int>(mimium::builtin::ResampleQuality::Best)));
+  return mimium::builtin::SincKernel::get(q).read(array, ctx->clampSize(array, toSize(size)), pos,
+                                                  std::abs(speed));
 }
 }
 
@@ -143,15 +353,205 @@ const std::unordered_map<std::string, BuiltinFnInfo> LLVMBuiltin::ftable = {
     {"lshift", initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_lshift")},
     {"rshift", initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_rshift")},
 
-    {"mem", initBI(Function{Float{}, {Float{}}}, "mimium_memprim")},
-    {"delay", initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_delayprim")},
+    {"mem", initBI(Function{Float{}, {Float{}}}, "mimium_memprim", Float{})},
+    {"delay", initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_delayprim", getDelayStruct())},
+    // eventseq(fn,times,values,size) calls fn(values[i]) at times[i]. times must be sorted, or
+    // the call is ignored.
+    {"eventseq", initRuntimeBI(Function{Void{}, {Function{Void{}, {Float{}}}, Array{Float{}, 0},
+                                                 Array{Float{}, 0}, Float{}}},
+                               "mimium_addeventstream")},
+    // idle(threshold,holdtime) is consumed by the compiler(see MemoryObjsCollector).
+    {"idle", initBI(Function{Void{}, {Float{}, Float{}}}, "mimium_idle")},
+    // oversample(fn,input,factor) evaluates fn at 2, 4 or 8 times of the sample rate. expanded by
+    // the code generator, and the memobj of fn is held at the call site.
+    {"oversample", initBI(Function{Float{}, {Function{Float{}, {Float{}}}, Float{}, Float{}}},
+                          "", Ref{Void{}})},
+    // lookahead(x,n) is replaced to a delay by the compiler(see LookaheadResolver).
+    {"lookahead",
+     initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_delayprim", getDelayStruct())},
+    {"convolve", initContextBI(Function{Float{}, {Float{}, Array{Float{}, 0}, Float{}}},
+                               "mimium_convolve", Ref{Void{}})},
+    // stft(input,fftsize,hop,window,fn(mag,phase,nbins)), fn modifies the arrays in place.
+    {"stft", initContextBI(
+                 Function{Float{},
+                          {Float{}, Float{}, Float{}, Float{},
+                           Function{Void{}, {Array{Float{}, 0}, Array{Float{}, 0}, Float{}}}}},
+                 "mimium_stft", Ref{Void{}})},
+    {"blsaw", initContextBI(Function{Float{}, {Float{}}}, "mimium_blsaw", Ref{Void{}})},
+    {"blsquare", initContextBI(Function{Float{}, {Float{}}}, "mimium_blsquare", Ref{Void{}})},
+    {"bltri", initContextBI(Function{Float{}, {Float{}}}, "mimium_bltri", Ref{Void{}})},
+    // wavetable(freq,array,size) reads a single cycle stored in the array.
+    {"wavetable", initContextBI(Function{Float{}, {Float{}, Array{Float{}, 0}, Float{}}},
+                                "mimium_wavetable", Ref{Void{}})},
+    // sos(input,coeffs,nsections), coeffs are b0,b1,b2,a1,a2 for each section(up to 8).
+    {"sos", initContextBI(Function{Float{}, {Float{}, Array{Float{}, 0}, Float{}}}, "mimium_sos",
+                          Array{Float{}, static_cast<int>(builtin::sos::state_size)})},
+    // sosmulti(input_array,nch,coeffs,nsections) returns output array.
+    {"sosmulti", initContextBI(Function{Array{Float{}, 0}, {Array{Float{}, 0}, Float{},
+                                                            Array{Float{}, 0}, Float{}}},
+                               "mimium_sosmulti", Ref{Void{}})},
+    // array operations. the size of arrays is given by the last argument.
+    {"newarray",
+     initContextBI(Function{Array{Float{}, 0}, {Float{}}}, "mimium_newarray", Ref{Void{}})},
+    {"arrayfill",
+     initContextBI(Function{Array{Float{}, 0}, {Array{Float{}, 0}, Float{}, Float{}}},
+                   "mimium_arrayfill")},
+    {"arraycopy",
+     initContextBI(Function{Array{Float{}, 0}, {Array{Float{}, 0}, Array{Float{}, 0}, Float{}}},
+                   "mimium_arraycopy")},
+    {"arrayadd", initContextBI(Function{Array{Float{}, 0}, {Array{Float{}, 0}, Array{Float{}, 0},
+                                                            Array{Float{}, 0}, Float{}}},
+                               "mimium_arrayadd")},
+    {"arraysub", initContextBI(Function{Array{Float{}, 0}, {Array{Float{}, 0}, Array{Float{}, 0},
+                                                            Array{Float{}, 0}, Float{}}},
+                               "mimium_arraysub")},
+    {"arraymul", initContextBI(Function{Array{Float{}, 0}, {Array{Float{}, 0}, Array{Float{}, 0},
+                                                            Array{Float{}, 0}, Float{}}},
+                               "mimium_arraymul")},
+    {"arraydiv", initContextBI(Function{Array{Float{}, 0}, {Array{Float{}, 0}, Array{Float{}, 0},
+                                                            Array{Float{}, 0}, Float{}}},
+                               "mimium_arraydiv")},
+    // arrayscale(dst,src,gain,offset,size)
+    {"arrayscale", initContextBI(Function{Array{Float{}, 0}, {Array{Float{}, 0}, Array{Float{}, 0},
+                                                              Float{}, Float{}, Float{}}},
+                                 "mimium_arrayscale")},
+    {"arraydot", initContextBI(Function{Float{}, {Array{Float{}, 0}, Array{Float{}, 0}, Float{}}},
+                               "mimium_arraydot")},
+    {"arraysum",
+     initContextBI(Function{Float{}, {Array{Float{}, 0}, Float{}}}, "mimium_arraysum")},
+    {"arraymin",
+     initContextBI(Function{Float{}, {Array{Float{}, 0}, Float{}}}, "mimium_arraymin")},
+    {"arraymax",
+     initContextBI(Function{Float{}, {Array{Float{}, 0}, Float{}}}, "mimium_arraymax")},
+    // arraymap(dst,src,size,fn(x)), arrayfold(src,size,init,fn(acc,x))
+    {"arraymap", initContextBI(Function{Array{Float{}, 0}, {Array{Float{}, 0}, Array{Float{}, 0},
+                                                            Float{}, Function{Float{}, {Float{}}}}},
+                               "mimium_arraymap")},
+    {"arrayfold", initContextBI(Function{Float{}, {Array{Float{}, 0}, Float{}, Float{},
+                                                   Function{Float{}, {Float{}, Float{}}}}},
+                                "mimium_arrayfold")},
 
     {"loadwavsize", initBI(Function{Float{}, {String{}}}, "libsndfile_loadwavsize")},
-    {"loadwav", initBI(Function{Array{Float{}, 0}, {String{}}}, "libsndfile_loadwav")},
+    {"loadwav", initContextBI(Function{Array{Float{}, 0}, {String{}}}, "libsndfile_loadwav")},
+    // load with converting sample rate
+    {"loadwavsizesr", initBI(Function{Float{}, {String{}, Float{}}}, "libsndfile_loadwavsize_sr")},
+    {"loadwavsr", initContextBI(Function{Array{Float{}, 0}, {String{}, Float{}}},
+                                "libsndfile_loadwav_sr")},
+    // read-only array from a raw float64 file(memory-mapped) or an audio file.
+    {"loaddata", initContextBI(Function{Array{Float{}, 0}, {String{}}}, "mimium_loaddata")},
+    {"loaddatasize", initBI(Function{Float{}, {String{}}}, "mimium_loaddatasize")},
+    // readsinc(array,size,position,speed,quality)
+    {"readsinc",
+     initContextBI(Function{Float{}, {Array{Float{}, 0}, Float{}, Float{}, Float{}, Float{}}},
+                   "mimium_readsinc")},
 
     {"access_array_lin_interp",
      initBI(Function{Float{}, {Float{}, Float{}}}, "access_array_lin_interp")}
 
 };
 
+std::optional<size_t> LLVMBuiltin::getArraySizeArg(std::string const& fname) {
+  static const std::unordered_map<std::string, size_t> size_args = {
+      {"convolve", 2},  {"wavetable", 2}, {"readsinc", 1},  {"arrayfill", 2}, {"arraycopy", 2},
+      {"arrayadd", 3},  {"arraysub", 3},  {"arraymul", 3},  {"arraydiv", 3},  {"arrayscale", 4},
+      {"arraydot", 2},  {"arraysum", 1},  {"arraymin", 1},  {"arraymax", 1},  {"arraymap", 2},
+      {"arrayfold", 1}, {"eventseq", 3}};
+  auto iter = size_args.find(fname);
+  return iter != size_args.cend() ? std::optional(iter->second) : std::nullopt;
+}
+
+#define MMM_SYMBOL(name) \
+  { #name, reinterpret_cast<void*>(&(name)) }  // NOLINT
+#define MMM_MATH_SYMBOL(name, type) \
+  { #name, reinterpret_cast<void*>(static_cast<type>(&(name))) }  // NOLINT
+
+// addresses of the functions called from generated code, defined in the JIT before linking so that
+// they are not searched in the process. exp2 and log2 may be introduced by the optimizer.
+const std::unordered_map<std::string, void*> LLVMBuiltin::symbols = {
+    MMM_SYMBOL(dumpaddress),
+    MMM_SYMBOL(printdouble),
+    MMM_SYMBOL(printlndouble),
+    MMM_SYMBOL(printlnstr),
+    MMM_SYMBOL(mimiumrand),
+    MMM_SYMBOL(mimium_dtob),
+    MMM_SYMBOL(mimium_dtoi),
+    MMM_SYMBOL(mimium_gt),
+    MMM_SYMBOL(mimium_lt),
+    MMM_SYMBOL(mimium_ge),
+    MMM_SYMBOL(mimium_eq),
+    MMM_SYMBOL(mimium_noteq),
+    MMM_SYMBOL(mimium_le),
+    MMM_SYMBOL(mimium_and),
+    MMM_SYMBOL(mimium_or),
+    MMM_SYMBOL(mimium_not),
+    MMM_SYMBOL(mimium_lshift),
+    MMM_SYMBOL(mimium_rshift),
+    MMM_SYMBOL(access_array_lin_interp),
+    MMM_SYMBOL(mimium_memprim),
+    MMM_SYMBOL(mimium_delayprim),
+    MMM_SYMBOL(mimium_idle),
+    MMM_SYMBOL(mimium_convolve),
+    MMM_SYMBOL(mimium_stft),
+    MMM_SYMBOL(mimium_blsaw),
+    MMM_SYMBOL(mimium_blsquare),
+    MMM_SYMBOL(mimium_bltri),
+    MMM_SYMBOL(mimium_wavetable),
+    MMM_SYMBOL(mimium_sos),
+    MMM_SYMBOL(mimium_sosmulti),
+    MMM_SYMBOL(mimium_oversample_up),
+    MMM_SYMBOL(mimium_oversample_down),
+    MMM_SYMBOL(mimium_recurrence1),
+    MMM_SYMBOL(mimium_recurrence2),
+    MMM_SYMBOL(mimium_newarray),
+    MMM_SYMBOL(mimium_arrayfill),
+    MMM_SYMBOL(mimium_arraycopy),
+    MMM_SYMBOL(mimium_arrayadd),
+    MMM_SYMBOL(mimium_arraysub),
+    MMM_SYMBOL(mimium_arraymul),
+    MMM_SYMBOL(mimium_arraydiv),
+    MMM_SYMBOL(mimium_arrayscale),
+    MMM_SYMBOL(mimium_arraydot),
+    MMM_SYMBOL(mimium_arraysum),
+    MMM_SYMBOL(mimium_arraymin),
+    MMM_SYMBOL(mimium_arraymax),
+    MMM_SYMBOL(mimium_arraymap),
+    MMM_SYMBOL(mimium_arrayfold),
+    MMM_SYMBOL(libsndfile_loadwavsize),
+    MMM_SYMBOL(libsndfile_loadwav),
+    MMM_SYMBOL(libsndfile_loadwavsize_sr),
+    MMM_SYMBOL(libsndfile_loadwav_sr),
+    MMM_SYMBOL(mimium_loaddata),
+    MMM_SYMBOL(mimium_loaddatasize),
+    MMM_SYMBOL(mimium_readsinc),
+    MMM_MATH_SYMBOL(sin, double (*)(double)),
+    MMM_MATH_SYMBOL(cos, double (*)(double)),
+    MMM_MATH_SYMBOL(tan, double (*)(double)),
+    MMM_MATH_SYMBOL(asin, double (*)(double)),
+    MMM_MATH_SYMBOL(acos, double (*)(double)),
+    MMM_MATH_SYMBOL(atan, double (*)(double)),
+    MMM_MATH_SYMBOL(sinh, double (*)(double)),
+    MMM_MATH_SYMBOL(cosh, double (*)(double)),
+    MMM_MATH_SYMBOL(tanh, double (*)(double)),
+    MMM_MATH_SYMBOL(exp, double (*)(double)),
+    MMM_MATH_SYMBOL(exp2, double (*)(double)),
+    MMM_MATH_SYMBOL(log, double (*)(double)),
+    MMM_MATH_SYMBOL(log10, double (*)(double)),
+    MMM_MATH_SYMBOL(log2, double (*)(double)),
+    MMM_MATH_SYMBOL(sqrt, double (*)(double)),
+    MMM_MATH_SYMBOL(fabs, double (*)(double)),
+    MMM_MATH_SYMBOL(ceil, double (*)(double)),
+    MMM_MATH_SYMBOL(floor, double (*)(double)),
+    MMM_MATH_SYMBOL(trunc, double (*)(double)),
+    MMM_MATH_SYMBOL(round, double (*)(double)),
+    MMM_MATH_SYMBOL(atan2, double (*)(double, double)),
+    MMM_MATH_SYMBOL(pow, double (*)(double, double)),
+    MMM_MATH_SYMBOL(fmod, double (*)(double, double)),
+    MMM_MATH_SYMBOL(remainder, double (*)(double, double)),
+    MMM_MATH_SYMBOL(fmin, double (*)(double, double)),
+    MMM_MATH_SYMBOL(fmax, double (*)(double, double))
+};
+
+#undef MMM_SYMBOL
+#undef MMM_MATH_SYMBOL
+
 }  // namespace mimium
\ No newline at end of file
@@ -6,6 +6,7 @@
 #define LLVM_DISABLE_ABI_BREAKING_CHECKS_ENFORCING 1
 #include "export.hpp"
 #include <initializer_list>
+#include <optional>
 #include <unordered_map>
 
 // #include "compiler/runtime/mididriver.hpp"
@@ -15,16 +16,66 @@ namespace mimium {
 
 struct BuiltinFnInfo {
   types::Value mmmtype;
+  // empty for builtins expanded by the code generator(oversample).
   std::string target_fnname;
+  // type of internal state for each call site(memory object), for stateful functions like delay.
+  // pointer to the object is passed as a last argument of the target function.
+  std::optional<types::Value> memobjtype = std::nullopt;
+  // the function is implemented in the runtime and takes the runtime instance as a first argument.
+  bool takes_runtime = false;
+  // the function takes the builtin::Context of the runtime as a first argument, to own its state.
+  bool takes_context = false;
 };
 
 inline BuiltinFnInfo initBI(types::Function&& f, std::string&& s) {
   return BuiltinFnInfo{std::move(f), std::move(s)};
 }
+inline BuiltinFnInfo initBI(types::Function&& f, std::string&& s, types::Value&& memobjtype) {
+  return BuiltinFnInfo{std::move(f), std::move(s), std::move(memobjtype)};
+}
+inline BuiltinFnInfo initRuntimeBI(types::Function&& f, std::string&& s) {
+  return BuiltinFnInfo{std::move(f), std::move(s), std::nullopt, true};
+}
+inline BuiltinFnInfo initContextBI(types::Function&& f, std::string&& s) {
+  return BuiltinFnInfo{std::move(f), std::move(s), std::nullopt, false, true};
+}
+inline BuiltinFnInfo initContextBI(types::Function&& f, std::string&& s,
+                                   types::Value&& memobjtype) {
+  return BuiltinFnInfo{std::move(f), std::move(s), std::move(memobjtype), false, true};
+}
 
 struct MIMIUM_DLL_PUBLIC LLVMBuiltin {
   const static std::unordered_map<std::string, BuiltinFnInfo> ftable;
+  // target functions of ftable and helpers called from generated code by their symbol names.
+  const static std::unordered_map<std::string, void*> symbols;
   static bool isBuiltin(std::string fname) { return LLVMBuiltin::ftable.count(fname) > 0; }
+  static std::optional<types::Value> getMemobjType(std::string const& fname) {
+    auto iter = LLVMBuiltin::ftable.find(fname);
+    return iter != LLVMBuiltin::ftable.cend() ? iter->second.memobjtype : std::nullopt;
+  }
+  static bool takesRuntime(std::string const& fname) {
+    auto iter = LLVMBuiltin::ftable.find(fname);
+    return iter != LLVMBuiltin::ftable.cend() && iter->second.takes_runtime;
+  }
+  static bool takesContext(std::string const& fname) {
+    auto iter = LLVMBuiltin::ftable.find(fname);
+    return iter != LLVMBuiltin::ftable.cend() && iter->second.takes_context;
+  }
+  // index of the argument giving the number of elements of the array arguments, which the code
+  // generator clamps to the length of fixed-size arrays.
+  static std::optional<size_t> getArraySizeArg(std::string const& fname);
+  // numeric functions without state, whose result depends only on the arguments(e.g. sin, max).
+  static bool isPure(std::string const& fname) {
+    auto iter = LLVMBuiltin::ftable.find(fname);
+    if (iter == LLVMBuiltin::ftable.cend() || iter->second.memobjtype ||
+        iter->second.takes_runtime || iter->second.takes_context) {
+      return false;
+    }
+    const auto& ftype = rv::get<types::Function>(iter->second.mmmtype);
+    auto isfloat = [](types::Value const& t) { return std::holds_alternative<types::Float>(t); };
+    return isfloat(ftype.ret_type) && !ftype.arg_types.empty() &&
+           std::all_of(ftype.arg_types.begin(), ftype.arg_types.end(), isfloat);
+  }
 };
 
 }  // namespace mimium
\ No newline at end of file
@@ -0,0 +1,389 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/lookahead_resolver.hpp"
+#include <array>
+#include <unordered_map>
+#include <unordered_set>
+#include "compiler/builtin/oversampler.hpp"
+#include "compiler/builtin/stft.hpp"
+#include "compiler/ffi.hpp"
+
+namespace mimium {
+
+namespace {
+template <class ITYPE>
+ITYPE* getInstPtr(mir::valueptr const& v) {
+  auto* inst = std::get_if<mir::Instructions>(v.get());
+  return inst != nullptr ? std::get_if<ITYPE>(inst) : nullptr;
+}
+
+bool isFloat(mir::valueptr const& v) { return types::isA<types::Float>(mir::getType(*v)); }
+
+const auto delaytype = types::Function{types::Float{}, {types::Float{}, types::Float{}}};
+
+// Delays signals not going through lookahead to align them with the ones going through it.
+// Each value has an offset, the samples by which it lags behind the program running ahead: 0 for
+// dry signals(arguments, states and what is computed from them) and the latency for the outputs
+// of lookahead, stft and oversample. Constants have no offset. Operands of an instruction are
+// delayed to the largest offset among them, and the outputs of dsp to the latency.
+// Functions are analyzed once with their arguments at 0. Functions reading ahead must be called
+// with dry arguments, and others take the offset of their arguments.
+class DryPathAligner {
+ public:
+  DryPathAligner(int latency, std::unordered_set<const mir::Value*> ahead)
+      : latency(latency), ahead(std::move(ahead)) {}
+  void process(mir::blockptr toplevel) {
+    for (auto& v : toplevel->instructions) {
+      if (auto* f = getInstPtr<minst::Function>(v)) { visitFunction(v, f->name == "dsp"); }
+    }
+  }
+
+ private:
+  static constexpr int no_offset = -1;
+  int latency;
+  // lookahead and stft calls, and the delays compensating stft.
+  std::unordered_set<const mir::Value*> ahead;
+  // offsets of values, and of variables by the allocation and the field.
+  std::unordered_map<const mir::Value*, int> offsets;
+  // offsets of return values, which are also the ones of self.
+  std::unordered_map<const mir::Value*, int> fn_offsets;
+  std::unordered_set<const mir::Value*> reads_ahead;
+  // false while finding offsets before delays are inserted.
+  bool inserting = false;
+  size_t count = 0;
+  struct Scope {
+    const mir::Value* fn;
+    bool isdsp;
+  };
+  Scope scope{};
+
+  int offsetOf(mir::valueptr const& v) const {
+    return std::visit(overloaded{[&](mir::Instructions const& /*i*/) {
+                                   auto iter = offsets.find(v.get());
+                                   return iter != offsets.end() ? iter->second : no_offset;
+                                 },
+                                 [](std::shared_ptr<mir::Argument> const& /*a*/) { return 0; },
+                                 [&](mir::Self const& s) {
+                                   auto iter = fn_offsets.find(s.fn.get());
+                                   return iter != fn_offsets.end() ? std::max(iter->second, 0) : 0;
+                                 },
+                                 [](auto const& /*constant or external*/) { return no_offset; }},
+                      *v);
+  }
+  void raise(mir::valueptr const& v, int offset) {
+    auto [iter, inserted] = offsets.try_emplace(v.get(), offset);
+    if (!inserted) { iter->second = std::max(iter->second, offset); }
+  }
+
+  void visitFunction(mir::valueptr const& fn, bool isdsp) {
+    auto& f = mir::getInstRef<minst::Function>(fn);
+    auto saved = scope;
+    scope = Scope{fn.get(), isdsp};
+    const bool saved_inserting = inserting;
+    // the offset of self depends on the return value, which is found by repeating the analysis
+    // until it settles(it only rises). the outputs of dsp are aligned to the latency.
+    fn_offsets[fn.get()] = isdsp ? latency : no_offset;
+    inserting = false;
+    for (int i = 0; i < 3; i++) {
+      const int res = visitBlock(f.body, true);
+      if (isdsp || res == fn_offsets[fn.get()]) { break; }
+      fn_offsets[fn.get()] = res;
+    }
+    inserting = true;
+    const int res = visitBlock(f.body, true);
+    if (!isdsp) { fn_offsets[fn.get()] = res; }
+    inserting = saved_inserting;
+    scope = saved;
+  }
+
+  using iterator = std::list<mir::valueptr>::iterator;
+
+  mir::valueptr makeDelay(mir::blockptr const& block, iterator pos, mir::valueptr const& v,
+                          int time) {
+    auto name = mir::getName(*v) + ".aligned" + std::to_string(count++);
+    auto delaytime = std::make_shared<mir::Value>(
+        minst::Number{{name + ".time", types::Float{}, block}, static_cast<double>(time)});
+    auto fname = std::make_shared<mir::Value>(mir::ExternalSymbol{"delay", delaytype});
+    auto delayed = std::make_shared<mir::Value>(
+        minst::Fcall{{name, types::Float{}, block}, fname, {v, delaytime}, EXTERNAL, std::nullopt});
+    block->instructions.insert(pos, delaytime);
+    block->instructions.insert(pos, delayed);
+    offsets[delayed.get()] = offsetOf(v) + time;
+    return delayed;
+  }
+  // delays float operands to the largest offset among them, or to `target` if given.
+  template <class Operands>
+  int align(mir::blockptr const& block, iterator pos, Operands const& operands,
+            int target = no_offset) {
+    for (mir::valueptr* v : operands) { target = std::max(target, offsetOf(*v)); }
+    if (!inserting) { return target; }
+    for (mir::valueptr* v : operands) {
+      const int offset = offsetOf(*v);
+      if (offset != no_offset && offset < target && isFloat(*v)) {
+        *v = makeDelay(block, pos, *v, target - offset);
+      }
+    }
+    return target;
+  }
+  int alignOne(mir::blockptr const& block, iterator pos, mir::valueptr& v, int target) {
+    return align(block, pos, std::array<mir::valueptr*, 1>{&v}, target);
+  }
+
+  // aligns each field of the tuple returned from dsp before it is loaded.
+  void alignOutputs(mir::blockptr const& block, iterator load, mir::valueptr const& tuple) {
+    auto type = mir::getInstRef<minst::Load>(*load).type;
+    if (auto ptype = types::getIf<types::rPointer>(type)) { type = ptype.value().getraw().val; }
+    auto ttype = types::getIf<types::rTuple>(type);
+    if (!ttype) {
+      Logger::debug_log("outputs of dsp can not be aligned with lookahead", Logger::WARNING);
+      return;
+    }
+    auto const& elems = ttype.value().getraw().arg_types;
+    for (size_t i = 0; i < elems.size(); i++) {
+      auto field = fields.find({tuple.get(), i});
+      auto fieldoffset = field != fields.end() ? offsets.find(field->second) : offsets.end();
+      const int offset = fieldoffset != offsets.end() ? fieldoffset->second : offsetOf(tuple);
+      if (offset == no_offset || offset >= latency || !types::isA<types::Float>(elems[i])) {
+        continue;
+      }
+      auto index = std::make_shared<mir::Value>(mir::Constants{static_cast<double>(i)});
+      auto name = "output" + std::to_string(i) + ".aligned" + std::to_string(count++);
+      auto ptr = std::make_shared<mir::Value>(
+          minst::Field{{name + ".ptr", types::Float{}, block}, tuple, index});
+      auto value = std::make_shared<mir::Value>(
+          minst::Load{{name + ".value", types::Float{}, block}, ptr});
+      block->instructions.insert(load, ptr);
+      block->instructions.insert(load, value);
+      offsets[value.get()] = offset;
+      auto delayed = makeDelay(block, load, value, latency - offset);
+      block->instructions.insert(
+          load, std::make_shared<mir::Value>(
+                    minst::Store{{name, types::Void{}, block}, ptr, delayed}));
+    }
+  }
+  // fields of tuples stored by index, to align the outputs of dsp.
+  std::map<std::pair<const mir::Value*, size_t>, const mir::Value*> fields;
+
+  // returns the offset of the value returned from the block.
+  int visitBlock(mir::blockptr const& block, bool isbody) {
+    int res = no_offset;
+    auto& insts = block->instructions;
+    for (auto iter = insts.begin(); iter != insts.end(); ++iter) {
+      auto v = *iter;
+      auto* inst = std::get_if<mir::Instructions>(v.get());
+      if (inst == nullptr) { continue; }
+      std::visit(
+          overloaded{
+              [&](minst::Function const& /*f*/) {
+                // closures are analyzed with the enclosing function.
+                if (inserting) { visitFunction(v, false); }
+              },
+              [&](minst::Op& op) {
+                std::vector<mir::valueptr*> operands = {&op.rhs};
+                if (op.lhs) { operands.push_back(&op.lhs.value()); }
+                offsets[v.get()] = align(block, iter, operands);
+              },
+              [&](minst::Fcall& f) { offsets[v.get()] = visitFcall(block, iter, f); },
+              [&](minst::Store& s) { visitStore(block, iter, s, isbody, res); },
+              [&](minst::Load& l) { offsets[v.get()] = offsetOf(l.target); },
+              [&](minst::Ref& r) { offsets[v.get()] = offsetOf(r.target); },
+              [&](minst::Field& f) {
+                offsets[v.get()] = std::max(offsetOf(f.target), offsetOf(f.index));
+                if (auto* c = std::get_if<mir::Constants>(f.index.get())) {
+                  if (auto* d = std::get_if<double>(c)) {
+                    fields[{f.target.get(), static_cast<size_t>(*d)}] = v.get();
+                  }
+                }
+              },
+              [&](minst::ArrayAccess& a) {
+                offsets[v.get()] = std::max(offsetOf(a.target), offsetOf(a.index));
+              },
+              [&](minst::Array& a) {
+                int offset = no_offset;
+                for (auto& e : a.args) { offset = std::max(offset, offsetOf(e)); }
+                offsets[v.get()] = offset;
+              },
+              [&](minst::If& i) {
+                const int thenoffset = visitBlock(i.thenblock, false);
+                const int elseoffset = i.elseblock ? visitBlock(i.elseblock.value(), false)
+                                                   : no_offset;
+                const int target = std::max(thenoffset, elseoffset);
+                alignReturn(i.thenblock, target);
+                if (i.elseblock) { alignReturn(i.elseblock.value(), target); }
+                offsets[v.get()] = target;
+              },
+              [&](minst::Return& r) {
+                const bool isoutput = isbody && scope.isdsp;
+                res = isoutput ? alignOne(block, iter, r.val, latency) : offsetOf(r.val);
+              },
+              [&](auto& /*number, string, allocate, closure*/) {}},
+          *inst);
+    }
+    return res;
+  }
+  void alignReturn(mir::blockptr const& block, int target) {
+    for (auto iter = block->instructions.begin(); iter != block->instructions.end(); ++iter) {
+      if (auto* r = getInstPtr<minst::Return>(*iter)) { alignOne(block, iter, r->val, target); }
+    }
+  }
+
+  int visitFcall(mir::blockptr const& block, iterator pos, minst::Fcall& f) {
+    // scheduled calls do not return values.
+    if (f.time) { return no_offset; }
+    auto* ext = std::get_if<mir::ExternalSymbol>(f.fname.get());
+    if (ahead.count(pos->get()) > 0) {
+      reads_ahead.insert(scope.fn);
+      // the input of oversample is the second argument.
+      const bool oversample = ext != nullptr && ext->name == "oversample";
+      auto const& input = oversample ? *std::next(f.args.begin()) : f.args.front();
+      if (ext != nullptr && (ext->name == "lookahead" || ext->name == "stft" || oversample) &&
+          offsetOf(input) > 0) {
+        throw std::runtime_error(ext->name +
+                                 " can not read a signal already delayed by lookahead");
+      }
+      return latency;
+    }
+    std::vector<mir::valueptr*> operands;
+    for (auto& a : f.args) { operands.push_back(&a); }
+    int res = no_offset;
+    auto* callee = getInstPtr<minst::Function>(f.fname);
+    if (callee != nullptr && reads_ahead.count(f.fname.get()) > 0) {
+      reads_ahead.insert(scope.fn);
+      for (auto* a : operands) {
+        if (offsetOf(*a) > 0) {
+          throw std::runtime_error(callee->name +
+                                   " reads ahead and can not take a signal delayed by lookahead");
+        }
+      }
+      res = latency;
+    } else {
+      res = align(block, pos, operands);
+      if (auto iter = fn_offsets.find(f.fname.get()); iter != fn_offsets.end()) {
+        res = std::max(res, iter->second);
+      } else if (callee != nullptr || !ext || LLVMBuiltin::getMemobjType(ext->name)) {
+        // user functions, closures and builtins with a state(e.g. oscillators) return signals
+        // even with constant arguments.
+        res = std::max(res, 0);
+      }
+    }
+    // aggregate results are written to the allocation given as an argument.
+    for (auto& a : f.args) {
+      if (getInstPtr<minst::Allocate>(a) != nullptr) { raise(a, res); }
+    }
+    return res;
+  }
+
+  void visitStore(mir::blockptr const& block, iterator pos, minst::Store& s, bool isbody,
+                  int& res) {
+    if (std::holds_alternative<std::shared_ptr<mir::Argument>>(*s.target)) {
+      // returned by the pointer given as the argument.
+      if (isbody) {
+        if (scope.isdsp && inserting) {
+          if (auto* l = getInstPtr<minst::Load>(s.value)) {
+            auto load = std::find(block->instructions.begin(), pos, s.value);
+            if (load != pos) { alignOutputs(block, load, l->target); }
+          }
+        }
+        res = scope.isdsp ? latency : offsetOf(s.value);
+      }
+      return;
+    }
+    auto loc = offsets.find(s.target.get());
+    const int target = loc != offsets.end() ? loc->second : no_offset;
+    // variables take the largest offset of the values stored to them, found before inserting.
+    const int offset = alignOne(block, pos, s.value, target);
+    raise(s.target, offset);
+    if (auto* field = getInstPtr<minst::Field>(s.target)) { raise(field->target, offset); }
+  }
+};
+
+}  // namespace
+
+int LookaheadResolver::getConstantTime(mir::valueptr v, std::string const& what) {
+  std::optional<double> time;
+  if (auto* num = getInstPtr<minst::Number>(v)) { time = num->val; }
+  if (auto* c = std::get_if<mir::Constants>(v.get())) {
+    if (auto* d = std::get_if<double>(c)) { time = *d; }
+    if (auto* i = std::get_if<int>(c)) { time = *i; }
+  }
+  if (!time) { throw std::runtime_error(what + " must be a constant number"); }
+  if (time.value() < 0 || time.value() >= types::fixed_delaysize) {
+    throw std::runtime_error(what + " must be between 0 and " +
+                             std::to_string(types::fixed_delaysize - 1) + " samples");
+  }
+  return static_cast<int>(time.value());
+}
+
+void LookaheadResolver::collect(mir::blockptr block) {
+  auto& insts = block->instructions;
+  for (auto iter = insts.begin(); iter != insts.end(); ++iter) {
+    if (auto* f = getInstPtr<minst::Function>(*iter)) {
+      collect(f->body);
+    } else if (auto* ifinst = getInstPtr<minst::If>(*iter)) {
+      collect(ifinst->thenblock);
+      if (ifinst->elseblock) { collect(ifinst->elseblock.value()); }
+    } else if (auto* fcall = getInstPtr<minst::Fcall>(*iter)) {
+      auto* ext = std::get_if<mir::ExternalSymbol>(fcall->fname.get());
+      if (ext != nullptr && ext->name == "lookahead") {
+        calls.push_back(
+            Call{block, iter, getConstantTime(*std::next(fcall->args.begin()), "time of lookahead")});
+      } else if (ext != nullptr && ext->name == "stft") {
+        auto fftsize = getConstantTime(*std::next(fcall->args.begin()), "fft size of stft");
+        auto latency = builtin::Stft::getFftSize(fftsize);
+        calls.push_back(Call{block, iter, static_cast<int>(latency), true});
+      } else if (ext != nullptr && ext->name == "oversample") {
+        calls.push_back(Call{block, iter, static_cast<int>(builtin::Oversampler::latency), true});
+      }
+    }
+  }
+}
+
+// the call is moved to a new value and the original value, referred from others, becomes a delay
+// of it.
+mir::Value* LookaheadResolver::appendDelay(Call const& c, int time) {
+  auto& fcall = mir::getInstRef<minst::Fcall>(*c.pos);
+  auto moved = std::make_shared<mir::Value>(**c.pos);
+  mir::getInstRef<minst::Fcall>(moved).name = fcall.name + ".latency";
+  auto delaytime = std::make_shared<mir::Value>(minst::Number{
+      {fcall.name + ".compensation", types::Float{}, c.block}, static_cast<double>(time)});
+  c.block->instructions.insert(c.pos, moved);
+  c.block->instructions.insert(c.pos, delaytime);
+  auto delaytype = types::Function{types::Float{}, {types::Float{}, types::Float{}}};
+  fcall.fname = std::make_shared<mir::Value>(mir::ExternalSymbol{"delay", delaytype});
+  fcall.args = {moved, delaytime};
+  fcall.time = std::nullopt;
+  return moved.get();
+}
+
+int LookaheadResolver::process(mir::blockptr toplevel) {
+  calls.clear();
+  collect(toplevel);
+  int latency = 0;
+  for (auto& c : calls) { latency = std::max(latency, c.time); }
+  for (auto& c : calls) {
+    if (latency - c.time >= static_cast<int>(types::fixed_delaysize)) {
+      throw std::runtime_error("latency of " + std::to_string(latency) +
+                               " samples can not be compensated by delay");
+    }
+  }
+  std::unordered_set<const mir::Value*> ahead;
+  for (auto& c : calls) {
+    ahead.insert(c.pos->get());
+    if (c.is_latency) {
+      if (c.time < latency) { ahead.insert(appendDelay(c, latency - c.time)); }
+      continue;
+    }
+    auto& fcall = mir::getInstRef<minst::Fcall>(*c.pos);
+    // the original constant may be shared with other expressions, so a new one is made.
+    auto delaytime = std::make_shared<mir::Value>(minst::Number{
+        {fcall.name + ".lookahead", types::Float{}, c.block}, static_cast<double>(latency - c.time)});
+    c.block->instructions.insert(c.pos, delaytime);
+    *std::next(fcall.args.begin()) = delaytime;
+  }
+  if (latency > 0) { DryPathAligner(latency, std::move(ahead)).process(toplevel); }
+  return latency;
+}
+
+}  // namespace mimium
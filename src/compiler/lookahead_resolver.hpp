@@ -0,0 +1,39 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "basic/mir.hpp"
+
+namespace mimium {
+
+namespace minst = mir::instruction;
+
+// Resolves future references `lookahead(x,n)`, which reads x of n samples later.
+// The output of the program is delayed by the largest n(the latency), and each call becomes a
+// delay of `latency - n`. n must be a constant number.
+// Builtins with an inherent latency(stft, oversample) count in the latency too, and their outputs
+// are delayed by the rest to be aligned with lookaheads. Signals not going through them(inputs of
+// dsp, dry paths) are delayed by the latency where they are mixed with them or output.
+class LookaheadResolver {
+ public:
+  // returns the latency in samples.
+  int process(mir::blockptr toplevel);
+
+ private:
+  struct Call {
+    mir::blockptr block;
+    std::list<mir::valueptr>::iterator pos;
+    int time;
+    // the call has the latency of `time` instead of reading ahead.
+    bool is_latency = false;
+  };
+  std::vector<Call> calls;
+  void collect(mir::blockptr block);
+  static int getConstantTime(mir::valueptr v, std::string const& what);
+  // returns the moved call.
+  static mir::Value* appendDelay(Call const& c, int time);
+};
+
+}  // namespace mimium
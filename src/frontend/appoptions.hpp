@@ -36,6 +36,21 @@ struct RuntimeOption {
   ExecutionEngine engine = ExecutionEngine::LLVM;
   BackEnd backend = BackEnd::RtAudio;
   OptimizeLevel optimize_level;
+  // output path of the profile of an instrumented run.
+  std::optional<fs::path> profile_generate;
+  // profile used for branch weights and inlining.
+  std::optional<fs::path> profile_use;
+  // code of dsp and its callees is backed by huge pages and locked in memory.
+  bool huge_pages = false;
+  bool lock_code = false;
+  // benchmarks configurations of code generation if the cache has no entry for the patch.
+  bool autotune = false;
+  std::optional<fs::path> tune_cache;
+  // percentage of a core which dsp may use, checked with the static estimate of its cost.
+  std::optional<double> cpu_budget;
+  double budget_samplerate = 48000.0;
+  // fails instead of warning if the estimate exceeds the budget.
+  bool budget_error = false;
 };
 struct AppOption {
   CompileOption compile_option;
@@ -43,5 +58,7 @@ struct AppOption {
   std::optional<Source> input = std::nullopt;
   std::optional<fs::path> output_path;
   bool is_verbose = false;
+  // prints the breakdown of memory used by the program to stderr.
+  bool mem_report = false;
 };
 }  // namespace mimium::app
\ No newline at end of file
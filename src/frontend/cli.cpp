@@ -24,8 +24,27 @@ const std::unordered_map<std::string_view, ak> str_to_argkind = {
     {"--optimize", ak::OptimizeLevel},
     {"--backend", ak::BackEnd},
     {"--engine", ak::ExecutionEngine},
+    {"--profile-generate", ak::ProfileGenerate},
+    {"--profile-use", ak::ProfileUse},
+    {"--huge-pages", ak::HugePages},
+    {"--lock-code", ak::LockCode},
+    {"--autotune", ak::AutoTune},
+    {"--tune-cache", ak::TuneCache},
+    {"--cpu-budget", ak::CpuBudget},
+    {"--budget-samplerate", ak::BudgetSampleRate},
+    {"--budget-error", ak::BudgetError},
+    {"--mem-report", ak::MemReport},
 };
 
+double parseNumber(std::string_view option, std::string_view val) {
+  try {
+    return std::stod(std::string(val));
+  } catch (std::exception&) {
+    throw mimium::CliAppError("Invalid number for option " + std::string(option) + ": " +
+                              std::string(val));
+  }
+}
+
 }  // namespace
 
 namespace mimium::app::cli {
@@ -41,6 +60,11 @@ bool isArgPaired(ArgKind arg) {
     case ak::EmitMir:
     case ak::EmitMirClosureCoverted:
     case ak::EmitLLVMIR:
+    case ak::HugePages:
+    case ak::LockCode:
+    case ak::AutoTune:
+    case ak::BudgetError:
+    case ak::MemReport:
     case ak::Verbose: return false;
     default: return true;
   }
@@ -59,6 +83,21 @@ Options:
   --optimize  [0,1(default)]           - Set Optimization Level.
   --engine    [llvm(default)]          - Set execution engine.
   --backend   [rtaudio(default)]       - Set Audio Backend.
+  --profile-generate [file]            - Count branches and calls of dsp and write them to the
+                                         file when stopped(Ctrl+C stops the run).
+  --profile-use [file]                 - Optimize dsp with the profile.
+  --huge-pages                         - Back the code of dsp by huge pages.
+  --lock-code                          - Lock the code of dsp in physical memory.
+  --autotune                           - Benchmark code generation options for the patch on
+                                         this machine and cache the fastest. Cached options are
+                                         used without this flag.
+  --tune-cache [file]                  - Set the cache file of --autotune.
+  --cpu-budget [percent]               - Print the estimated cost of dsp, and warn if it exceeds
+                                         the percentage of a core.
+  --budget-samplerate [Hz]             - Set the sample rate of --cpu-budget(default 48000).
+  --budget-error                       - Fail instead of warning when over --cpu-budget.
+  --mem-report                         - Print memory used by the program after compilation and
+                                         after dsp was prepared.
   --version                            - Print a version number to stdout.
   -h|--help                            - Show this help.
 )";
@@ -90,6 +129,20 @@ void CliApp::OptionParser::processArgs(ArgKind arg, std::string_view val) {
     case ak::Output: result.output_path = val; break;
     case ak::BackEnd: result.runtime_option.backend = getBackEnd(val); break;
     case ak::ExecutionEngine: result.runtime_option.engine = getExecutionEngine(val); break;
+    case ak::ProfileGenerate: result.runtime_option.profile_generate = val; break;
+    case ak::ProfileUse: result.runtime_option.profile_use = val; break;
+    case ak::HugePages: result.runtime_option.huge_pages = true; return;
+    case ak::LockCode: result.runtime_option.lock_code = true; return;
+    case ak::AutoTune: result.runtime_option.autotune = true; return;
+    case ak::TuneCache: result.runtime_option.tune_cache = val; break;
+    case ak::CpuBudget:
+      result.runtime_option.cpu_budget = parseNumber("--cpu-budget", val);
+      break;
+    case ak::BudgetSampleRate:
+      result.runtime_option.budget_samplerate = parseNumber("--budget-samplerate", val);
+      break;
+    case ak::BudgetError: result.runtime_option.budget_error = true; return;
+    case ak::MemReport: result.mem_report = true; return;
     case ak::EmitAst: result.compile_option.stage = CompileStage::Parse; break;
     case ak::EmitAstUniqueSymbol: result.compile_option.stage = CompileStage::SymbolRename; break;
     case ak::EmitMir: result.compile_option.stage = CompileStage::MirEmit; break;
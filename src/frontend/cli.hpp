@@ -26,6 +26,16 @@ enum class ArgKind {
   EmitMirClosureCoverted,
   EmitLLVMIR,
   OptimizeLevel,
+  ProfileGenerate,
+  ProfileUse,
+  HugePages,
+  LockCode,
+  AutoTune,
+  TuneCache,
+  CpuBudget,
+  BudgetSampleRate,
+  BudgetError,
+  MemReport,
   ShowVersion,
   ShowHelp,
   Verbose,
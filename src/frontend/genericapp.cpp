@@ -4,6 +4,8 @@
 
 #include "genericapp.hpp"
 #include "basic/ast_to_string.hpp"
+#include "compiler/builtin/context.hpp"
+#include "compiler/builtin/samplepool.hpp"
 #include "compiler/codegen/llvm_header.hpp"
 #include "runtime/executionengine/executionengine.hpp"
 #include "preprocessor/preprocessor.hpp"
@@ -26,6 +28,19 @@ const std::unordered_map<std::string_view, mimium::app::BackEnd> str_to_backend
     {"test", mimium::app::BackEnd::Test},
 };
 
+// $XDG_CACHE_HOME/mimium/autotune, ~/.cache/mimium/autotune or %LOCALAPPDATA%\mimium\autotune.
+fs::path getDefaultTuneCachePath() {
+  for (const auto* var : {"XDG_CACHE_HOME", "LOCALAPPDATA"}) {
+    const char* dir = std::getenv(var);
+    if (dir != nullptr && *dir != '\0') { return fs::path(dir) / "mimium" / "autotune"; }
+  }
+  const char* home = std::getenv("HOME");
+  if (home != nullptr && *home != '\0') {
+    return fs::path(home) / ".cache" / "mimium" / "autotune";
+  }
+  return fs::temp_directory_path() / "mimium" / "autotune";
+}
+
 }  // namespace
 
 namespace mimium::app {
@@ -57,6 +72,24 @@ volatile std::sig_atomic_t GenericApp::signal_status = 0;  // NOLINT
 
 void GenericApp::handleSignal(int signal) { GenericApp::signal_status = signal; }
 
+GenericApp::InterruptWatcher::InterruptWatcher(AudioDriver& driver) {
+  std::signal(SIGINT, handleSignal);
+  thread = std::thread([&driver, this]() {
+    while (!finished) {
+      if (signal_status == SIGINT) {
+        driver.stop();
+        return;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+  });
+}
+GenericApp::InterruptWatcher::~InterruptWatcher() {
+  finished = true;
+  thread.join();
+  std::signal(SIGINT, SIG_DFL);
+}
+
 bool GenericApp::compileMainLoop(Compiler& compiler, const CompileOption& option,
                                  const std::optional<Source>& input,
                                  const std::optional<fs::path>& output_path) {
@@ -123,14 +156,16 @@ int GenericApp::runtimeMainLoop(const RuntimeOption& option, const fs::path& inp
   try {
     bool optimize = option.optimize_level == OptimizeLevel::ON;
     if (option.engine == ExecutionEngine::LLVM) {
+      std::unique_ptr<LLVMJitExecutionEngine> llvm_engine = nullptr;
+      const LLVMJitExecutionEngine* jit = nullptr;
       switch (inputtype) {
         case FileType::MimiumSource:
-          exec_engine = std::make_unique<LLVMJitExecutionEngine>(
+          llvm_engine = std::make_unique<LLVMJitExecutionEngine>(
               compiler->moveLLVMCtx(), compiler->moveLLVMModule(),
               fs::absolute(input_path).string(), optimize);
           break;
         case FileType::LLVMIR:
-          exec_engine =
+          llvm_engine =
               std::make_unique<LLVMJitExecutionEngine>(fs::absolute(input_path).string(), optimize);
           break;
         case FileType::MimiumMir:
@@ -138,9 +173,48 @@ int GenericApp::runtimeMainLoop(const RuntimeOption& option, const fs::path& inp
           return -1;
         default: throw std::runtime_error("Unknown File Type"); return -1;
       }
+      if (option.profile_use) { llvm_engine->setProfileInput(option.profile_use->string()); }
+      if (option.profile_generate) {
+        llvm_engine->setProfileOutput(option.profile_generate->string());
+      }
+      llvm_engine->setHotCodeOptions(true, option.huge_pages, option.lock_code);
+      if (option.cpu_budget) {
+        llvm_engine->setCostBudget(CostBudget{option.cpu_budget.value() / 100.0,
+                                              option.budget_samplerate, 0.0, option.budget_error});
+      }
+      if (optimize) {
+        llvm_engine->setTuneCache(option.tune_cache.value_or(getDefaultTuneCachePath()).string(),
+                                  option.autotune);
+      }
+      jit = llvm_engine.get();
+      exec_engine = std::move(llvm_engine);
       runtime =
           std::make_unique<Runtime>(std::make_unique<AudioDriverRtAudio>(), std::move(exec_engine));
       runtime->runMainFun();
+      if (this->option->mem_report) {
+        // builtins allocate their states when dsp is prepared.
+        runtime->prepare();
+        auto const& ctx = runtime->getBuiltinContext();
+        MemoryReport::Measured measured;
+        measured.heap_count = runtime->getHeapCount();
+        measured.heap_bytes = runtime->getHeapBytes();
+        measured.sample_bytes = builtin::SamplePool::getLoadedBytes();
+        measured.mapped_bytes = ctx.getMappedBytes();
+        measured.state_count = ctx.getStateCount();
+        measured.state_bytes = ctx.getStateBytes();
+        measured.shared_count = ctx.getSharedCount();
+        measured.shared_bytes = ctx.getSharedBytes();
+        measured.array_count = ctx.getArrayCount();
+        measured.array_bytes = ctx.getArrayBytes();
+        measured.code_bytes = jit->getCodeBytes();
+        measured.data_bytes = jit->getDataBytes();
+        MemoryReport report;
+        report.measured = measured;
+        report.print(std::cerr);
+      }
+      // the instrumented run is stopped by Ctrl+C, and the profile is written after that.
+      std::optional<InterruptWatcher> watcher;
+      if (option.profile_generate) { watcher.emplace(runtime->getAudioDriver()); }
       runtime->start();  // start() blocks thread until scheduler stops
       return 0;
     }
@@ -169,6 +243,10 @@ int GenericApp::run() {
     if (should_compile) {
       should_run =
           compileMainLoop(*compiler, option->compile_option, option->input, option->output_path);
+      const auto stage = option->compile_option.stage;
+      if (option->mem_report && (stage == CompileStage::Codegen || stage == CompileStage::Run)) {
+        compiler->getMemoryReport().print(std::cerr);
+      }
     }
 
     int res = 0;
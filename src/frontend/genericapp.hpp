@@ -3,8 +3,10 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #pragma once
+#include <atomic>
 #include <csignal>
 #include <iostream>
+#include <thread>
 #include "appoptions.hpp"
 #include "libmimium.hpp"
 #include "export.hpp"
@@ -30,6 +32,18 @@ class MIMIUM_DLL_PUBLIC GenericApp {
  private:
   std::unique_ptr<Compiler> compiler;
   static void handleSignal(int signal);
+  // stops the audio driver on SIGINT while alive.
+  class InterruptWatcher {
+   public:
+    explicit InterruptWatcher(AudioDriver& driver);
+    ~InterruptWatcher();
+    InterruptWatcher(InterruptWatcher const&) = delete;
+    InterruptWatcher& operator=(InterruptWatcher const&) = delete;
+
+   private:
+    std::atomic<bool> finished = false;
+    std::thread thread;
+  };
   // Compiler Main Loop. If runtime should start, return 1.
   // If compiler should emit result and quit app, return 0.
   static bool compileMainLoop(Compiler& compiler, const CompileOption& option,
@@ -18,6 +18,7 @@
 
 #include "runtime/backend/rtaudio/driver_rtaudio.hpp"
 #include "runtime/executionengine/llvm/llvm_jitengine.hpp"
+#include "runtime/executionengine/llvm/dsp_cost.hpp"
 
 #include "frontend/genericapp.hpp"
 #include "frontend/cli.hpp"
\ No newline at end of file
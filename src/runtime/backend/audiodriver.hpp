@@ -3,6 +3,7 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #pragma once
+#include <algorithm>
 #include <memory>
 #include "runtime/runtime.hpp"
 
@@ -27,7 +28,23 @@ class MIMIUM_DLL_PUBLIC AudioDriver {
     Logger::debug_log("dsp function:" + std::to_string(dspfninfos->in_numchs) + " input, " +
                           std::to_string(dspfninfos->out_numchs) + " output",
                       Logger::INFO);
+    if (dspfninfos->latency > 0) {
+      // shown by default, as the output is delayed by it.
+      Logger::debug_log("latency by lookahead: " + std::to_string(dspfninfos->latency) +
+                            " samples",
+                        Logger::WARNING);
+      sch.setLatency(dspfninfos->latency);
+    }
+  }
+  [[nodiscard]] DspFnInfos const* getDspFnInfos() const { return dspfninfos.get(); }
+  // false if the audio is processed faster than real time, e.g. offline rendering.
+  [[nodiscard]] virtual bool isRealtime() const { return true; }
+  // frames processed by a call of the block function. must be called after setDspFnInfos.
+  void setBlockSize(int size) {
+    if (dspfninfos != nullptr) { dspfninfos->block_size = std::clamp(size, 1, max_dspblock); }
   }
+  // false to process sample by sample even if the block function exists, e.g. to compare them.
+  void setBlockProcessing(bool enable) { block_processing = enable; }
   virtual void setup(std::unique_ptr<AudioDriverParams> p) {
     params = std::move(p);
     interleaved_in.resize(params->audioframesize * dspfninfos->in_numchs);
@@ -64,47 +81,62 @@ class MIMIUM_DLL_PUBLIC AudioDriver {
   inline static constexpr int default_framesize = 256;
 
  private:
-  std::vector<double> interleaved_in;
-  std::vector<double> interleaved_out;
-  // buffer copy into vector from pointer of poitner
-  static void interleaveSamples(const double** src, std::vector<double>& dest, int framesize,
+  // dsp-side buffers. Each frame holds dsp's channels contiguously so that a dsp returning a
+  // fixed-size array can be stored with vector instructions.
+  AlignedVector<double> interleaved_in;
+  AlignedVector<double> interleaved_out;
+  bool block_processing = true;
+  // buffer copy into interleaved dsp buffer from pointer of pointer.
+  static void interleaveSamples(const double** src, AlignedVector<double>& dest, int framesize,
                                 int dsp_chans, int device_chans) {
-    for (int ch = 0; ch < dsp_chans; ch++) {
-      const auto* samples_ch = *std::next(src, ch);
-      if (ch < device_chans) {
-        for (int count = 0; count < framesize; count++) {
-          dest.at(count + count * ch) = *std::next(samples_ch, count);
-        }
-      } else {
-        for (int count = 0; count < framesize; count++) { dest.at(count + count * ch) = 0; }
-      }
+    const int chans = std::min(dsp_chans, device_chans);
+    for (int count = 0; count < framesize; count++) {
+      auto* frame = std::next(dest.data(), count * dsp_chans);
+      for (int ch = 0; ch < chans; ch++) { frame[ch] = src[ch][count]; }
+      std::fill(std::next(frame, chans), std::next(frame, dsp_chans), 0.0);
     }
   }
-  // buffer copy into pointer of poitner from vector
-  static void deinterleaveSamples(std::vector<double> const& src, double** dest, int framesize,
+  // buffer copy into pointer of pointer from interleaved dsp buffer.
+  static void deinterleaveSamples(AlignedVector<double> const& src, double** dest, int framesize,
                                   int dsp_chans, int device_chans) {
-    for (int ch = 0; ch < dsp_chans; ch++) {
-      auto* dest_ch = *std::next(dest, ch);
-      if (ch < device_chans) {
-        for (int count = 0; count < framesize; count++) {
-          *std::next(dest_ch, count) = src.at(count + count * ch);
-        }
-      } else {
-        std::fill(dest_ch, std::next(dest_ch, framesize), 0);
-      }
+    const int chans = std::min(dsp_chans, device_chans);
+    for (int ch = 0; ch < chans; ch++) {
+      auto* dest_ch = dest[ch];
+      const auto* src_ch = std::next(src.data(), ch);
+      for (int count = 0; count < framesize; count++) { dest_ch[count] = src_ch[count * dsp_chans]; }
+    }
+    for (int ch = chans; ch < device_chans; ch++) {
+      std::fill(dest[ch], std::next(dest[ch], framesize), 0.0);
+    }
+  }
+  // copy between interleaved buffers whose number of channels per frame differ.
+  static void copyFrames(const double* src, int src_chans, double* dest, int dest_chans,
+                         int framesize) {
+    const int chans = std::min(src_chans, dest_chans);
+    for (int count = 0; count < framesize; count++) {
+      const auto* src_frame = std::next(src, count * src_chans);
+      auto* dest_frame = std::next(dest, count * dest_chans);
+      std::copy(src_frame, std::next(src_frame, chans), dest_frame);
+      std::fill(std::next(dest_frame, chans), std::next(dest_frame, dest_chans), 0.0);
     }
   }
 
   template <bool HASDSP>
   bool processInternal(const double** input, double** output, int framesize) {
     assert(framesize == params->audioframesize);
+    const int dsp_ins = dspfninfos->in_numchs;
+    const int dsp_outs = dspfninfos->out_numchs;
     bool res = true;
-    interleaveSamples(input, interleaved_in, framesize, dspfninfos->in_numchs, params->in_numchs);
-    for (int count = 0; count < framesize; count++) {
-      res &= this->processSample<HASDSP>(interleaved_in.data(), interleaved_out.data());
+    interleaveSamples(input, interleaved_in, framesize, dsp_ins, params->in_numchs);
+    if constexpr (HASDSP) {
+      res = processFrames(interleaved_in.data(), interleaved_out.data(), framesize);
+    } else {
+      for (int count = 0; count < framesize; count++) {
+        res &= this->processSample<false>(std::next(interleaved_in.data(), count * dsp_ins),
+                                          std::next(interleaved_out.data(), count * dsp_outs));
+      }
     }
-    deinterleaveSamples(interleaved_out, output, framesize, dspfninfos->out_numchs,
-                        params->out_numchs);
+    deinterleaveSamples(interleaved_out, output, framesize, dsp_outs, params->out_numchs);
     return res;
   }
   template <bool HASDSP>
@@ -120,44 +152,54 @@ class MIMIUM_DLL_PUBLIC AudioDriver {
     return true;
   }
 
+  // frames are processed by the block function while no task is executed in the block, otherwise
+  // sample by sample.
+  bool processFrames(const double* input, double* output, int framesize) {
+    const int dsp_ins = dspfninfos->in_numchs;
+    const int dsp_outs = dspfninfos->out_numchs;
+    auto blockfn = block_processing ? dspfninfos->block_fn : nullptr;
+    bool res = true;
+    for (int pos = 0; pos < framesize;) {
+      const int n = std::min(dspfninfos->block_size, framesize - pos);
+      const auto* in = std::next(input, pos * dsp_ins);
+      auto* out = std::next(output, pos * dsp_outs);
+      if (blockfn != nullptr && sch.advanceBlock(n)) {
+        blockfn(out, in, dspfninfos->cls_address, dspfninfos->memobj_address, n);
+      } else {
+        for (int count = 0; count < n; count++) {
+          res &= processSample<true>(std::next(in, count * dsp_ins),
+                                     std::next(out, count * dsp_outs));
+        }
+      }
+      pos += n;
+    }
+    return res;
+  }
+
   template <bool HASDSP>
   bool processInternalInterleaved(const double* input, double* output, int framesize) {
+    bool res = true;
     if constexpr (HASDSP) {
-      int dsp_ins = dspfninfos->in_numchs;
-      int device_ins = params->in_numchs;
-      int dsp_outs = dspfninfos->out_numchs;
-      int device_outs = params->out_numchs;
-      for (int ch = 0; ch < dsp_ins; ch++) {
-        for (int count = 0; count < framesize; count++) {
-          if (ch > device_ins) {
-            interleaved_in[ch + dsp_ins * count] = input[ch + device_ins * count];
-          } else {
-            interleaved_in[ch + dsp_ins * count] = 0;
-          }
-        }
-      }
-      bool res = true;
-      for (int count = 0; count < framesize; count++) {
-        res &= processSample<true>(std::next(interleaved_in.data(), count * dsp_ins),
-                                   std::next(interleaved_out.data(), count * dsp_outs));
-      }
-      for (int ch = 0; ch < dsp_outs; ch++) {
-        for (int count = 0; count < framesize; count++) {
-          if (ch < device_outs) {
-            output[ch + device_outs * count] = interleaved_out[ch + dsp_outs * count];
-          } else {
-            output[ch + device_outs * count] = 0;
-          }
-        }
+      const int dsp_ins = dspfninfos->in_numchs;
+      const int device_ins = params->in_numchs;
+      const int dsp_outs = dspfninfos->out_numchs;
+      const int device_outs = params->out_numchs;
+      // when the layout of device matches to dsp, process directly on device buffers.
+      const bool in_direct = dsp_ins == device_ins;
+      const bool out_direct = dsp_outs == device_outs;
+      const double* in = in_direct ? input : interleaved_in.data();
+      double* out = out_direct ? output : interleaved_out.data();
+      if (!in_direct) { copyFrames(input, device_ins, interleaved_in.data(), dsp_ins, framesize); }
+      res = processFrames(in, out, framesize);
+      if (!out_direct) {
+        copyFrames(interleaved_out.data(), dsp_outs, output, device_outs, framesize);
       }
-      return res;
     } else {
-      bool res = true;
       for (int count = 0; count < framesize; count++) {
-        res |= processSample<false>(input, output);
+        res &= processSample<false>(input, output);
       }
-      return res;
     }
+    return res;
   }
 };
 }  // namespace mimium
\ No newline at end of file
@@ -0,0 +1,72 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "driver_offline.hpp"
+#include <chrono>
+#include <random>
+#include "runtime/executionengine/executionengine.hpp"
+
+namespace mimium {
+
+AudioDriverOffline::AudioDriverOffline(int numblocks, int framesize, double samplerate)
+    : AudioDriver(), numblocks(numblocks), framesize(framesize), samplerate(samplerate) {}
+
+void AudioDriverOffline::setNoiseInput(unsigned int seed) { noise_seed = seed; }
+
+bool AudioDriverOffline::start() {
+  AudioDriver::start();
+  sch.start(dspfninfos->fn != nullptr);
+  const int frames = params->audioframesize;
+  std::vector<double> in(frames * params->in_numchs);
+  std::vector<double> out(frames * params->out_numchs);
+  std::vector<char> evict(evict_bytes);
+  std::mt19937 gen(noise_seed.value_or(0));
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::chrono::steady_clock::duration total{};
+  int measured = 0;
+  recorded.clear();
+  if (record) { recorded.reserve(out.size() * numblocks); }
+  for (int count = 0; count < numblocks; count++) {
+    if (noise_seed) {
+      for (auto& v : in) { v = dist(gen); }
+    }
+    // stride of a cache line
+    for (size_t idx = 0; idx < evict.size(); idx += 64) { evict[idx]++; }
+    auto begin = std::chrono::steady_clock::now();
+    const bool res = process(in.data(), out.data(), frames);
+    // the first block touches the code and memory objects for the first time.
+    if (count > 0) {
+      total += std::chrono::steady_clock::now() - begin;
+      measured++;
+    }
+    if (record) { recorded.insert(recorded.end(), out.begin(), out.end()); }
+    if (!res) { break; }
+  }
+  elapsed = measured > 0
+                ? std::chrono::duration<double, std::nano>(total).count() / (measured * frames)
+                : 0.0;
+  sch.stop();
+  return true;
+}
+
+bool AudioDriverOffline::stop() {
+  sch.stop();
+  return true;
+}
+
+int AudioDriverOffline::getNumOutputs() const {
+  return params != nullptr ? params->out_numchs : 0;
+}
+
+std::unique_ptr<AudioDriverParams> AudioDriverOffline::getDefaultAudioParameter(
+    std::optional<int> samplerate_i, std::optional<int> framesize_i) const {
+  const int frames = framesize_i.value_or(framesize);
+  const auto [ins, outs] =
+      device_channels.value_or(std::pair(dspfninfos->in_numchs, dspfninfos->out_numchs));
+  const double rate = samplerate_i ? *samplerate_i : samplerate;
+  return std::make_unique<AudioDriverParams>(
+      AudioDriverParams{rate, static_cast<int>(frames * sizeof(double)), frames, ins, outs});
+}
+
+}  // namespace mimium
@@ -0,0 +1,51 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <optional>
+#include <utility>
+#include <vector>
+#include "runtime/backend/audiodriver.hpp"
+
+namespace mimium {
+
+// Audio driver without a device. start() processes a fixed number of blocks as fast as possible
+// on the calling thread and measures the time spent in processing. The input is silence, or
+// uniform noise from a fixed seed. The output can be recorded to render programs offline.
+class MIMIUM_DLL_PUBLIC AudioDriverOffline : public AudioDriver {
+ public:
+  explicit AudioDriverOffline(int numblocks, int framesize = default_framesize,
+                              double samplerate = 48000);
+  bool start() override;
+  bool stop() override;
+  [[nodiscard]] bool isRealtime() const override { return false; }
+  [[nodiscard]] std::unique_ptr<AudioDriverParams> getDefaultAudioParameter(
+      std::optional<int> samplerate, std::optional<int> framesize) const override;
+  void setNoiseInput(unsigned int seed);
+  // channels of the device. defaults to the channels of dsp.
+  void setDeviceChannels(int ins, int outs) { device_channels = std::pair(ins, outs); }
+  // keeps the interleaved output of all blocks.
+  void setRecordOutput(bool record) { this->record = record; }
+  [[nodiscard]] std::vector<double> const& getRecordedOutput() const { return recorded; }
+  // a buffer of this size is written between blocks to evict caches, as other work of the process
+  // does between audio callbacks. not included in the elapsed time.
+  void setEvictBytes(size_t bytes) { evict_bytes = bytes; }
+  // number of output channels, available after start.
+  [[nodiscard]] int getNumOutputs() const;
+  // nanoseconds per sample, excluding the first block.
+  [[nodiscard]] double getElapsed() const { return elapsed; }
+
+ private:
+  int numblocks;
+  int framesize;
+  double samplerate;
+  std::optional<unsigned int> noise_seed;
+  std::optional<std::pair<int, int>> device_channels;
+  double elapsed = 0.0;
+  size_t evict_bytes = 0;
+  bool record = false;
+  std::vector<double> recorded;
+};
+
+}  // namespace mimium
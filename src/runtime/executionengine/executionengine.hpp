@@ -16,5 +16,7 @@ class ExecutionEngine {
   virtual bool runMainFunction(Runtime* runtime_ptr) = 0;
   //optional method run before dsp function starts.
   virtual void preStart(){};
+  //optional method run after the runtime stops.
+  virtual void postStop(){};
 };
 }  // namespace mimium
\ No newline at end of file
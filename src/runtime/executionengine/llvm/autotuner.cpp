@@ -0,0 +1,104 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "autotuner.hpp"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include "basic/error_def.hpp"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm_jitengine.hpp"
+#include "runtime/backend/offline/driver_offline.hpp"
+#include "runtime/runtime.hpp"
+
+namespace mimium {
+
+namespace {
+// discards what candidates print and warn, as mimium_main runs once for each of them before the
+// real run. errors are still reported.
+class QuietScope {
+ public:
+  QuietScope() : out(std::cout.rdbuf(nullptr)), level(Logger::current_report_level) {
+    Logger::current_report_level = std::min(level, Logger::ERROR_);
+  }
+  QuietScope(QuietScope const&) = delete;
+  QuietScope& operator=(QuietScope const&) = delete;
+  ~QuietScope() {
+    std::cout.rdbuf(out);
+    Logger::current_report_level = level;
+  }
+
+ private:
+  std::streambuf* out;
+  Logger::REPORT_LEVEL level;
+};
+}  // namespace
+
+double AutoTuner::measure(llvm::StringRef bitcode, TuneConfig const& config) {
+  auto ctx = std::make_unique<llvm::LLVMContext>();
+  auto module = llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, "autotune"), *ctx);
+  if (!module) { throw RuntimeError(llvm::toString(module.takeError())); }
+  auto engine = std::make_unique<LLVMJitExecutionEngine>(std::move(ctx), std::move(*module),
+                                                         "autotune", true);
+  // each candidate has its own runtime, and the states of builtins are not shared.
+  const QuietScope quiet;
+  engine->setTuneConfig(config);
+  auto driver = std::make_unique<AudioDriverOffline>(tune_blocks);
+  driver->setNoiseInput(0);
+  auto& driver_ref = *driver;
+  Runtime runtime(std::move(driver), std::move(engine));
+  runtime.runMainFun();
+  if (!runtime.hasDsp()) { return std::numeric_limits<double>::infinity(); }
+  runtime.start();
+  return driver_ref.getElapsed();
+}
+
+TuneConfig AutoTuner::tune(llvm::Module const& m) {
+  llvm::SmallVector<char, 0> buffer;
+  llvm::raw_svector_ostream os(buffer);
+  llvm::WriteBitcodeToFile(m, os);
+  const llvm::StringRef bitcode(buffer.data(), buffer.size());
+  TuneConfig best;
+  double besttime = measure(bitcode, best);
+  auto trial = [&](TuneConfig const& candidate) {
+    const double time = measure(bitcode, candidate);
+    if (time < besttime * (1.0 - min_gain)) {
+      best = candidate;
+      besttime = time;
+    }
+  };
+  for (unsigned level : {1U, 3U}) {
+    auto candidate = best;
+    candidate.inline_level = level;
+    trial(candidate);
+  }
+  for (unsigned width : {2U, 4U, 8U}) {
+    auto candidate = best;
+    candidate.vectorize.width = width;
+    trial(candidate);
+  }
+  for (unsigned interleave : {1U, 2U, 4U}) {
+    auto candidate = best;
+    candidate.vectorize.interleave = interleave;
+    trial(candidate);
+  }
+  for (int size : {16, 32}) {
+    auto candidate = best;
+    candidate.block_size = size;
+    trial(candidate);
+  }
+  Logger::debug_log("autotune: inline level " + std::to_string(best.inline_level) +
+                        ", vector width " + std::to_string(best.vectorize.width) +
+                        ", interleave " + std::to_string(best.vectorize.interleave) +
+                        ", block size " + std::to_string(best.block_size) + ", " +
+                        std::to_string(besttime) + " ns per sample",
+                    Logger::INFO);
+  return best;
+}
+
+}  // namespace mimium
@@ -0,0 +1,31 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include "tune_cache.hpp"
+
+namespace llvm {
+class StringRef;
+}  // namespace llvm
+
+namespace mimium {
+
+// Chooses the TuneConfig of a module on this machine. Each candidate compiles a copy of the module,
+// runs mimium_main and measures dsp on noise with AudioDriverOffline, without an audio device.
+// Only dsp is timed, and the output of the candidates is discarded. Options are searched one at a
+// time from the default, keeping the fastest.
+class AutoTuner {
+ public:
+  // blocks of 256 frames processed for each candidate.
+  static constexpr int tune_blocks = 48000 * 2 / 256;
+  // candidates must be faster than the best by this ratio, to ignore noise of the measurement.
+  static constexpr double min_gain = 0.02;
+  static TuneConfig tune(llvm::Module const& m);
+
+ private:
+  // nanoseconds per sample, or infinity if dsp is not found.
+  static double measure(llvm::StringRef bitcode, TuneConfig const& config);
+};
+
+}  // namespace mimium
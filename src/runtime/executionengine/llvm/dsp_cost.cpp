@@ -0,0 +1,391 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "dsp_cost.hpp"
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <unordered_set>
+#include "basic/helper_functions.hpp"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Target/TargetMachine.h"
+
+namespace mimium {
+
+namespace {
+constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+struct CallCost {
+  double fixed;
+  // added for each element of the product of the size arguments, e.g. the length of an array.
+  double per_element = 0.0;
+  std::vector<unsigned> size_args = {};
+};
+
+// rough cycles per call, measured on x86-64 by calling each function repeatedly with varying
+// arguments. they differ between cpus and math libraries, and only the order of magnitude is
+// meaningful. builtins taking a context have it as the first argument.
+const std::unordered_map<std::string_view, CallCost> call_costs = {
+    {"sin", {35.0}},
+    {"cos", {34.0}},
+    {"tan", {48.0}},
+    {"asin", {17.0}},
+    {"acos", {20.0}},
+    {"atan", {26.0}},
+    {"atan2", {49.0}},
+    {"sinh", {48.0}},
+    {"cosh", {26.0}},
+    {"tanh", {46.0}},
+    {"exp", {21.0}},
+    {"log", {18.0}},
+    {"log10", {30.0}},
+    {"pow", {51.0}},
+    {"cbrt", {50.0}},
+    {"fmod", {150.0}},
+    {"remainder", {41.0}},
+    {"sqrt", {6.0}},
+    {"fabs", {6.0}},
+    {"floor", {6.0}},
+    {"ceil", {6.0}},
+    {"trunc", {6.0}},
+    {"round", {6.0}},
+    {"fmin", {6.0}},
+    {"fmax", {6.0}},
+    {"mimium_ge", {6.0}},
+    {"mimium_eq", {6.0}},
+    {"mimium_noteq", {6.0}},
+    {"mimium_le", {6.0}},
+    {"mimium_gt", {6.0}},
+    {"mimium_lt", {6.0}},
+    {"mimium_not", {6.0}},
+    {"mimium_and", {13.0}},
+    {"mimium_or", {13.0}},
+    {"mimium_lshift", {9.0}},
+    {"mimium_rshift", {9.0}},
+    {"mimium_delayprim", {180.0}},
+    {"mimium_memprim", {8.0}},
+    {"mimium_blsaw", {90.0}},
+    {"mimium_blsquare", {91.0}},
+    {"mimium_bltri", {87.0}},
+    {"mimium_wavetable", {40.0}},
+    // (ctx,in,coeffs,nsections,state)
+    {"mimium_sos", {30.0, 6.5, {3}}},
+    // (ctx,in,nch,coeffs,nsections,state)
+    {"mimium_sosmulti", {30.0, 6.0, {2, 4}}},
+    // partitioned convolution, (ctx,in,ir,irsize,state)
+    {"mimium_convolve", {300.0, 0.05, {3}}},
+    // amortized fft of frames, excluding the spectral function. (ctx,in,fftsize,...)
+    {"mimium_stft", {250.0, 0.012, {2}}},
+    // polyphase filter of (ctx,in,factor,state). the inner function is called by generated code.
+    {"mimium_oversample_up", {110.0, 48.0, {2}}},
+    // the factor is not an argument, 4 is assumed.
+    {"mimium_oversample_down", {150.0}},
+    // (ctx,array,size,pos,speed,quality) at the speed of 1.
+    {"mimium_readsinc", {90.0}},
+    // evaluate n samples serially, (u,y,n,...)
+    {"mimium_recurrence1", {10.0, 9.5, {2}}},
+    {"mimium_recurrence2", {10.0, 9.5, {2}}},
+    // array operations with the size as the last argument.
+    {"mimium_arrayfill", {25.0, 0.7, {3}}},
+    {"mimium_arraycopy", {25.0, 0.7, {3}}},
+    {"mimium_arrayadd", {35.0, 0.8, {4}}},
+    {"mimium_arraysub", {35.0, 0.8, {4}}},
+    {"mimium_arraymul", {35.0, 0.8, {4}}},
+    {"mimium_arraydiv", {35.0, 2.0, {4}}},
+    {"mimium_arrayscale", {30.0, 1.4, {5}}},
+    {"mimium_arraydot", {30.0, 1.5, {3}}},
+    {"mimium_arraysum", {20.0, 1.4, {2}}},
+    {"mimium_arraymin", {20.0, 2.4, {2}}},
+    {"mimium_arraymax", {20.0, 2.4, {2}}},
+    // excluding the function called for each element.
+    {"mimium_arraymap", {25.0, 2.7, {3}}},
+    {"mimium_arrayfold", {25.0, 2.7, {2}}},
+    {"access_array_lin_interp", {100.0}},
+    {"mimiumrand", {56.0}},
+};
+
+// intrinsics of these functions are instructions on common targets, and left to the cost model.
+const std::unordered_set<std::string_view> instruction_intrinsics = {"sqrt",  "fabs", "floor",
+                                                                     "ceil",  "trunc", "round"};
+
+double getInstructionCost(llvm::TargetTransformInfo const& tti, llvm::Instruction& inst) {
+  const auto kind = llvm::TargetTransformInfo::TCK_RecipThroughput;
+#if LLVM_VERSION_MAJOR >= 12
+  auto cost = tti.getInstructionCost(&inst, kind);
+  return cost.isValid() ? static_cast<double>(*cost.getValue()) : 1.0;
+#else
+  const int cost = tti.getInstructionCost(&inst, kind);
+  return cost >= 0 ? static_cast<double>(cost) : 1.0;
+#endif
+}
+
+int countDoubles(llvm::Type* type) {
+  if (type->isDoubleTy()) { return 1; }
+  if (auto* st = llvm::dyn_cast<llvm::StructType>(type)) {
+    int res = 0;
+    for (auto* elem : st->elements()) { res += countDoubles(elem); }
+    return res;
+  }
+  if (auto* at = llvm::dyn_cast<llvm::ArrayType>(type)) {
+    return static_cast<int>(at->getNumElements()) * countDoubles(at->getElementType());
+  }
+  return 0;
+}
+
+std::string toFixed(double v) {
+  std::ostringstream ss;
+  ss.setf(std::ios::fixed);
+  ss.precision(1);
+  ss << v;
+  return ss.str();
+}
+}  // namespace
+
+bool DspCostEstimator::hasCallCost(llvm::StringRef name) {
+  return call_costs.count(std::string_view(name.data(), name.size())) > 0;
+}
+
+// intrinsics of library functions(e.g. llvm.sin.f64) are looked up by the name of the function and
+// counted for each lane of vectors, and others are left to the cost model.
+std::optional<double> DspCostEstimator::getExternalCallCost(llvm::CallInst const& call) const {
+  const auto* callee = call.getCalledFunction();
+  if (callee == nullptr) { return unknown_call_cost; }
+  auto name = callee->getName();
+  const bool intrinsic = callee->isIntrinsic();
+  if (intrinsic) { name = name.drop_front(std::string_view("llvm.").size()).split('.').first; }
+  const std::string_view key(name.data(), name.size());
+  auto iter = call_costs.find(key);
+  if (intrinsic && (iter == call_costs.end() || instruction_intrinsics.count(key) > 0)) {
+    return std::nullopt;
+  }
+  if (iter == call_costs.end()) { return unknown_call_cost; }
+  auto const& cost = iter->second;
+  double res = cost.fixed;
+  if (!cost.size_args.empty()) {
+    double size = 1.0;
+    for (auto idx : cost.size_args) {
+      if (idx < call.arg_size()) { size *= getSize(call.getArgOperand(idx)); }
+    }
+    res += cost.per_element * size;
+  }
+  if (auto* vt = llvm::dyn_cast<llvm::FixedVectorType>(call.getType())) {
+    res *= vt->getNumElements();
+  }
+  return res;
+}
+
+double DspCostEstimator::getSize(llvm::Value const* v) const {
+  if (const auto* c = llvm::dyn_cast<llvm::ConstantFP>(v)) {
+    return std::max(c->getValueAPF().convertToDouble(), 0.0);
+  }
+  if (const auto* c = llvm::dyn_cast<llvm::ConstantInt>(v)) {
+    return static_cast<double>(std::max<int64_t>(c->getSExtValue(), 0));
+  }
+  if (v == frames) { return block_size; }
+  return unknown_size;
+}
+
+void DspCostEstimator::addBlock(llvm::BasicBlock& bb, llvm::TargetTransformInfo const& tti,
+                                double freq, double& self, double& total) {
+  for (auto& inst : bb) {
+    double cost = 0.0;
+    double callees = 0.0;
+    auto* call = llvm::dyn_cast<llvm::CallInst>(&inst);
+    auto* callee = call != nullptr ? call->getCalledFunction() : nullptr;
+    if (callee != nullptr && !callee->isDeclaration()) {
+      cost = getInstructionCost(tti, inst);
+      callees = getTotal(*callee);
+    } else if (call != nullptr) {
+      cost = getExternalCallCost(*call).value_or(getInstructionCost(tti, inst));
+    } else {
+      cost = getInstructionCost(tti, inst);
+    }
+    self += freq * cost;
+    total += freq * (cost + callees);
+  }
+}
+
+double DspCostEstimator::getTotal(llvm::Function& f) {
+  if (auto iter = visited.find(&f); iter != visited.end()) {
+    // recursive calls are counted once.
+    return iter->second == npos ? 0.0 : functions[iter->second].total;
+  }
+  visited.emplace(&f, npos);
+  const size_t idx = functions.size();
+  functions.emplace_back(FunctionCost{f.getName().str()});
+  llvm::DominatorTree dt(f);
+  llvm::LoopInfo li(dt);
+  llvm::BranchProbabilityInfo bpi(f, li);
+  llvm::BlockFrequencyInfo bfi(f, bpi, li);
+  auto tti = tm.getTargetTransformInfo(f);
+  const auto entryfreq = static_cast<double>(bfi.getEntryFreq());
+  double self = 0.0;
+  double total = 0.0;
+  for (auto& bb : f) {
+    const double freq = static_cast<double>(bfi.getBlockFreq(&bb).getFrequency()) / entryfreq;
+    addBlock(bb, tti, freq, self, total);
+  }
+  functions[idx].self = self;
+  functions[idx].total = total;
+  visited[&f] = idx;
+  return total;
+}
+
+namespace {
+struct FrameLoop {
+  // frames processed by an iteration.
+  int64_t step = 1;
+  // starts from where the previous vectorized loop stopped.
+  bool remainder = false;
+};
+
+// the loop over frames is found by its integer induction variable increased by a constant.
+FrameLoop analyzeFrameLoop(llvm::Loop const& loop) {
+  auto* latch = loop.getLoopLatch();
+  if (latch == nullptr) { return {}; }
+  for (auto& phi : loop.getHeader()->phis()) {
+    if (!phi.getType()->isIntegerTy()) { continue; }
+    auto* next = llvm::dyn_cast<llvm::BinaryOperator>(phi.getIncomingValueForBlock(latch));
+    if (next == nullptr || next->getOpcode() != llvm::Instruction::Add ||
+        next->getOperand(0) != &phi) {
+      continue;
+    }
+    auto* step = llvm::dyn_cast<llvm::ConstantInt>(next->getOperand(1));
+    if (step == nullptr || step->getSExtValue() <= 0) { continue; }
+    FrameLoop res{step->getSExtValue(), false};
+    for (unsigned idx = 0; idx < phi.getNumIncomingValues(); idx++) {
+      if (!loop.contains(phi.getIncomingBlock(idx)) &&
+          !llvm::isa<llvm::ConstantInt>(phi.getIncomingValue(idx))) {
+        res.remainder = true;
+      }
+    }
+    return res;
+  }
+  return {};
+}
+}  // namespace
+
+double DspCostEstimator::getBlockTotal(llvm::Function& f) {
+  visited.emplace(&f, npos);
+  const size_t idx = functions.size();
+  functions.emplace_back(FunctionCost{f.getName().str()});
+  llvm::DominatorTree dt(f);
+  llvm::LoopInfo li(dt);
+  llvm::BranchProbabilityInfo bpi(f, li);
+  llvm::BlockFrequencyInfo bfi(f, bpi, li);
+  auto tti = tm.getTargetTransformInfo(f);
+  // iterations of the frame loops in the order of the code.
+  std::vector<llvm::Loop*> loops(li.begin(), li.end());
+  std::unordered_map<const llvm::BasicBlock*, size_t> order;
+  for (auto& bb : f) { order.emplace(&bb, order.size()); }
+  std::sort(loops.begin(), loops.end(), [&](auto* a, auto* b) {
+    return order.at(a->getHeader()) < order.at(b->getHeader());
+  });
+  std::unordered_map<const llvm::Loop*, double> iterations;
+  int64_t rest = 0;
+  for (auto* loop : loops) {
+    const auto frameloop = analyzeFrameLoop(*loop);
+    if (frameloop.remainder) {
+      iterations[loop] = static_cast<double>(rest / frameloop.step);
+      rest = 0;
+    } else {
+      iterations[loop] = static_cast<double>(block_size / frameloop.step);
+      rest = block_size % frameloop.step;
+    }
+  }
+  const auto entryfreq = static_cast<double>(bfi.getEntryFreq());
+  double self = 0.0;
+  double total = 0.0;
+  for (auto& bb : f) {
+    const auto blockfreq = static_cast<double>(bfi.getBlockFreq(&bb).getFrequency());
+    double freq = blockfreq / entryfreq;
+    if (auto* loop = li.getLoopFor(&bb)) {
+      while (loop->getParentLoop() != nullptr) { loop = loop->getParentLoop(); }
+      const auto headerfreq = bfi.getBlockFreq(loop->getHeader()).getFrequency();
+      freq = iterations.at(loop) * blockfreq / static_cast<double>(headerfreq);
+    }
+    addBlock(bb, tti, freq, self, total);
+  }
+  functions[idx].self = self;
+  functions[idx].total = total;
+  visited[&f] = idx;
+  return total;
+}
+
+int DspCostEstimator::countChannels(llvm::Function& dsp, unsigned argidx) {
+  if (dsp.arg_size() <= argidx) { return 0; }
+  auto* type = dsp.getArg(argidx)->getType();
+  if (!type->isPointerTy()) { return 0; }
+  return countDoubles(llvm::cast<llvm::PointerType>(type)->getElementType());
+}
+
+std::optional<DspCostEstimator::Report> DspCostEstimator::estimate(llvm::Module& m,
+                                                                   llvm::TargetMachine& tm,
+                                                                   int block_size) {
+  auto* dsp = m.getFunction("dsp");
+  if (dsp == nullptr || dsp->isDeclaration()) { return std::nullopt; }
+  auto* blockfn = m.getFunction("dsp.block");
+  DspCostEstimator estimator(tm);
+  Report res;
+  // (out,in,cls,memobj)
+  res.channels = countChannels(*dsp, 0) + countChannels(*dsp, 1);
+  if (blockfn != nullptr && !blockfn->isDeclaration() && block_size > 0) {
+    // (out,in,cls,memobj,frames)
+    estimator.block_size = block_size;
+    estimator.frames = blockfn->getArg(blockfn->arg_size() - 1);
+    res.block_size = block_size;
+    res.per_sample = estimator.getBlockTotal(*blockfn) / block_size;
+  } else {
+    res.per_sample = estimator.getTotal(*dsp);
+  }
+  res.per_sample += res.channels * channel_io_cost;
+  res.functions = std::move(estimator.functions);
+  return res;
+}
+
+DspCostEstimator::Check DspCostEstimator::check(Report const& report, CostBudget const& budget) {
+  const double mhz = budget.cpu_mhz > 0.0 ? budget.cpu_mhz : detectCpuMhz();
+  const double limit = budget.load * mhz * 1e6 / budget.samplerate;
+  Check res;
+  res.exceeded = report.per_sample > limit;
+  res.message = "estimated cost of dsp is " + toFixed(report.per_sample) +
+                " cycles per sample, the budget is " + toFixed(limit) + " cycles(" +
+                toFixed(budget.load * 100.0) + "% of " + toFixed(mhz) + "MHz at " +
+                toFixed(budget.samplerate) + "Hz)";
+  if (report.block_size > 0) {
+    res.message += ", processed in blocks of " + std::to_string(report.block_size) + " frames";
+  }
+  for (auto&& f : report.functions) {
+    res.message += "\n  " + f.name + ": " + toFixed(f.total) + " cycles per call, " +
+                   toFixed(f.self) + " in itself";
+  }
+  return res;
+}
+
+// maximum clock of the first core on linux, or the current clock in /proc/cpuinfo. 3GHz is
+// assumed if neither is available.
+double DspCostEstimator::detectCpuMhz() {
+  std::ifstream maxfreq("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
+  double khz = 0.0;
+  if (maxfreq >> khz && khz > 0.0) { return khz / 1000.0; }
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.rfind("cpu MHz", 0) != 0) { continue; }
+    const auto pos = line.find(':');
+    if (pos != std::string::npos) { return std::stod(line.substr(pos + 1)); }
+  }
+  Logger::debug_log("clock of the cpu is not detected, 3000MHz is assumed", Logger::WARNING);
+  return 3000.0;
+}
+
+}  // namespace mimium
@@ -0,0 +1,101 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace llvm {
+class Module;
+class Function;
+class Instruction;
+class BasicBlock;
+class Value;
+class Argument;
+class CallInst;
+class StringRef;
+class TargetMachine;
+class TargetTransformInfo;
+}  // namespace llvm
+
+namespace mimium {
+
+// Limit of the estimated cost of dsp. The check is disabled if load is zero.
+struct CostBudget {
+  // ratio of a core which dsp may use.
+  double load = 0.0;
+  double samplerate = 48000.0;
+  // clock of the cpu, detected if zero.
+  double cpu_mhz = 0.0;
+  // compilation fails if the estimate exceeds the budget, otherwise a warning is logged.
+  bool error = false;
+};
+
+// Static estimate of the cycles per sample of `dsp` from the optimized IR.
+// Instructions are weighted by their reciprocal throughput in the cost model of the target and by
+// the frequencies of their blocks relative to the entry. Calls of functions in the module add the
+// cost of the callee, and calls of builtin and library functions add the costs measured for them.
+// If dsp.block is generated, it is estimated instead for a call processing a block, and the cost
+// is divided by the frames. Its frame loops run once per frame divided by the step of their
+// induction variable, and the remainder loops after vectorized loops run for the rest.
+class DspCostEstimator {
+ public:
+  struct FunctionCost {
+    std::string name;
+    // cycles per call, excluding and including callees.
+    double self = 0.0;
+    double total = 0.0;
+  };
+  struct Report {
+    // dsp.block or dsp first, then callees in the order they are reached.
+    std::vector<FunctionCost> functions;
+    int channels = 0;
+    // frames per call of dsp.block, 0 if dsp is estimated.
+    int block_size = 0;
+    // including the copies of channels by the audio driver.
+    double per_sample = 0.0;
+  };
+  struct Check {
+    // the estimate, the budget and the breakdown by function.
+    std::string message;
+    bool exceeded = false;
+  };
+  // cycles of calls of external functions not in the table.
+  static constexpr double unknown_call_cost = 50.0;
+  // copy of a sample between the device buffer and the dsp buffer.
+  static constexpr double channel_io_cost = 2.0;
+  // elements assumed for the size arguments of builtins which are not constant.
+  static constexpr double unknown_size = 64.0;
+
+  // returns nullopt if the module has no dsp. dsp.block is estimated if it exists and block_size
+  // is positive.
+  static std::optional<Report> estimate(llvm::Module& m, llvm::TargetMachine& tm,
+                                        int block_size = 0);
+  static Check check(Report const& report, CostBudget const& budget);
+  static double detectCpuMhz();
+  // if the cost of calls of the external function is in the table.
+  static bool hasCallCost(llvm::StringRef name);
+
+ private:
+  explicit DspCostEstimator(llvm::TargetMachine& tm) : tm(tm) {}
+  double getTotal(llvm::Function& f);
+  double getBlockTotal(llvm::Function& f);
+  // adds the cost of the instructions in the block and of their callees, weighted by freq.
+  void addBlock(llvm::BasicBlock& bb, llvm::TargetTransformInfo const& tti, double freq,
+                double& self, double& total);
+  std::optional<double> getExternalCallCost(llvm::CallInst const& call) const;
+  [[nodiscard]] double getSize(llvm::Value const* v) const;
+  static int countChannels(llvm::Function& dsp, unsigned argidx);
+  llvm::TargetMachine& tm;
+  // frames of a call of dsp.block, and its argument.
+  int block_size = 0;
+  const llvm::Argument* frames = nullptr;
+  // index in functions, or npos while the function is being estimated.
+  std::unordered_map<llvm::Function*, size_t> visited;
+  std::vector<FunctionCost> functions;
+};
+
+}  // namespace mimium
@@ -0,0 +1,191 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "dsp_profile.hpp"
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <unordered_set>
+#include "basic/helper_functions.hpp"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Module.h"
+
+namespace mimium {
+
+namespace {
+constexpr std::string_view header = "mimium-profile 1";
+}  // namespace
+
+DspProfile DspProfile::load(std::string const& path) {
+  std::ifstream fin(path);
+  std::string line;
+  if (!fin || !std::getline(fin, line) || line != header) {
+    throw std::runtime_error("failed to read profile " + path);
+  }
+  DspProfile res;
+  std::string tag;
+  std::string name;
+  size_t numbranches = 0;
+  while (fin >> tag) {
+    FunctionCounts counts;
+    if (tag != "fn" || !(fin >> name >> counts.entry >> numbranches)) {
+      throw std::runtime_error("invalid profile " + path);
+    }
+    counts.branches.resize(numbranches);
+    for (auto& [t, f] : counts.branches) {
+      if (!(fin >> t >> f)) { throw std::runtime_error("invalid profile " + path); }
+    }
+    res.functions.emplace(name, std::move(counts));
+  }
+  return res;
+}
+
+void DspProfile::save(std::string const& path) const {
+  std::ofstream fout(path);
+  if (!fout) { throw std::runtime_error("failed to write profile " + path); }
+  fout << header << "\n";
+  for (auto&& [name, counts] : functions) {
+    fout << "fn " << name << " " << counts.entry << " " << counts.branches.size() << "\n";
+    for (auto&& [t, f] : counts.branches) { fout << t << " " << f << "\n"; }
+  }
+}
+
+// functions reachable from dsp by direct calls, in the order of calls.
+std::vector<llvm::Function*> DspProfile::getDspFunctions(llvm::Module& m) {
+  std::vector<llvm::Function*> res;
+  auto* dsp = m.getFunction("dsp");
+  if (dsp == nullptr || dsp->isDeclaration()) { return res; }
+  std::unordered_set<llvm::Function*> visited = {dsp};
+  res.emplace_back(dsp);
+  for (size_t idx = 0; idx < res.size(); idx++) {
+    for (auto& inst : llvm::instructions(*res[idx])) {
+      auto* call = llvm::dyn_cast<llvm::CallInst>(&inst);
+      auto* callee = call != nullptr ? call->getCalledFunction() : nullptr;
+      if (callee != nullptr && !callee->isDeclaration() && visited.insert(callee).second) {
+        res.emplace_back(callee);
+      }
+    }
+  }
+  return res;
+}
+
+std::vector<llvm::BranchInst*> DspProfile::getBranches(llvm::Function& f) {
+  std::vector<llvm::BranchInst*> res;
+  for (auto& bb : f) {
+    auto* br = llvm::dyn_cast<llvm::BranchInst>(bb.getTerminator());
+    if (br != nullptr && br->isConditional()) { res.emplace_back(br); }
+  }
+  return res;
+}
+
+size_t DspProfile::instrument(llvm::Module& m) {
+  functions.clear();
+  layout.clear();
+  auto fns = getDspFunctions(m);
+  size_t numcounters = 0;
+  for (auto* f : fns) {
+    const auto numbranches = getBranches(*f).size();
+    layout.emplace_back(f->getName().str(), numbranches);
+    numcounters += 1 + numbranches * 2;
+  }
+  if (numcounters == 0) { return 0; }
+  auto& ctx = m.getContext();
+  auto* i64 = llvm::Type::getInt64Ty(ctx);
+  auto* arraytype = llvm::ArrayType::get(i64, numcounters);
+  auto* counters = new llvm::GlobalVariable(m, arraytype, false, llvm::GlobalValue::ExternalLinkage,
+                                            llvm::ConstantAggregateZero::get(arraytype),
+                                            counters_name);
+  llvm::IRBuilder<> builder(ctx);
+  auto increment = [&](llvm::Value* idx) {
+    auto* ptr = builder.CreateInBoundsGEP(arraytype, counters, {builder.getInt64(0), idx});
+    auto* count = builder.CreateLoad(i64, ptr);
+    builder.CreateStore(builder.CreateAdd(count, builder.getInt64(1)), ptr);
+  };
+  uint64_t offset = 0;
+  for (auto* f : fns) {
+    auto branches = getBranches(*f);
+    builder.SetInsertPoint(&*f->getEntryBlock().getFirstInsertionPt());
+    increment(builder.getInt64(offset++));
+    for (auto* br : branches) {
+      builder.SetInsertPoint(br);
+      increment(builder.CreateSelect(br->getCondition(), builder.getInt64(offset),
+                                     builder.getInt64(offset + 1)));
+      offset += 2;
+    }
+  }
+  return numcounters;
+}
+
+void DspProfile::readCounters(const uint64_t* counters) {
+  functions.clear();
+  for (auto&& [name, numbranches] : layout) {
+    FunctionCounts counts;
+    counts.entry = *counters++;
+    counts.branches.resize(numbranches);
+    for (auto& [t, f] : counts.branches) {
+      t = *counters++;
+      f = *counters++;
+    }
+    functions.emplace(name, std::move(counts));
+  }
+}
+
+// weights are offset by one as zero weights are not distinguished from missing ones.
+void DspProfile::setBranchWeights(llvm::BranchInst* br, std::pair<uint64_t, uint64_t> counts) {
+  constexpr uint64_t limit = std::numeric_limits<uint32_t>::max() - 1;
+  const uint64_t scale = std::max(counts.first, counts.second) / limit + 1;
+  llvm::MDBuilder mdbuilder(br->getContext());
+  br->setMetadata(llvm::LLVMContext::MD_prof,
+                  mdbuilder.createBranchWeights(static_cast<uint32_t>(counts.first / scale + 1),
+                                                static_cast<uint32_t>(counts.second / scale + 1)));
+}
+
+void DspProfile::apply(llvm::Module& m) const {
+  auto dspcounts = functions.find("dsp");
+  if (dspcounts == functions.end()) {
+    Logger::debug_log("profile has no count of dsp", Logger::WARNING);
+    return;
+  }
+  const auto hot_threshold = static_cast<uint64_t>(dspcounts->second.entry * hot_ratio);
+  for (auto* f : getDspFunctions(m)) {
+    auto iter = functions.find(f->getName().str());
+    if (iter == functions.end()) { continue; }
+    const auto& counts = iter->second;
+    auto branches = getBranches(*f);
+    if (branches.size() != counts.branches.size()) {
+      Logger::debug_log("profile of " + iter->first + " does not match the source, ignored",
+                        Logger::WARNING);
+      continue;
+    }
+    f->setEntryCount(counts.entry);
+    for (size_t idx = 0; idx < branches.size(); idx++) {
+      auto* br = branches[idx];
+      const auto [t, nt] = counts.branches[idx];
+      setBranchWeights(br, counts.branches[idx]);
+      // keeps the taken path contiguous by moving the never-taken side after the others.
+      if ((t == 0) != (nt == 0)) {
+        auto* cold = br->getSuccessor(t == 0 ? 0 : 1);
+        if (cold->getSinglePredecessor() == br->getParent() && cold != &f->back()) {
+          cold->moveAfter(&f->back());
+        }
+      }
+    }
+    if (f->getName() == "dsp") { continue; }
+    const bool isrecursive = std::any_of(f->user_begin(), f->user_end(), [&](llvm::User* u) {
+      auto* inst = llvm::dyn_cast<llvm::Instruction>(u);
+      return inst != nullptr && inst->getFunction() == f;
+    });
+    if (counts.entry == 0) {
+      f->addFnAttr(llvm::Attribute::Cold);
+    } else if (counts.entry >= hot_threshold && !isrecursive &&
+               !f->hasFnAttribute(llvm::Attribute::NoInline)) {
+      f->addFnAttr(llvm::Attribute::AlwaysInline);
+    }
+  }
+}
+
+}  // namespace mimium
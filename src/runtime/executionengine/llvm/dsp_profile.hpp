@@ -0,0 +1,56 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class Module;
+class Function;
+class BranchInst;
+}  // namespace llvm
+
+namespace mimium {
+
+// Branch and call frequencies of `dsp` and the functions called from it.
+// An instrumented module counts the entries of the functions and both sides of each conditional
+// branch into a global array, which is read after the run and saved to a text file. A later
+// compile of the same source uses the counts to set branch weights and entry counts, to move
+// never-taken blocks to the end of the function, and to inline callees entered in most samples.
+// Branches are identified by their order in the function, so that a profile of a modified source
+// is ignored per function if the number of branches does not match.
+class DspProfile {
+ public:
+  struct FunctionCounts {
+    uint64_t entry = 0;
+    // counts of the true and false successors of each conditional branch.
+    std::vector<std::pair<uint64_t, uint64_t>> branches;
+  };
+  // name of the global array of counters in instrumented modules.
+  static constexpr const char* counters_name = "mimium.profile.counters";
+  // callees entered in this ratio of calls of dsp or more are inlined.
+  static constexpr double hot_ratio = 0.5;
+
+  static DspProfile load(std::string const& path);
+  void save(std::string const& path) const;
+  // returns the number of counters. the module is not modified if it has no dsp.
+  size_t instrument(llvm::Module& m);
+  // reads the counters of the module instrumented by this profile.
+  void readCounters(const uint64_t* counters);
+  void apply(llvm::Module& m) const;
+  [[nodiscard]] const auto& getFunctions() const { return functions; }
+
+ private:
+  static std::vector<llvm::Function*> getDspFunctions(llvm::Module& m);
+  static std::vector<llvm::BranchInst*> getBranches(llvm::Function& f);
+  static void setBranchWeights(llvm::BranchInst* br, std::pair<uint64_t, uint64_t> counts);
+  std::map<std::string, FunctionCounts> functions;
+  // functions and numbers of their branches in the order of counters.
+  std::vector<std::pair<std::string, size_t>> layout;
+};
+
+}  // namespace mimium
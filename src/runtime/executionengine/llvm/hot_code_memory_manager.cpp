@@ -0,0 +1,151 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "hot_code_memory_manager.hpp"
+#include <system_error>
+#include <unordered_set>
+#include <vector>
+#include "basic/helper_functions.hpp"
+#include "llvm/ADT/Triple.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Process.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+namespace mimium {
+
+namespace {
+constexpr const char* hot_section = ".text.mimium.hot";
+// section name of Mach-O is limited to 16 characters.
+constexpr const char* hot_section_macho = "__mimium_hot";
+// transparent huge pages of x86-64 and aarch64 with 4KiB base pages.
+constexpr size_t huge_page_size = 2 * 1024 * 1024;
+}  // namespace
+
+HotCodeMemoryManager::~HotCodeMemoryManager() {
+  if (mapped.base() == nullptr) { return; }
+#ifndef _WIN32
+  if (locked) { ::munlock(hot.base(), hot.allocatedSize()); }
+#endif
+  llvm::sys::Memory::releaseMappedMemory(mapped);
+}
+
+void HotCodeMemoryManager::markHotFunctions(llvm::Module& m) {
+  std::vector<llvm::Function*> hotfns;
+  std::unordered_set<llvm::Function*> visited;
+  for (const auto* name : {"dsp", "dsp.block"}) {
+    auto* f = m.getFunction(name);
+    if (f != nullptr && !f->isDeclaration() && visited.insert(f).second) { hotfns.emplace_back(f); }
+  }
+  for (size_t idx = 0; idx < hotfns.size(); idx++) {
+    for (auto& inst : llvm::instructions(*hotfns[idx])) {
+      auto* call = llvm::dyn_cast<llvm::CallInst>(&inst);
+      auto* callee = call != nullptr ? call->getCalledFunction() : nullptr;
+      if (callee != nullptr && !callee->isDeclaration() && visited.insert(callee).second) {
+        hotfns.emplace_back(callee);
+      }
+    }
+  }
+  const auto& triple = m.getTargetTriple();
+  const bool ismacho =
+      llvm::Triple(triple.empty() ? llvm::sys::getProcessTriple() : triple).isOSBinFormatMachO();
+  const std::string section = ismacho ? "__TEXT," + std::string(hot_section_macho) +
+                                            ",regular,pure_instructions"
+                                      : std::string(hot_section);
+  for (auto* f : hotfns) { f->setSection(section); }
+}
+
+bool HotCodeMemoryManager::isHotSection(llvm::StringRef name) {
+  return name == hot_section || name == hot_section_macho;
+}
+
+uint8_t* HotCodeMemoryManager::allocateCodeSection(uintptr_t size, unsigned alignment,
+                                                   unsigned sectionid,
+                                                   llvm::StringRef sectionname) {
+  if (usage) { usage->code += size; }
+  if (!options.separate || !isHotSection(sectionname) || mapped.base() != nullptr) {
+    return SectionMemoryManager::allocateCodeSection(size, alignment, sectionid, sectionname);
+  }
+  const size_t pagesize =
+      options.huge_pages ? huge_page_size : llvm::sys::Process::getPageSizeEstimate();
+  const size_t hotsize = llvm::alignTo(std::max<size_t>(size, 1), pagesize);
+  // mapping is extended to align the start to the huge page.
+  const size_t mapsize = options.huge_pages ? hotsize + huge_page_size : hotsize;
+  unsigned flags = llvm::sys::Memory::MF_READ | llvm::sys::Memory::MF_WRITE;
+  if (options.huge_pages) { flags |= llvm::sys::Memory::MF_HUGE_HINT; }
+  std::error_code ec;
+  mapped = mapRegion(mapsize, flags, ec);
+  if (ec || mapped.base() == nullptr) {
+    if (!ec) { ec = std::make_error_code(std::errc::not_enough_memory); }
+    Logger::debug_log("failed to allocate hot code region: " + ec.message(), Logger::WARNING);
+    mapped = llvm::sys::MemoryBlock();
+    return SectionMemoryManager::allocateCodeSection(size, alignment, sectionid, sectionname);
+  }
+  const size_t align = std::max<size_t>(pagesize, alignment);
+  auto* begin = reinterpret_cast<uint8_t*>(
+      llvm::alignTo(reinterpret_cast<uintptr_t>(mapped.base()), align));
+  hot = llvm::sys::MemoryBlock(begin, hotsize);
+  if (options.huge_pages && !adviseHugePages(begin, hotsize)) {
+    Logger::debug_log("huge pages are not available for hot code", Logger::WARNING);
+  }
+  if (options.lock) {
+    locked = lockRegion(begin, hotsize);
+    if (!locked) { Logger::debug_log("failed to lock hot code region", Logger::WARNING); }
+  }
+  if (usage) {
+    usage->hot_begin = reinterpret_cast<uintptr_t>(begin);
+    usage->hot_size = hotsize;
+    usage->hot_locked = locked;
+  }
+  return begin;
+}
+
+uint8_t* HotCodeMemoryManager::allocateDataSection(uintptr_t size, unsigned alignment,
+                                                   unsigned sectionid, llvm::StringRef sectionname,
+                                                   bool isreadonly) {
+  if (usage) { usage->data += size; }
+  return SectionMemoryManager::allocateDataSection(size, alignment, sectionid, sectionname,
+                                                   isreadonly);
+}
+
+llvm::sys::MemoryBlock HotCodeMemoryManager::mapRegion(size_t size, unsigned flags,
+                                                      std::error_code& ec) {
+  return llvm::sys::Memory::allocateMappedMemory(size, nullptr, flags, ec);
+}
+
+bool HotCodeMemoryManager::adviseHugePages(void* addr, size_t size) {
+#ifdef MADV_HUGEPAGE
+  return ::madvise(addr, size, MADV_HUGEPAGE) == 0;
+#else
+  return false;
+#endif
+}
+
+bool HotCodeMemoryManager::lockRegion(void* addr, size_t size) {
+#ifndef _WIN32
+  return ::mlock(addr, size) == 0;
+#else
+  return false;
+#endif
+}
+
+bool HotCodeMemoryManager::finalizeMemory(std::string* errmsg) {
+  if (SectionMemoryManager::finalizeMemory(errmsg)) { return true; }
+  if (hot.base() == nullptr) { return false; }
+  auto ec = llvm::sys::Memory::protectMappedMemory(
+      hot, llvm::sys::Memory::MF_READ | llvm::sys::Memory::MF_EXEC);
+  if (ec) {
+    if (errmsg != nullptr) { *errmsg = ec.message(); }
+    return true;
+  }
+  llvm::sys::Memory::InvalidateInstructionCache(hot.base(), hot.allocatedSize());
+  return false;
+}
+
+}  // namespace mimium
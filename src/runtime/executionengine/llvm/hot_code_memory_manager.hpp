@@ -0,0 +1,69 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Memory.h"
+
+namespace mimium {
+
+// Memory manager of the JIT that places the code of `dsp`, `dsp.block` and the functions called
+// from them in a separate region, so that the audio callback does not touch the pages of
+// initialization code in `mimium_main` or scheduled tasks. The hot functions are put in one
+// section by markHotFunctions and the section is allocated contiguously. The region can be
+// backed by huge pages and locked in physical memory. Other sections are allocated by
+// SectionMemoryManager.
+class HotCodeMemoryManager : public llvm::SectionMemoryManager {
+ public:
+  struct Options {
+    // if false, the hot section is allocated among other code as SectionMemoryManager does.
+    bool separate = true;
+    bool huge_pages = false;
+    bool lock = false;
+  };
+  // sizes of the sections allocated by the managers sharing it, and the separate region of the
+  // last hot section(empty if it was allocated among other code).
+  struct Usage {
+    std::atomic<size_t> code = 0;
+    std::atomic<size_t> data = 0;
+    std::atomic<uintptr_t> hot_begin = 0;
+    std::atomic<size_t> hot_size = 0;
+    std::atomic<bool> hot_locked = false;
+  };
+  explicit HotCodeMemoryManager(Options options, std::shared_ptr<Usage> usage = nullptr)
+      : options(options), usage(std::move(usage)) {}
+  HotCodeMemoryManager(HotCodeMemoryManager const&) = delete;
+  HotCodeMemoryManager& operator=(HotCodeMemoryManager const&) = delete;
+  ~HotCodeMemoryManager() override;
+
+  // puts the functions reachable from dsp and dsp.block by direct calls in the hot section.
+  static void markHotFunctions(llvm::Module& m);
+  static bool isHotSection(llvm::StringRef name);
+
+  uint8_t* allocateCodeSection(uintptr_t size, unsigned alignment, unsigned sectionid,
+                               llvm::StringRef sectionname) override;
+  uint8_t* allocateDataSection(uintptr_t size, unsigned alignment, unsigned sectionid,
+                               llvm::StringRef sectionname, bool isreadonly) override;
+  bool finalizeMemory(std::string* errmsg) override;
+
+ protected:
+  // calls to the system, overridden by tests to simulate failures.
+  virtual llvm::sys::MemoryBlock mapRegion(size_t size, unsigned flags, std::error_code& ec);
+  virtual bool adviseHugePages(void* addr, size_t size);
+  virtual bool lockRegion(void* addr, size_t size);
+
+ private:
+  Options options;
+  std::shared_ptr<Usage> usage;
+  // whole mapping and the part of it used for the hot section.
+  llvm::sys::MemoryBlock mapped;
+  llvm::sys::MemoryBlock hot;
+  bool locked = false;
+};
+
+}  // namespace mimium
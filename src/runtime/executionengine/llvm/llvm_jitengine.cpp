@@ -3,9 +3,83 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "llvm_jitengine.hpp"
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/IR/InstIterator.h>
 #include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SourceMgr.h>
+#include <cstring>
+#include <iostream>
+#include <unordered_set>
+#include "autotuner.hpp"
 #include "basic/error_def.hpp"
+#include "compiler/ffi.hpp"
+#include "dsp_profile.hpp"
 #include "mimium_llvm_orcjit.hpp"
+#include "runtime/backend/audiodriver.hpp"
+#include "runtime/runtime.hpp"
+
+namespace {
+// functions of the runtime and libc called from generated code, merged with the builtins in
+// getSymbols().
+const std::unordered_map<std::string, void*> runtime_symbols = {
+    {"setDspParams", reinterpret_cast<void*>(&mimium::setDspParams)},
+    {"addTask", reinterpret_cast<void*>(&mimium::addTask)},
+    {"mimium_getnow", reinterpret_cast<void*>(&mimium::mimium_getnow)},
+    {"mimium_addeventstream", reinterpret_cast<void*>(&mimium::mimium_addeventstream)},
+    {"mimium_malloc", reinterpret_cast<void*>(&mimium::mimium_malloc)},
+    {"mimium_getbuiltincontext", reinterpret_cast<void*>(&mimium::mimium_getbuiltincontext)},
+    {"memset", reinterpret_cast<void*>(&memset)},
+    {"memcpy", reinterpret_cast<void*>(&memcpy)},
+    {"memmove", reinterpret_cast<void*>(&memmove)}};
+
+// materializes the functions reachable from the entry points and global variables, and removes
+// the others. bodies of unused functions in a lazily loaded bitcode are never read.
+void materializeReachable(llvm::Module& m) {
+  std::vector<llvm::GlobalValue*> worklist;
+  std::unordered_set<const llvm::Value*> visited;
+  std::function<void(llvm::Value*)> collect = [&](llvm::Value* v) {
+    if (!llvm::isa<llvm::Constant>(v) || !visited.insert(v).second) { return; }
+    if (auto* gv = llvm::dyn_cast<llvm::GlobalValue>(v)) {
+      worklist.emplace_back(gv);
+      return;
+    }
+    for (auto& op : llvm::cast<llvm::Constant>(v)->operands()) { collect(op.get()); }
+  };
+  for (auto& gv : m.global_values()) {
+    if (llvm::isa<llvm::GlobalVariable>(gv) || llvm::orc::MimiumJIT::isEntryPoint(gv)) {
+      collect(&gv);
+    }
+  }
+  while (!worklist.empty()) {
+    auto* gv = worklist.back();
+    worklist.pop_back();
+    if (auto* var = llvm::dyn_cast<llvm::GlobalVariable>(gv)) {
+      if (var->hasInitializer()) { collect(var->getInitializer()); }
+    } else if (auto* alias = llvm::dyn_cast<llvm::GlobalAlias>(gv)) {
+      collect(alias->getAliasee());
+    } else if (auto* f = llvm::dyn_cast<llvm::Function>(gv)) {
+      if (auto err = f->materialize()) {
+        throw mimium::RuntimeError(llvm::toString(std::move(err)));
+      }
+      for (auto& inst : llvm::instructions(*f)) {
+        for (auto& op : inst.operands()) { collect(op.get()); }
+      }
+    }
+  }
+  std::vector<llvm::Function*> unused;
+  for (auto& f : m) {
+    if (visited.count(&f) == 0) { unused.emplace_back(&f); }
+  }
+  for (auto* f : unused) { f->deleteBody(); }
+  for (auto* f : unused) {
+    if (f->use_empty()) { f->eraseFromParent(); }
+  }
+  if (auto err = m.materializeAll()) { throw mimium::RuntimeError(llvm::toString(std::move(err))); }
+}
+
+}  // namespace
+
 namespace mimium {
 LLVMJitExecutionEngine::LLVMJitExecutionEngine(std::unique_ptr<llvm::LLVMContext> ctx,
                                                std::unique_ptr<llvm::Module> module,
@@ -17,23 +91,109 @@ LLVMJitExecutionEngine::LLVMJitExecutionEngine(std::unique_ptr<llvm::LLVMContext
 LLVMJitExecutionEngine::LLVMJitExecutionEngine(std::string const& filepath, bool optimize)
     : ExecutionEngine(), module() {
   auto ctx = std::make_unique<llvm::LLVMContext>();
-  llvm::SMDiagnostic errorreporter;
-  module = llvm::parseIRFile(filepath, errorreporter, *ctx);
+  module = loadIRFile(filepath, *ctx);
   initInternal(std::move(ctx), optimize);
 }
-LLVMJitExecutionEngine::~LLVMJitExecutionEngine() = default;
+// the module not added yet(e.g. main function never ran) belongs to the context owned by the jit.
+LLVMJitExecutionEngine::~LLVMJitExecutionEngine() { module.reset(); }
+// bitcode files are mapped and loaded lazily. text IR is parsed entirely from the mapped file.
+std::unique_ptr<llvm::Module> LLVMJitExecutionEngine::loadIRFile(std::string const& filepath,
+                                                                llvm::LLVMContext& ctx) {
+  auto buffer = llvm::MemoryBuffer::getFile(filepath);
+  if (!buffer) {
+    throw mimium::RuntimeError("failed to read " + filepath + " : " + buffer.getError().message());
+  }
+  std::unique_ptr<llvm::Module> res;
+  auto* start = reinterpret_cast<const unsigned char*>((*buffer)->getBufferStart());
+  if (llvm::isBitcode(start, start + (*buffer)->getBufferSize())) {
+    auto module = llvm::getOwningLazyBitcodeModule(std::move(*buffer), ctx);
+    if (!module) {
+      throw mimium::RuntimeError(filepath + " : " + llvm::toString(module.takeError()));
+    }
+    res = std::move(*module);
+  } else {
+    llvm::SMDiagnostic errorreporter;
+    res = llvm::parseIR((*buffer)->getMemBufferRef(), errorreporter, ctx);
+    if (!res) { throw mimium::RuntimeError(filepath + " : " + errorreporter.getMessage().str()); }
+  }
+  materializeReachable(*res);
+  return res;
+}
+const std::unordered_map<std::string, void*>& LLVMJitExecutionEngine::getSymbols() {
+  static const auto symbols = []() {
+    auto res = LLVMBuiltin::symbols;
+    res.insert(runtime_symbols.begin(), runtime_symbols.end());
+    return res;
+  }();
+  return symbols;
+}
 
 void LLVMJitExecutionEngine::initInternal(std::unique_ptr<llvm::LLVMContext> ctx, bool optimize) {
-  llvm::InitializeNativeTarget();
-  llvm::InitializeNativeTargetAsmPrinter();
-  llvm::InitializeNativeTargetAsmParser();
-  llvm::InitializeNativeTargetDisassembler();
+  // registration of the target is not thread safe, while engines may be created concurrently.
+  static const bool initialized = [] {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+    llvm::InitializeNativeTargetDisassembler();
+    return true;
+  }();
+  static_cast<void>(initialized);
   using optlevel = llvm::orc::MimiumJIT::OptimizeLevel;
   auto opt = optimize ? optlevel::NORMAL : optlevel::NO;
   jitengine = std::make_unique<llvm::orc::MimiumJIT>(std::move(ctx), opt);
+  if (auto err = jitengine->addSymbols(getSymbols())) {
+    std::string tmpout;
+    llvm::raw_string_ostream oss(tmpout);
+    oss << err;
+    throw mimium::RuntimeError(oss.str());
+  }
+}
+void LLVMJitExecutionEngine::setProfileOutput(std::string path) {
+  profile_out = std::make_unique<DspProfile>();
+  profile_out_path = std::move(path);
+}
+void LLVMJitExecutionEngine::setProfileInput(std::string const& path) {
+  profile_in = std::make_unique<DspProfile>(DspProfile::load(path));
+}
+void LLVMJitExecutionEngine::setHotCodeOptions(bool separate, bool huge_pages, bool lock) {
+  jitengine->setCodeMemoryOptions({separate, huge_pages, lock});
+}
+void LLVMJitExecutionEngine::setTuneCache(std::string path, bool tune) {
+  tune_cache_path = std::move(path);
+  autotune = tune;
+}
+void LLVMJitExecutionEngine::setTuneConfig(TuneConfig const& config) {
+  jitengine->setTuneConfig(config);
+}
+void LLVMJitExecutionEngine::setCostBudget(CostBudget const& budget) {
+  jitengine->setCostBudget(budget);
+}
+size_t LLVMJitExecutionEngine::getCodeBytes() const {
+  return jitengine->getCodeUsage().code;
+}
+size_t LLVMJitExecutionEngine::getDataBytes() const {
+  return jitengine->getCodeUsage().data;
+}
+void LLVMJitExecutionEngine::applyTuneCache() {
+  auto cache = TuneCache::load(tune_cache_path);
+  const auto key = TuneCache::getKey(*module);
+  auto config = cache.find(key);
+  if (!config && autotune) {
+    if (module->getFunction("dsp") == nullptr) {
+      Logger::debug_log("autotune is skipped as dsp function is not found", Logger::INFO);
+      return;
+    }
+    config = AutoTuner::tune(*module);
+    cache.insert(key, config.value());
+    cache.save(tune_cache_path);
+  }
+  if (config) { jitengine->setTuneConfig(config.value()); }
 }
 bool LLVMJitExecutionEngine::runMainFunction(Runtime* runtime_ptr) {
   assert(module != nullptr);
+  if (!tune_cache_path.empty()) { applyTuneCache(); }
+  if (profile_in) { profile_in->apply(*module); }
+  if (profile_out) { num_counters = profile_out->instrument(*module); }
   llvm::Error err = jitengine->addModule(std::move(this->module));
   if (err) { llvm::errs() << err << "\n"; };
   auto mainfun = jitengine->lookup("mimium_main");
@@ -44,11 +204,23 @@ bool LLVMJitExecutionEngine::runMainFunction(Runtime* runtime_ptr) {
     oss << mainfun.takeError();
     throw mimium::RuntimeError(oss.str());
   }
+  // the estimate is reported whenever a budget is given.
+  const auto& cost = jitengine->getCostCheck();
+  if (cost.result) {
+    auto const& result = cost.result.value();
+    if (result.exceeded && cost.budget.error) { throw mimium::RuntimeError(result.message); }
+    if (result.exceeded) {
+      Logger::debug_log(result.message, Logger::WARNING);
+    } else {
+      std::cerr << result.message << std::endl;
+    }
+  }
 
   auto mimium_main_function =
       llvm::jitTargetAddressToPointer<void* (*)(void*)>(mainfun->getAddress());
   //
   mimium_main_function(runtime_ptr);
+  runtime_ptr->getAudioDriver().setBlockSize(jitengine->getTuneConfig().block_size);
   //
   auto symbol_or_error = jitengine->lookup("dsp");
   if (!symbol_or_error) {
@@ -59,5 +231,20 @@ bool LLVMJitExecutionEngine::runMainFunction(Runtime* runtime_ptr) {
   }
   return true;
 }
+void LLVMJitExecutionEngine::postStop() {
+  if (!profile_out) { return; }
+  if (num_counters == 0) {
+    Logger::debug_log("profile is not written as dsp function is not found", Logger::WARNING);
+    return;
+  }
+  auto counters = jitengine->lookup(DspProfile::counters_name);
+  if (!counters) {
+    llvm::consumeError(counters.takeError());
+    throw mimium::RuntimeError("profile counters not found");
+  }
+  profile_out->readCounters(llvm::jitTargetAddressToPointer<uint64_t*>(counters->getAddress()));
+  profile_out->save(profile_out_path);
+  Logger::debug_log("profile written to " + profile_out_path, Logger::INFO);
+}
 
 }  // namespace mimium
\ No newline at end of file
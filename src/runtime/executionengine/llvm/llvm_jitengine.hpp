@@ -5,6 +5,7 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include "runtime/executionengine/executionengine.hpp"
 
 namespace llvm {
@@ -16,6 +17,9 @@ class MimiumJIT;
 }  // namespace llvm
 
 namespace mimium {
+class DspProfile;
+struct TuneConfig;
+struct CostBudget;
 
 class MIMIUM_DLL_PUBLIC LLVMJitExecutionEngine : public ExecutionEngine {
  public:
@@ -25,13 +29,49 @@ class MIMIUM_DLL_PUBLIC LLVMJitExecutionEngine : public ExecutionEngine {
                                   bool optimize = true);
   explicit LLVMJitExecutionEngine(std::string const& filepath, bool optimize = true);
   ~LLVMJitExecutionEngine() override;
+  // functions called from generated code by their symbol names: the builtins(LLVMBuiltin::symbols)
+  // and the functions of the runtime and libc.
+  static const std::unordered_map<std::string, void*>& getSymbols();
+  // loads a bitcode or text IR file. only the functions reachable from the entry points and
+  // global variables are kept.
+  static std::unique_ptr<llvm::Module> loadIRFile(std::string const& filepath,
+                                                  llvm::LLVMContext& ctx);
   bool runMainFunction(Runtime* runtime_ptr) override;
+  // writes the profile of the instrumented run.
+  void postStop() override;
+  // counts branches and calls of dsp and writes them to the path when the runtime stops. must be
+  // called before runMainFunction.
+  void setProfileOutput(std::string path);
+  // uses a profile written by an instrumented run. must be called before runMainFunction.
+  void setProfileInput(std::string const& path);
+  // places the code of dsp and its callees apart from other code, optionally backed by huge pages
+  // and locked in memory. must be called before runMainFunction.
+  void setHotCodeOptions(bool separate, bool huge_pages, bool lock);
+  // uses the configuration of code generation for the module and this machine in the cache. if it
+  // is not found and tune is true, it is chosen by AutoTuner and saved to the cache. must be called
+  // before runMainFunction.
+  void setTuneCache(std::string path, bool tune);
+  // must be called before runMainFunction.
+  void setTuneConfig(TuneConfig const& config);
+  // estimates the cost of the optimized dsp and checks it against the budget. must be called
+  // before runMainFunction.
+  void setCostBudget(CostBudget const& budget);
+  // sizes of the code and data sections emitted by the jit so far.
+  [[nodiscard]] size_t getCodeBytes() const;
+  [[nodiscard]] size_t getDataBytes() const;
 
  private:
   // called by constructor.
   void initInternal(std::unique_ptr<llvm::LLVMContext> ctx, bool optimize);
+  void applyTuneCache();
   std::unique_ptr<llvm::Module> module;
   std::unique_ptr<llvm::orc::MimiumJIT> jitengine;
+  std::unique_ptr<DspProfile> profile_in;
+  std::unique_ptr<DspProfile> profile_out;
+  std::string profile_out_path;
+  size_t num_counters = 0;
+  std::string tune_cache_path;
+  bool autotune = false;
 };
 
 }  // namespace mimium
\ No newline at end of file
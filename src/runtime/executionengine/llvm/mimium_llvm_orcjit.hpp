@@ -7,6 +7,7 @@
 #include <memory>
 
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/ExecutionEngine/JITSymbol.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
 #include "llvm/ExecutionEngine/Orc/Core.h"
@@ -25,7 +26,10 @@
 
 #include "llvm/Support/Error.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Target/TargetMachine.h"
 
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/AlwaysInliner.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
@@ -33,6 +37,11 @@
 #include "llvm/Transforms/Vectorize.h"
 
 #include "basic/helper_functions.hpp"  //load NO_SANITIZE
+#include "dsp_cost.hpp"
+#include "dsp_profile.hpp"
+#include "hot_code_memory_manager.hpp"
+#include "sample_loop_splitter.hpp"
+#include "tune_cache.hpp"
 
 #define LAZY_ENABLE 0
 #if LAZY_ENABLE
@@ -44,6 +53,17 @@
 namespace llvm::orc {
 class MimiumJIT {
  private:
+  // shared with the memory managers, which are created when modules are compiled.
+  std::shared_ptr<mimium::HotCodeMemoryManager::Options> code_options;
+  std::shared_ptr<mimium::HotCodeMemoryManager::Usage> code_usage;
+  // read when the module is optimized.
+  std::shared_ptr<mimium::TuneConfig> tune_config;
+  struct CostCheck {
+    mimium::CostBudget budget;
+    // set by the transform if the budget is given and the module has dsp.
+    std::optional<mimium::DspCostEstimator::Check> result;
+  };
+  std::shared_ptr<CostCheck> cost_check;
   std::unique_ptr<LLJITCLASS> lllazyjit;
 
   ExecutionSession& ES;
@@ -57,7 +77,11 @@ class MimiumJIT {
   enum OptimizeLevel { NO = 0, NORMAL = 1 } optimize_level;
   explicit MimiumJIT(std::unique_ptr<LLVMContext> ctx,
                      OptimizeLevel optimizelevel = OptimizeLevel::NO)
-      : lllazyjit(createEngine()),
+      : code_options(std::make_shared<mimium::HotCodeMemoryManager::Options>()),
+        code_usage(std::make_shared<mimium::HotCodeMemoryManager::Usage>()),
+        tune_config(std::make_shared<mimium::TuneConfig>()),
+        cost_check(std::make_shared<CostCheck>()),
+        lllazyjit(createEngine(code_options, code_usage)),
         ES(lllazyjit->getExecutionSession()),
         DL(lllazyjit->getDataLayout()),
         MainJD(lllazyjit->getMainJITDylib()),
@@ -65,30 +89,52 @@ class MimiumJIT {
         Ctx(std::move(ctx)),
         optimize_level(optimizelevel) {
     if (optimize_level == OptimizeLevel::NORMAL) {
+      auto transform = [config = tune_config, cost = cost_check](
+                           ThreadSafeModule M, const MaterializationResponsibility& R) {
+        return optimizeModule(std::move(M), R, *config, *cost);
+      };
 #if LAZY_ENABLE
-      lllazyjit->setLazyCompileTransform(optimizeModule);
+      lllazyjit->setLazyCompileTransform(transform);
 #else
-      lllazyjit->getIRTransformLayer().setTransform(optimizeModule);
+      lllazyjit->getIRTransformLayer().setTransform(transform);
 #endif
     }
-// MainJD.getExecutionSession()
+    // symbols not defined by addSymbols(e.g. libc functions called by the optimized code) are
+    // searched in the process, if it is available.
+    auto generator = DynamicLibrarySearchGenerator::GetForCurrentProcess(DL.getGlobalPrefix());
+    if (!generator) {
+      consumeError(generator.takeError());
+      return;
+    }
 #if LLVM_VERSION_MAJOR >= 10
-    MainJD.addGenerator(
-        cantFail(DynamicLibrarySearchGenerator::GetForCurrentProcess(DL.getGlobalPrefix())));
+    MainJD.addGenerator(std::move(generator.get()));
 #else
-    MainJD.setGenerator(
-        cantFail(DynamicLibrarySearchGenerator::GetForCurrentProcess(DL.getGlobalPrefix())));
+    MainJD.setGenerator(std::move(generator.get()));
 #endif
   }
   // Creates LLJIT engine. Note that builder.create causes container overflow inside llvm library.
   // maybe in llvm::LLVMTargetMachine::initAsmInfo()?
 
-  NO_SANITIZE static std::unique_ptr<LLJITCLASS> createEngine() {
+  NO_SANITIZE static std::unique_ptr<LLJITCLASS> createEngine(
+      std::shared_ptr<mimium::HotCodeMemoryManager::Options> const& options,
+      std::shared_ptr<mimium::HotCodeMemoryManager::Usage> const& usage) {
 #if LAZY_ENABLE
     auto builder = LLLazyJITBuilder();
 #else
     auto builder = LLJITBuilder();
 #endif
+    builder.setObjectLinkingLayerCreator(
+        [options, usage](ExecutionSession& es,
+                         const Triple& tt) -> std::unique_ptr<ObjectLayer> {
+          auto layer = std::make_unique<RTDyldObjectLinkingLayer>(es, [options, usage]() {
+            return std::make_unique<mimium::HotCodeMemoryManager>(*options, usage);
+          });
+          if (tt.isOSBinFormatCOFF()) {
+            layer->setOverrideObjectFlagsWithResponsibilityFlags(true);
+            layer->setAutoClaimResponsibilityForObjectSymbols(true);
+          }
+          return layer;
+        });
     auto jit = builder.create();
     if (!jit) { llvm::errs() << jit.takeError() << "\n"; }
     return std::move(jit.get());
@@ -101,50 +147,102 @@ class MimiumJIT {
 #endif
   }
   Expected<JITEvaluatedSymbol> lookup(StringRef name) { return lllazyjit->lookup(name); }
+  // must be set before the module is compiled.
+  void setCodeMemoryOptions(mimium::HotCodeMemoryManager::Options options) {
+    *code_options = options;
+  }
+  // must be set before the module is compiled.
+  void setTuneConfig(mimium::TuneConfig const& config) { *tune_config = config; }
+  [[nodiscard]] const mimium::TuneConfig& getTuneConfig() const { return *tune_config; }
+  // must be set before the module is compiled.
+  void setCostBudget(mimium::CostBudget const& budget) { cost_check->budget = budget; }
+  [[nodiscard]] const CostCheck& getCostCheck() const { return *cost_check; }
+  [[nodiscard]] const mimium::HotCodeMemoryManager::Usage& getCodeUsage() const {
+    return *code_usage;
+  }
 
-  Error addSymbol(StringRef name, void* ptr) {
-    // auto symbol = JITEvaluatedSymbol(pointerToJITTargetAddress(&puts),
-    // JITSymbolFlags::Absolute); auto res =    MainJD.define(absoluteSymbols({{
-    // Mangle("puts"), symbol}}));
-    // symbol.setFlags(JITSymbolFlags::FlagNames::Callable);
-    // auto res = lllazyjit->defineAbsolute(name, symbol);
-    auto res = lllazyjit->lookup("addTask");
-    ES.dump(errs());
-
-    // auto address =
-    // jitTargetAddressToPointer<int(*)(char*)>(test->getAddress());
-    MainJD.dump(errs());
-    return res.takeError();
+  // defines functions as absolute symbols before modules are linked.
+  template <class Map>
+  Error addSymbols(Map const& symbols) {
+    SymbolMap map;
+    for (auto&& [name, address] : symbols) {
+      map[Mangle(name)] = JITEvaluatedSymbol(pointerToJITTargetAddress(address),
+                                             JITSymbolFlags::Exported | JITSymbolFlags::Callable);
+    }
+    return MainJD.define(absoluteSymbols(std::move(map)));
   }
 
+  // cost model of the vectorizer needs the information of the host cpu.
+  static TargetMachine& getHostTargetMachine() {
+    static auto tm =
+        cantFail(cantFail(JITTargetMachineBuilder::detectHost()).createTargetMachine());
+    return *tm;
+  }
+  // symbols looked up by the runtime or the audio driver.
+  static bool isEntryPoint(const GlobalValue& gv) {
+    const auto name = gv.getName();
+    return name == "mimium_main" || name == "dsp" || name == "dsp.block" ||
+           name == mimium::DspProfile::counters_name;
+  }
   static Expected<ThreadSafeModule> optimizeModule(ThreadSafeModule M,
-                                                   const MaterializationResponsibility& R) {
-// Create a function pass manager.
+                                                   const MaterializationResponsibility& R,
+                                                   mimium::TuneConfig const& config,
+                                                   CostCheck& cost) {
+// Run the optimizations over all functions in the module being added to
+// the JIT.
 #if LLVM_VERSION_MAJOR >= 10
-    auto FPM = std::make_unique<legacy::FunctionPassManager>(M.getModuleUnlocked());
+    M.withModuleDo([&](Module& m) { optimize(m, config, &cost); });
 #else
-    auto FPM = std::make_unique<legacy::FunctionPassManager>(M.getModule());
+    optimize(*M.getModule(), config, &cost);
 #endif
+    return M;
+  }
+  // the pipeline applied to modules added to the jit, also used by tests to inspect the ir. the
+  // cost is not checked if it is null.
+  static void optimize(Module& m, mimium::TuneConfig const& config, CostCheck* cost = nullptr) {
+    // dsp is inlined into the frame loop of dsp.block. small functions are also inlined so that
+    // recurrences on self in them can be found in the frame loop.
+    // functions other than the entry points are internalized so that unused functions in included
+    // libraries are removed and constants are propagated across calls.
+    legacy::PassManager MPM;
+    MPM.add(createInternalizePass(isEntryPoint));
+    MPM.add(createIPSCCPPass());
+    MPM.add(createGlobalDCEPass());
+    MPM.add(createArgumentPromotionPass());
+    MPM.add(createFunctionInliningPass(config.inline_level, 0, false));
+    MPM.add(createAlwaysInlinerLegacyPass());
+    MPM.add(createGlobalDCEPass());
+    MPM.add(createMergeFunctionsPass());
+    // Create a function pass manager.
+    auto FPM = std::make_unique<legacy::FunctionPassManager>(&m);
+    auto LoopPM = std::make_unique<legacy::FunctionPassManager>(&m);
     // Add some optimizations.
     FPM->add(createPromoteMemoryToRegisterPass());  // mem2reg
+    FPM->add(createSROAPass());
     FPM->add(createDeadStoreEliminationPass());
     FPM->add(createInstructionCombiningPass());
     FPM->add(createReassociatePass());
     FPM->add(createGVNPass());
     FPM->add(createCFGSimplificationPass());
-    FPM->add(createLoopInterchangePass());
-    FPM->add(createLoopVectorizePass());
     FPM->doInitialization();
-
-// Run the optimizations over all functions in the module being added to
-// the JIT.
-#if LLVM_VERSION_MAJOR >= 10
-    M.withModuleDo(
-        [&](Module& m) { std::for_each(m.begin(), m.end(), [&](auto& f) { FPM->run(f); }); });
-#else
-    for (auto& f : M.getModule()->functions()) { FPM->run(f); }
-#endif
-    return M;
+    // loop passes run after the frame loop is split into stateless and stateful parts.
+    LoopPM->add(createTargetTransformInfoWrapperPass(getHostTargetMachine().getTargetIRAnalysis()));
+    LoopPM->add(createLoopInterchangePass());
+    LoopPM->add(createLoopVectorizePass());
+    LoopPM->add(createInstructionCombiningPass());
+    LoopPM->doInitialization();
+    MPM.run(m);
+    std::for_each(m.begin(), m.end(), [&](auto& f) { FPM->run(f); });
+    if (auto* blockfn = m.getFunction("dsp.block")) {
+      mimium::SampleLoopSplitter::run(*blockfn, config.vectorize);
+    }
+    std::for_each(m.begin(), m.end(), [&](auto& f) { LoopPM->run(f); });
+    mimium::HotCodeMemoryManager::markHotFunctions(m);
+    if (cost == nullptr || cost->budget.load <= 0.0) { return; }
+    if (auto report =
+            mimium::DspCostEstimator::estimate(m, getHostTargetMachine(), config.block_size)) {
+      cost->result = mimium::DspCostEstimator::check(report.value(), cost->budget);
+    }
   }
   [[nodiscard]] const DataLayout& getDataLayout() const { return DL; }
   LLVMContext& getContext() { return *Ctx.getContext(); }
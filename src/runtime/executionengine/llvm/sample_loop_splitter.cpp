@@ -0,0 +1,575 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "sample_loop_splitter.hpp"
+#include <functional>
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
+#include "runtime/runtime_defs.hpp"
+
+namespace mimium {
+
+bool SampleLoopSplitter::run(llvm::Function& f, VectorizeHints hints) {
+  // (out,in,cls,memobj,nframes)
+  if (f.arg_size() != 5) { return false; }
+  auto loop = findFrameLoop(f);
+  if (!loop) { return false; }
+  SampleLoopSplitter splitter(f, loop.value(), hints);
+  if (!splitter.collectBody()) { return false; }
+  splitter.classify();
+  splitter.hoistInvariants();
+  if (!splitter.replaceRecurrences()) { return false; }
+  if (!splitter.scans.empty()) {
+    // the body only gained stateless instructions, so that it can be collected again.
+    splitter.body.clear();
+    splitter.regions.clear();
+    splitter.after_state.clear();
+    splitter.collectBody();
+    splitter.classify();
+    splitter.hoistInvariants();
+  }
+  const bool hasstate =
+      std::any_of(splitter.body.begin(), splitter.body.end(),
+                  [&](llvm::Instruction* i) { return splitter.regions.at(i) == Region::Mid; });
+  if (!hasstate) {
+    // whole loop is stateless.
+    enableVectorize(llvm::cast<llvm::BranchInst>(loop->body->getTerminator()), hints);
+    return true;
+  }
+  const bool hasstateless =
+      std::any_of(splitter.body.begin(), splitter.body.end(), [&](llvm::Instruction* i) {
+        return splitter.regions.at(i) != Region::Mid &&
+               (i->getType()->isFloatingPointTy() || llvm::isa<llvm::CallInst>(i));
+      });
+  if (!hasstateless) { return false; }
+  splitter.split();
+  return true;
+}
+
+// the loop created by LLVMGenerator::createDspBlockFn: a single block with an index from 0.
+std::optional<SampleLoopSplitter::FrameLoop> SampleLoopSplitter::findFrameLoop(
+    llvm::Function& f) {
+  for (auto& bb : f) {
+    auto* br = llvm::dyn_cast<llvm::BranchInst>(bb.getTerminator());
+    if (br == nullptr || !br->isConditional() || br->getSuccessor(0) != &bb) { continue; }
+    // other phis are states of recurrences carried in registers.
+    llvm::PHINode* index = nullptr;
+    for (auto& phi : bb.phis()) {
+      if (!phi.getType()->isIntegerTy()) { continue; }
+      if (index != nullptr) { return std::nullopt; }
+      index = &phi;
+    }
+    if (index == nullptr || index->getNumIncomingValues() != 2) { return std::nullopt; }
+    const unsigned int preidx = index->getIncomingBlock(0) == &bb ? 1 : 0;
+    auto* start = llvm::dyn_cast<llvm::ConstantInt>(index->getIncomingValue(preidx));
+    auto* next = llvm::dyn_cast<llvm::Instruction>(index->getIncomingValueForBlock(&bb));
+    auto* cond = llvm::dyn_cast<llvm::Instruction>(br->getCondition());
+    auto* exit = br->getSuccessor(1);
+    if (start == nullptr || !start->isZero() || next == nullptr || cond == nullptr ||
+        !exit->phis().empty()) {
+      return std::nullopt;
+    }
+    return FrameLoop{index->getIncomingBlock(preidx), &bb, exit, index, next, cond};
+  }
+  return std::nullopt;
+}
+
+void SampleLoopSplitter::enableVectorize(llvm::BranchInst* br, VectorizeHints hints) {
+  auto& ctx = br->getContext();
+  auto* enable = llvm::MDNode::get(
+      ctx, {llvm::MDString::get(ctx, "llvm.loop.vectorize.enable"),
+            llvm::ConstantAsMetadata::get(llvm::ConstantInt::getTrue(ctx))});
+  llvm::SmallVector<llvm::Metadata*, 4> ops = {nullptr, enable};
+  auto addhint = [&](const char* name, unsigned value) {
+    if (value == 0) { return; }
+    auto* count = llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), value);
+    ops.emplace_back(llvm::MDNode::get(
+        ctx, {llvm::MDString::get(ctx, name), llvm::ConstantAsMetadata::get(count)}));
+  };
+  addhint("llvm.loop.vectorize.width", hints.width);
+  addhint("llvm.loop.interleave.count", hints.interleave);
+  auto* loopid = llvm::MDNode::getDistinct(ctx, ops);
+  loopid->replaceOperandWith(0, loopid);
+  br->setMetadata(llvm::LLVMContext::MD_loop, loopid);
+}
+
+llvm::Instruction* SampleLoopSplitter::getBodyInst(llvm::Value* v) const {
+  auto* inst = llvm::dyn_cast<llvm::Instruction>(v);
+  if (inst == nullptr || inst->getParent() != loop.body || inst == loop.index) { return nullptr; }
+  return inst;
+}
+
+// input buffer is only read and output buffer is only written in the loop.
+bool SampleLoopSplitter::isStateful(llvm::Instruction& inst) const {
+  if (llvm::isa<llvm::PHINode>(inst)) { return true; }
+  auto* out = f.getArg(0);
+  auto* in = f.getArg(1);
+  if (auto* load = llvm::dyn_cast<llvm::LoadInst>(&inst)) {
+    auto* ptr = load->getPointerOperand();
+    const bool readonly = ptr->stripInBoundsOffsets() == in ||
+                          (closure_readonly && getRootPointer(ptr) == f.getArg(2));
+    return load->isVolatile() || !readonly;
+  }
+  if (auto* store = llvm::dyn_cast<llvm::StoreInst>(&inst)) {
+    return store->isVolatile() || store->getPointerOperand()->stripInBoundsOffsets() != out;
+  }
+  if (auto* call = llvm::dyn_cast<llvm::CallInst>(&inst)) { return !call->doesNotAccessMemory(); }
+  return scans.count(&inst) > 0 || inst.mayReadOrWriteMemory() || inst.mayHaveSideEffects();
+}
+
+bool SampleLoopSplitter::collectBody() {
+  for (auto& inst : *loop.body) {
+    if (&inst == loop.index || &inst == loop.next || &inst == loop.cond || inst.isTerminator()) {
+      continue;
+    }
+    if (llvm::isa<llvm::AllocaInst>(inst)) { return false; }
+    for (auto* op : inst.operand_values()) {
+      if (op == loop.next || op == loop.cond) { return false; }
+    }
+    for (auto* user : inst.users()) {
+      auto* userinst = llvm::cast<llvm::Instruction>(user);
+      if (userinst->getParent() != loop.body) { return false; }
+    }
+    body.push_back(&inst);
+  }
+  // captured variables are constant in the block unless dsp assigns them, since no task is
+  // executed in the block.
+  auto* cls = f.getArg(2);
+  closure_readonly = std::none_of(body.begin(), body.end(), [&](llvm::Instruction* i) {
+    if (auto* store = llvm::dyn_cast<llvm::StoreInst>(i)) {
+      return getRootPointer(store->getPointerOperand()) == cls;
+    }
+    auto* call = llvm::dyn_cast<llvm::CallInst>(i);
+    return call != nullptr && !call->doesNotAccessMemory() &&
+           std::any_of(call->arg_begin(), call->arg_end(),
+                       [&](llvm::Use& arg) { return getRootPointer(arg.get()) == cls; });
+  });
+  return true;
+}
+
+// follows the pointers loaded from the closure.
+llvm::Value* SampleLoopSplitter::getRootPointer(llvm::Value* ptr) {
+  auto* v = ptr->stripInBoundsOffsets();
+  while (auto* load = llvm::dyn_cast<llvm::LoadInst>(v)) {
+    v = load->getPointerOperand()->stripInBoundsOffsets();
+  }
+  return v;
+}
+
+void SampleLoopSplitter::classify() {
+  std::unordered_set<llvm::Instruction*> stateful;
+  for (auto* inst : body) {
+    const bool isstateful = isStateful(*inst);
+    if (isstateful) { stateful.insert(inst); }
+    const bool dependent = std::any_of(inst->op_begin(), inst->op_end(), [&](llvm::Use& op) {
+      auto* opinst = getBodyInst(op.get());
+      return opinst != nullptr && after_state.count(opinst) > 0;
+    });
+    if (isstateful || dependent) { after_state.insert(inst); }
+  }
+  // instructions used by stateful instructions.
+  std::unordered_set<llvm::Instruction*> before_state;
+  for (auto iter = body.rbegin(); iter != body.rend(); ++iter) {
+    auto* inst = *iter;
+    const bool feeds = std::any_of(inst->user_begin(), inst->user_end(), [&](llvm::User* u) {
+      auto* userinst = llvm::cast<llvm::Instruction>(u);
+      return stateful.count(userinst) > 0 || before_state.count(userinst) > 0;
+    });
+    if (feeds) { before_state.insert(inst); }
+  }
+  for (auto* inst : body) {
+    const bool isafter = after_state.count(inst) > 0;
+    Region r = Region::Pre;
+    if (stateful.count(inst) > 0 || (isafter && before_state.count(inst) > 0)) {
+      r = Region::Mid;
+    } else if (isafter) {
+      r = Region::Post;
+    }
+    regions.emplace(inst, r);
+  }
+}
+
+// stateless instructions which do not depend on the frame are moved before the loop.
+void SampleLoopSplitter::hoistInvariants() {
+  auto* insertpoint = loop.preheader->getTerminator();
+  std::vector<llvm::Instruction*> remaining;
+  for (auto* inst : body) {
+    // loads and calls left in this region only read the input or the closure, or are pure.
+    const bool invariant =
+        regions.at(inst) == Region::Pre &&
+        (llvm::isSafeToSpeculativelyExecute(inst) || llvm::isa<llvm::LoadInst>(inst) ||
+         llvm::isa<llvm::CallInst>(inst)) &&
+        std::none_of(inst->op_begin(), inst->op_end(),
+                     [&](llvm::Use& op) {
+                       return op.get() == loop.index || getBodyInst(op.get()) != nullptr;
+                     }) &&
+        // inputs of the scans are passed through buffers even if they are constant.
+        std::none_of(inst->user_begin(), inst->user_end(), [&](llvm::User* u) {
+          return scans.count(llvm::cast<llvm::Instruction>(u)) > 0;
+        });
+    if (invariant) {
+      inst->moveBefore(insertpoint);
+      regions.erase(inst);
+    } else {
+      remaining.push_back(inst);
+    }
+  }
+  body = std::move(remaining);
+}
+
+// values carried across frames in registers are only allowed as the states of the recurrences.
+bool SampleLoopSplitter::replaceRecurrences() {
+  std::vector<Recurrence> found;
+  for (auto* inst : body) {
+    auto* store = llvm::dyn_cast<llvm::StoreInst>(inst);
+    if (store == nullptr) { continue; }
+    if (auto rec = matchRecurrence(store)) { found.push_back(std::move(rec.value())); }
+  }
+  for (auto* inst : body) {
+    if (!llvm::isa<llvm::PHINode>(inst)) { continue; }
+    const bool isstate = std::any_of(found.begin(), found.end(),
+                                     [&](const Recurrence& rec) { return rec.y1 == inst; });
+    if (!isstate) { return false; }
+  }
+  for (auto& rec : found) { replaceRecurrence(rec); }
+  return true;
+}
+
+// the value is a sum of the states multiplied by invariants and the input, which does not depend
+// on any stateful instructions.
+bool SampleLoopSplitter::isLinearIn(llvm::Value* v, const std::vector<llvm::Value*>& states,
+                                    std::vector<llvm::Instruction*>& terms) const {
+  std::function<bool(llvm::Value*)> depends = [&](llvm::Value* val) {
+    if (std::find(states.begin(), states.end(), val) != states.end()) { return true; }
+    auto* inst = getBodyInst(val);
+    return inst != nullptr && !llvm::isa<llvm::PHINode>(inst) &&
+           std::any_of(inst->op_begin(), inst->op_end(),
+                       [&](llvm::Use& op) { return depends(op.get()); });
+  };
+  if (std::find(states.begin(), states.end(), v) != states.end()) { return true; }
+  auto* inst = getBodyInst(v);
+  if (!depends(v)) { return inst == nullptr || after_state.count(inst) == 0; }
+  terms.push_back(inst);
+  switch (inst->getOpcode()) {
+    case llvm::Instruction::FAdd:
+    case llvm::Instruction::FSub:
+      return isLinearIn(inst->getOperand(0), states, terms) &&
+             isLinearIn(inst->getOperand(1), states, terms);
+    case llvm::Instruction::FNeg: return isLinearIn(inst->getOperand(0), states, terms);
+    case llvm::Instruction::FMul: {
+      auto* coeff = inst->getOperand(0);
+      auto* rhs = inst->getOperand(1);
+      if (depends(coeff)) { std::swap(coeff, rhs); }
+      return !depends(coeff) && getBodyInst(coeff) == nullptr && isLinearIn(rhs, states, terms);
+    }
+    default: return false;
+  }
+}
+
+// clones the linear expression replacing the states. the input is replaced with zero unless
+// keepinput is set.
+llvm::Value* SampleLoopSplitter::evalLinear(
+    llvm::IRBuilderBase& builder, llvm::Value* v,
+    const std::unordered_map<llvm::Value*, llvm::Value*>& states,
+    const std::unordered_set<llvm::Instruction*>& terms, bool keepinput) {
+  auto iter = states.find(v);
+  if (iter != states.end()) { return iter->second; }
+  auto* inst = llvm::dyn_cast<llvm::Instruction>(v);
+  if (inst == nullptr || terms.count(inst) == 0) {
+    return keepinput ? v : llvm::ConstantFP::get(v->getType(), 0.0);
+  }
+  auto eval = [&](unsigned int i) {
+    return evalLinear(builder, inst->getOperand(i), states, terms, keepinput);
+  };
+  auto iszero = [](llvm::Value* val) {
+    auto* c = llvm::dyn_cast<llvm::ConstantFP>(val);
+    return c != nullptr && c->isZero();
+  };
+  switch (inst->getOpcode()) {
+    case llvm::Instruction::FAdd: {
+      auto* lhs = eval(0);
+      auto* rhs = eval(1);
+      if (iszero(lhs)) { return rhs; }
+      return iszero(rhs) ? lhs : builder.CreateFAdd(lhs, rhs);
+    }
+    case llvm::Instruction::FSub: {
+      auto* rhs = eval(1);
+      return iszero(rhs) ? eval(0) : builder.CreateFSub(eval(0), rhs);
+    }
+    case llvm::Instruction::FNeg: return builder.CreateFNeg(eval(0));
+    case llvm::Instruction::FMul: {
+      const bool lhsterm = states.count(inst->getOperand(0)) > 0 ||
+                           terms.count(llvm::dyn_cast<llvm::Instruction>(inst->getOperand(0))) > 0;
+      auto* term = eval(lhsterm ? 0 : 1);
+      auto* coeff = inst->getOperand(lhsterm ? 1 : 0);
+      return iszero(term) ? term : builder.CreateFMul(coeff, term);
+    }
+    default: llvm_unreachable("not a linear expression");
+  }
+}
+
+// store y,self where y = u + b1*self(+ b2*mem(self)). self is only accessed by the load before the
+// store, or it is carried from the previous frame by a phi, and the states are not used other than
+// in the expression.
+std::optional<SampleLoopSplitter::Recurrence> SampleLoopSplitter::matchRecurrence(
+    llvm::StoreInst* store) const {
+  auto* slot = store->getPointerOperand();
+  auto* output = getBodyInst(store->getValueOperand());
+  if (store->isVolatile() || getBodyInst(slot) != nullptr || output == nullptr ||
+      !output->getType()->isDoubleTy()) {
+    return std::nullopt;
+  }
+  auto accessesin = [&](llvm::Value* ptr, auto&& pred) {
+    return std::all_of(ptr->user_begin(), ptr->user_end(), [&](llvm::User* u) {
+      auto* userinst = llvm::dyn_cast<llvm::Instruction>(u);
+      return userinst == nullptr || userinst->getParent() != loop.body || pred(userinst);
+    });
+  };
+  Recurrence rec{store, output, nullptr, nullptr, {}};
+  const bool singleload = accessesin(slot, [&](llvm::Instruction* i) {
+    if (i == store) { return true; }
+    auto* load = llvm::dyn_cast<llvm::LoadInst>(i);
+    if (load == nullptr || rec.y1 != nullptr || load->isVolatile() || !load->comesBefore(store)) {
+      return false;
+    }
+    rec.y1 = load;
+    return true;
+  });
+  if (!singleload) { return std::nullopt; }
+  if (rec.y1 == nullptr) {
+    // the load is moved before the loop by GVN.
+    for (auto& phi : loop.body->phis()) {
+      auto* init = llvm::dyn_cast<llvm::LoadInst>(phi.getIncomingValueForBlock(loop.preheader));
+      if (&phi != loop.index && phi.getIncomingValueForBlock(loop.body) == output &&
+          init != nullptr && init->getPointerOperand() == slot) {
+        rec.y1 = &phi;
+      }
+    }
+    if (rec.y1 == nullptr) { return std::nullopt; }
+  }
+  std::vector<llvm::Value*> states = {rec.y1};
+  for (auto* u : rec.y1->users()) {
+    auto* call = llvm::dyn_cast<llvm::CallInst>(u);
+    auto* callee = call != nullptr ? call->getCalledFunction() : nullptr;
+    if (callee != nullptr && callee->getName() == "mimium_memprim" &&
+        call->getArgOperand(0) == rec.y1 && getBodyInst(call->getArgOperand(1)) == nullptr &&
+        accessesin(call->getArgOperand(1), [&](llvm::Instruction* i) { return i == call; })) {
+      rec.y2 = call;
+      states.push_back(call);
+      break;
+    }
+  }
+  if (!isLinearIn(output, states, rec.terms)) { return std::nullopt; }
+  const std::unordered_set<llvm::Instruction*> terms(rec.terms.begin(), rec.terms.end());
+  auto usedinterms = [&](llvm::Instruction* inst) {
+    return std::all_of(inst->user_begin(), inst->user_end(), [&](llvm::User* u) {
+      auto* userinst = llvm::cast<llvm::Instruction>(u);
+      return terms.count(userinst) > 0 || userinst == rec.y2;
+    });
+  };
+  const bool isolated = usedinterms(rec.y1) && (rec.y2 == nullptr || usedinterms(rec.y2)) &&
+                        std::all_of(terms.begin(), terms.end(), [&](llvm::Instruction* i) {
+                          return i == output || usedinterms(i);
+                        });
+  // the recurrence needs some input computed in the frame.
+  const bool hasinput = std::any_of(terms.begin(), terms.end(), [&](llvm::Instruction* i) {
+    return std::any_of(i->op_begin(), i->op_end(), [&](llvm::Use& op) {
+      auto* opinst = getBodyInst(op.get());
+      return opinst != nullptr && opinst != rec.y1 && opinst != rec.y2 && terms.count(opinst) == 0;
+    });
+  });
+  if (!isolated || !hasinput) { return std::nullopt; }
+  return rec;
+}
+
+// the recurrence is replaced by a freeze of its input, and evaluated by the scan.
+void SampleLoopSplitter::replaceRecurrence(Recurrence& rec) {
+  const std::unordered_set<llvm::Instruction*> terms(rec.terms.begin(), rec.terms.end());
+  auto* output = rec.output;
+  auto* zero = llvm::ConstantFP::get(output->getType(), 0.0);
+  auto* one = llvm::ConstantFP::get(output->getType(), 1.0);
+  llvm::IRBuilder<> builder(output);
+  auto* input = evalLinear(builder, output, {{rec.y1, zero}, {rec.y2, zero}}, terms, true);
+  llvm::IRBuilder<> prebuilder(loop.preheader->getTerminator());
+  Scan scan{evalLinear(prebuilder, output, {{rec.y1, one}, {rec.y2, zero}}, terms, false), nullptr,
+            rec.store->getPointerOperand(), nullptr};
+  if (rec.y2 != nullptr) {
+    scan.b2 = evalLinear(prebuilder, output, {{rec.y1, zero}, {rec.y2, one}}, terms, false);
+    scan.state2 = rec.y2->getArgOperand(1);
+  }
+  auto* frozen =
+      llvm::cast<llvm::Instruction>(builder.CreateFreeze(input, output->getName() + ".scan"));
+  output->replaceAllUsesWith(frozen);
+  rec.store->eraseFromParent();
+  llvm::Instruction* init = nullptr;
+  if (auto* phi = llvm::dyn_cast<llvm::PHINode>(rec.y1)) {
+    init = llvm::cast<llvm::Instruction>(phi->getIncomingValueForBlock(loop.preheader));
+  }
+  std::vector<llvm::Instruction*> erased(terms.begin(), terms.end());
+  if (rec.y2 != nullptr) { erased.push_back(rec.y2); }
+  erased.push_back(rec.y1);
+  for (auto* inst : erased) { inst->dropAllReferences(); }
+  for (auto* inst : erased) { inst->eraseFromParent(); }
+  if (init != nullptr && init->use_empty()) { init->eraseFromParent(); }
+  scans.emplace(frozen, scan);
+}
+
+// address calculations are recomputed in each loop rather than passed through buffers.
+bool SampleLoopSplitter::isRematerializable(llvm::Instruction* inst) const {
+  const bool cheap =
+      llvm::isa<llvm::GetElementPtrInst>(inst) || llvm::isa<llvm::CastInst>(inst) ||
+      llvm::isa<llvm::ICmpInst>(inst) ||
+      (llvm::isa<llvm::BinaryOperator>(inst) && inst->getType()->isIntegerTy());
+  return cheap && after_state.count(inst) == 0;
+}
+
+// rematerialized instructions also need their operands in other loops.
+bool SampleLoopSplitter::isUsedInOtherRegion(llvm::Instruction* inst, Region r) const {
+  return std::any_of(inst->user_begin(), inst->user_end(), [&](llvm::User* u) {
+    auto* userinst = llvm::cast<llvm::Instruction>(u);
+    return regions.at(userinst) != r ||
+           (isRematerializable(userinst) && isUsedInOtherRegion(userinst, r));
+  });
+}
+
+bool SampleLoopSplitter::needsBuffer(llvm::Instruction* inst) const {
+  return !isRematerializable(inst) && isUsedInOtherRegion(inst, regions.at(inst));
+}
+
+llvm::Value* SampleLoopSplitter::getBuffer(llvm::Instruction* inst) {
+  auto iter = buffers.find(inst);
+  if (iter != buffers.end()) { return iter->second; }
+  auto& entry = f.getEntryBlock();
+  llvm::IRBuilder<> builder(&entry, entry.getFirstInsertionPt());
+  auto* type = llvm::ArrayType::get(inst->getType(), max_dspblock);
+  auto* buf = builder.CreateAlloca(type, nullptr, inst->getName() + ".frames");
+  buffers.emplace(inst, buf);
+  return buf;
+}
+
+llvm::Value* SampleLoopSplitter::getValueFor(llvm::Instruction* inst, llvm::IRBuilderBase& builder,
+                                             llvm::Value* index, llvm::ValueToValueMapTy& vmap) {
+  auto iter = vmap.find(inst);
+  if (iter != vmap.end()) { return iter->second; }
+  llvm::Value* res = nullptr;
+  if (isRematerializable(inst)) {
+    for (auto* op : inst->operand_values()) {
+      if (auto* opinst = getBodyInst(op)) { getValueFor(opinst, builder, index, vmap); }
+    }
+    auto* clone = inst->clone();
+    clone->setName(inst->getName());
+    builder.Insert(clone);
+    llvm::RemapInstruction(clone, vmap,
+                           llvm::RF_NoModuleLevelChanges | llvm::RF_IgnoreMissingLocals);
+    res = clone;
+  } else {
+    auto* buf = getBuffer(inst);
+    auto* ptr = builder.CreateInBoundsGEP(llvm::cast<llvm::AllocaInst>(buf)->getAllocatedType(),
+                                          buf, {builder.getInt32(0), index});
+    res = builder.CreateLoad(inst->getType(), ptr, inst->getName());
+  }
+  vmap[inst] = res;
+  return res;
+}
+
+llvm::BasicBlock* SampleLoopSplitter::createLoop(Region r, llvm::BasicBlock* pred) {
+  auto& ctx = f.getContext();
+  const char* name = "frame.state";
+  if (r != Region::Mid) { name = r == Region::Pre ? "frame.pre" : "frame.post"; }
+  auto* bb = llvm::BasicBlock::Create(ctx, name, &f, loop.exit);
+  llvm::IRBuilder<> builder(bb);
+  auto* indextype = loop.index->getType();
+  auto* index = builder.CreatePHI(indextype, 2, "frameindex");
+  llvm::ValueToValueMapTy vmap;
+  vmap[loop.index] = index;
+  for (auto* inst : body) {
+    if (regions.at(inst) != r || scans.count(inst) > 0) { continue; }
+    for (auto* op : inst->operand_values()) {
+      if (auto* opinst = getBodyInst(op)) { getValueFor(opinst, builder, index, vmap); }
+    }
+    auto* clone = inst->clone();
+    clone->setName(inst->getName());
+    builder.Insert(clone);
+    llvm::RemapInstruction(clone, vmap,
+                           llvm::RF_NoModuleLevelChanges | llvm::RF_IgnoreMissingLocals);
+    vmap[inst] = clone;
+    if (needsBuffer(inst)) {
+      auto* buf = getBuffer(inst);
+      auto* ptr =
+          builder.CreateInBoundsGEP(llvm::cast<llvm::AllocaInst>(buf)->getAllocatedType(), buf,
+                                    {builder.getInt32(0), index});
+      builder.CreateStore(clone, ptr);
+    }
+  }
+  auto* next = builder.CreateAdd(index, llvm::ConstantInt::get(indextype, 1), "nextframe", false,
+                                 true);
+  auto* cond = builder.CreateICmpSLT(next, f.getArg(4));
+  // the successor on exit is set by the caller.
+  auto* br = builder.CreateCondBr(cond, bb, loop.exit);
+  index->addIncoming(llvm::ConstantInt::get(indextype, 0), pred);
+  index->addIncoming(next, bb);
+  if (r != Region::Mid) { enableVectorize(br, hints); }
+  return bb;
+}
+
+// the recurrences are evaluated after their inputs are computed in the loop before.
+llvm::BasicBlock* SampleLoopSplitter::createScan(llvm::BasicBlock* pred) {
+  auto* bb = llvm::BasicBlock::Create(f.getContext(), "frame.scan", &f, loop.exit);
+  llvm::IRBuilder<> builder(bb);
+  auto* zero = builder.getInt32(0);
+  auto getbufptr = [&](llvm::Instruction* inst) {
+    auto* buf = getBuffer(inst);
+    return builder.CreateInBoundsGEP(llvm::cast<llvm::AllocaInst>(buf)->getAllocatedType(), buf,
+                                     {zero, zero});
+  };
+  for (auto* inst : body) {
+    auto iter = scans.find(inst);
+    if (iter == scans.end()) { continue; }
+    auto& scan = iter->second;
+    auto* input = llvm::cast<llvm::Instruction>(inst->getOperand(0));
+    std::vector<llvm::Value*> args = {getbufptr(input), getbufptr(inst), f.getArg(4), scan.b1};
+    const char* name = "mimium_recurrence1";
+    if (scan.b2 != nullptr) {
+      args.insert(args.end(), {scan.b2, scan.state1, scan.state2});
+      name = "mimium_recurrence2";
+    } else {
+      args.push_back(scan.state1);
+    }
+    std::vector<llvm::Type*> types;
+    std::transform(args.begin(), args.end(), std::back_inserter(types),
+                   [](llvm::Value* a) { return a->getType(); });
+    auto fn = f.getParent()->getOrInsertFunction(
+        name, llvm::FunctionType::get(builder.getVoidTy(), types, false));
+    builder.CreateCall(fn, args);
+  }
+  // the successor is set by the caller.
+  builder.CreateBr(loop.exit);
+  return bb;
+}
+
+void SampleLoopSplitter::split() {
+  std::vector<llvm::BasicBlock*> loops;
+  auto* pred = loop.preheader;
+  auto append = [&](llvm::BasicBlock* bb) {
+    if (!loops.empty()) {
+      auto* br = llvm::cast<llvm::BranchInst>(loops.back()->getTerminator());
+      br->setSuccessor(br->isConditional() ? 1 : 0, bb);
+    }
+    loops.push_back(bb);
+    pred = bb;
+  };
+  for (auto r : {Region::Pre, Region::Mid, Region::Post}) {
+    const bool exists = std::any_of(body.begin(), body.end(), [&](llvm::Instruction* i) {
+      return regions.at(i) == r && scans.count(i) == 0;
+    });
+    if (exists) { append(createLoop(r, pred)); }
+    if (r == Region::Pre && !scans.empty()) { append(createScan(pred)); }
+  }
+  loop.preheader->getTerminator()->replaceUsesOfWith(loop.body, loops.front());
+  loop.body->dropAllReferences();
+  loop.body->eraseFromParent();
+}
+
+}  // namespace mimium
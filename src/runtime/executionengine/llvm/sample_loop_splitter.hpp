@@ -0,0 +1,104 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+
+namespace mimium {
+
+// vector width and interleave count of the stateless loops. zero leaves them to the cost model.
+struct VectorizeHints {
+  unsigned width = 0;
+  unsigned interleave = 0;
+};
+
+// Splits the frame loop of `dsp.block` into a loop of stateful instructions(calls of stateful
+// builtins, self and other memory accesses) and loops of stateless instructions before and after
+// it. Values crossing the loops are passed through per-frame buffers, and the stateless loops are
+// marked to be vectorized across samples. The block function must be called with frames less
+// than or equal to max_dspblock.
+// First and second order linear recurrences on self(`u + b1*self`, optionally `+ b2*mem(self)`)
+// with coefficients constant in the block are taken out of the stateful loop and evaluated over
+// the block by mimium_recurrence1/2 between the loop before it and the stateful loop.
+class SampleLoopSplitter {
+ public:
+  // returns true if the function is modified.
+  static bool run(llvm::Function& f, VectorizeHints hints = {});
+
+ private:
+  enum class Region { Pre, Mid, Post };
+  struct FrameLoop {
+    llvm::BasicBlock* preheader;
+    llvm::BasicBlock* body;
+    llvm::BasicBlock* exit;
+    llvm::PHINode* index;
+    llvm::Instruction* next;
+    llvm::Instruction* cond;
+  };
+  struct Recurrence {
+    llvm::StoreInst* store;
+    llvm::Instruction* output;
+    llvm::Instruction* y1;  // load of self, or phi when the load is hoisted.
+    llvm::CallInst* y2;     // mem(self), nullptr for the first order.
+    // instructions between the states and the output.
+    std::vector<llvm::Instruction*> terms;
+  };
+  // a recurrence replaced by a freeze of its input in the loop body.
+  struct Scan {
+    llvm::Value* b1;
+    llvm::Value* b2;  // nullptr for the first order.
+    llvm::Value* state1;
+    llvm::Value* state2;
+  };
+  explicit SampleLoopSplitter(llvm::Function& f, FrameLoop loop, VectorizeHints hints)
+      : f(f), loop(loop), hints(hints) {}
+  static std::optional<FrameLoop> findFrameLoop(llvm::Function& f);
+  static void enableVectorize(llvm::BranchInst* br, VectorizeHints hints);
+
+  bool collectBody();
+  void classify();
+  void hoistInvariants();
+  bool replaceRecurrences();
+  [[nodiscard]] std::optional<Recurrence> matchRecurrence(llvm::StoreInst* store) const;
+  void replaceRecurrence(Recurrence& rec);
+  [[nodiscard]] bool isLinearIn(llvm::Value* v, const std::vector<llvm::Value*>& states,
+                                std::vector<llvm::Instruction*>& terms) const;
+  static llvm::Value* evalLinear(llvm::IRBuilderBase& builder, llvm::Value* v,
+                                 const std::unordered_map<llvm::Value*, llvm::Value*>& states,
+                                 const std::unordered_set<llvm::Instruction*>& terms,
+                                 bool keepinput);
+  [[nodiscard]] bool isStateful(llvm::Instruction& inst) const;
+  [[nodiscard]] bool isRematerializable(llvm::Instruction* inst) const;
+  [[nodiscard]] llvm::Instruction* getBodyInst(llvm::Value* v) const;
+  static llvm::Value* getRootPointer(llvm::Value* ptr);
+  [[nodiscard]] bool isUsedInOtherRegion(llvm::Instruction* inst, Region r) const;
+  [[nodiscard]] bool needsBuffer(llvm::Instruction* inst) const;
+  void split();
+  llvm::BasicBlock* createLoop(Region r, llvm::BasicBlock* pred);
+  llvm::BasicBlock* createScan(llvm::BasicBlock* pred);
+  llvm::Value* getValueFor(llvm::Instruction* inst, llvm::IRBuilderBase& builder,
+                           llvm::Value* index, llvm::ValueToValueMapTy& vmap);
+  llvm::Value* getBuffer(llvm::Instruction* inst);
+
+  llvm::Function& f;
+  FrameLoop loop;
+  VectorizeHints hints;
+  std::vector<llvm::Instruction*> body;
+  bool closure_readonly = false;
+  std::unordered_map<llvm::Instruction*, Region> regions;
+  // instructions depending on stateful instructions.
+  std::unordered_set<llvm::Instruction*> after_state;
+  std::unordered_map<llvm::Instruction*, llvm::Value*> buffers;
+  // keyed by the freeze instructions, which are classified as stateful so that their users come
+  // after the scan.
+  std::unordered_map<llvm::Instruction*, Scan> scans;
+};
+
+}  // namespace mimium
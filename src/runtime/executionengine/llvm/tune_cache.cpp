@@ -0,0 +1,80 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "tune_cache.hpp"
+#include <fstream>
+#include <sstream>
+#include "basic/helper_functions.hpp"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+#include "utils/include_filesystem.hpp"
+
+namespace mimium {
+
+namespace {
+constexpr std::string_view header = "mimium-autotune 1";
+}  // namespace
+
+TuneCache TuneCache::load(std::string const& path) {
+  TuneCache res;
+  std::ifstream fin(path);
+  if (!fin) { return res; }
+  std::string line;
+  if (!std::getline(fin, line) || line != header) {
+    Logger::debug_log("invalid autotune cache " + path + ", ignored", Logger::WARNING);
+    return res;
+  }
+  while (std::getline(fin, line)) {
+    std::istringstream ss(line);
+    std::string hash;
+    std::string cpu;
+    TuneConfig config;
+    if (!(ss >> hash >> cpu >> config.inline_level >> config.vectorize.width >>
+          config.vectorize.interleave >> config.block_size)) {
+      Logger::debug_log("invalid entry in autotune cache " + path + ", ignored", Logger::WARNING);
+      continue;
+    }
+    res.entries.emplace(hash + " " + cpu, config);
+  }
+  return res;
+}
+
+void TuneCache::save(std::string const& path) const {
+  const auto dir = fs::path(path).parent_path();
+  std::error_code ec;
+  if (!dir.empty()) { fs::create_directories(dir, ec); }
+  std::ofstream fout(path);
+  if (!fout) { throw std::runtime_error("failed to write autotune cache " + path); }
+  fout << header << "\n";
+  for (auto&& [key, config] : entries) {
+    fout << key << " " << config.inline_level << " " << config.vectorize.width << " "
+         << config.vectorize.interleave << " " << config.block_size << "\n";
+  }
+}
+
+// the bitcode is hashed before the module is optimized or instrumented.
+std::string TuneCache::getKey(llvm::Module const& m) {
+  llvm::SmallVector<char, 0> bitcode;
+  llvm::raw_svector_ostream os(bitcode);
+  llvm::WriteBitcodeToFile(m, os);
+  std::string res;
+  llvm::raw_string_ostream key(res);
+  key << llvm::format_hex_no_prefix(llvm::xxHash64(llvm::StringRef(bitcode.data(), bitcode.size())),
+                                    16)
+      << " " << llvm::sys::getHostCPUName();
+  return key.str();
+}
+
+std::optional<TuneConfig> TuneCache::find(std::string const& key) const {
+  auto iter = entries.find(key);
+  if (iter == entries.end()) { return std::nullopt; }
+  return iter->second;
+}
+
+}  // namespace mimium
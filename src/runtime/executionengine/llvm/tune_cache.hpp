@@ -0,0 +1,47 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <map>
+#include <optional>
+#include <string>
+#include "runtime/runtime_defs.hpp"
+#include "sample_loop_splitter.hpp"
+
+namespace llvm {
+class Module;
+}  // namespace llvm
+
+namespace mimium {
+
+// Choices of code generation for dsp which depend on the machine.
+struct TuneConfig {
+  // optimization level given to the inliner.
+  unsigned inline_level = 2;
+  VectorizeHints vectorize;
+  // frames per call of dsp.block.
+  int block_size = max_dspblock;
+  bool operator==(TuneConfig const& other) const {
+    return inline_level == other.inline_level && vectorize.width == other.vectorize.width &&
+           vectorize.interleave == other.vectorize.interleave && block_size == other.block_size;
+  }
+};
+
+// Configurations chosen by AutoTuner, keyed by the hash of the patch and the name of the host cpu.
+// Saved as a text file with a line per entry.
+class TuneCache {
+ public:
+  // returns an empty cache if the file does not exist.
+  static TuneCache load(std::string const& path);
+  // creates the parent directory if needed.
+  void save(std::string const& path) const;
+  static std::string getKey(llvm::Module const& m);
+  [[nodiscard]] std::optional<TuneConfig> find(std::string const& key) const;
+  void insert(std::string const& key, TuneConfig const& config) { entries[key] = config; }
+
+ private:
+  std::map<std::string, TuneConfig> entries;
+};
+
+}  // namespace mimium
@@ -1,19 +1,43 @@
 #include "runtime.hpp"
+#include <algorithm>
+#include <cstring>
+#include "compiler/builtin/context.hpp"
 #include "runtime/backend/audiodriver.hpp"
 #include "runtime/executionengine/executionengine.hpp"
 
 namespace mimium {
 Runtime::Runtime(std::unique_ptr<AudioDriver> a, std::unique_ptr<ExecutionEngine> e)
-    : audiodriver(std::move(a)), executionengine(std::move(e)) {}
+    : audiodriver(std::move(a)),
+      executionengine(std::move(e)),
+      builtin_context(std::make_unique<builtin::Context>()) {
+  builtin_context->setRealtime(audiodriver->isRealtime());
+}
+
+Runtime::~Runtime() {
+  // worker threads of builtins are joined before the memory they read is released.
+  builtin_context.reset();
+  for (auto&& [address, size] : malloc_container) { free(address); }
+}
 
 void Runtime::runMainFun() { this->hasdsp = executionengine->runMainFunction(this); }
 
-void Runtime::start() {
+void Runtime::prepare() {
+  if (prepared) { return; }
+  prepared = true;
   executionengine->preStart();
+  if (hasdsp || audiodriver->getScheduler().hasTask()) {
+    auto params = audiodriver->getDefaultAudioParameter(std::nullopt, std::nullopt);
+    builtin_context->setSampleRate(params->samplerate);
+    audiodriver->setup(std::move(params));
+    if (hasdsp && uses_builtin_context) { prepareDsp(); }
+  }
+}
 
+void Runtime::start() {
+  prepare();
   auto& sch = audiodriver->getScheduler();
   if (hasdsp || sch.hasTask()) {
-    audiodriver->setup(audiodriver->getDefaultAudioParameter(std::nullopt, std::nullopt));
+    builtin_context->setRunning(true);
     audiodriver->start();
     {
       auto& waitc = sch.getWaitController();
@@ -21,37 +45,102 @@ void Runtime::start() {
       // aynchronously wait until scheduler stops
       waitc.cv.wait(uniq_lk, [&]() { return waitc.isready; });
     }
+    builtin_context->setRunning(false);
+    if (builtin_context->getLateCount() > 0) {
+      Logger::debug_log(std::to_string(builtin_context->getLateCount()) +
+                            " states of builtins were allocated on the audio thread, as they "
+                            "were not called at the first sample",
+                        Logger::WARNING);
+    }
+  }
+  if (builtin_context->getRejectedWrites() > 0) {
+    Logger::debug_log(std::to_string(builtin_context->getRejectedWrites()) +
+                          " writes to read-only arrays were ignored",
+                      Logger::WARNING);
+  }
+  executionengine->postStop();
+}
+
+// evaluates dsp once so that builtins allocate their states here instead of on the audio thread.
+// the heap(memory objects, closures and global variables) and the arrays of the builtins are
+// restored afterwards except the pointers to the states, so that the first sample on the audio
+// thread sees what it would have seen without the preparation.
+void Runtime::prepareDsp() {
+  const auto* info = audiodriver->getDspFnInfos();
+  std::vector<std::vector<char>> backup;
+  for (auto const& [address, size] : malloc_container) {
+    const auto* begin = static_cast<const char*>(address);
+    backup.emplace_back(begin, std::next(begin, size));
+  }
+  std::vector<double> input(info->in_numchs, 0.0);
+  std::vector<double> output(std::max(info->out_numchs, 1), 0.0);
+  builtin_context->beginPrepare();
+  info->fn(output.data(), input.data(), info->cls_address, info->memobj_address);
+  auto states = builtin_context->endPrepare();
+  auto saved = backup.cbegin();
+  for (auto const& [address, size] : malloc_container) {
+    // allocations made while preparing are kept.
+    if (saved == backup.cend()) { break; }
+    std::memcpy(address, saved->data(), saved->size());
+    ++saved;
   }
+  for (auto [slot, state] : states) { *slot = state; }
 }
 
 AudioDriver& Runtime::getAudioDriver() { return *audiodriver; }
+builtin::Context& Runtime::useBuiltinContext() {
+  uses_builtin_context = true;
+  return *builtin_context;
+}
+bool Runtime::isPreparing() const { return builtin_context->isPreparing(); }
 
 void Runtime::pushMalloc(void* address, size_t size) {
   malloc_container.emplace_back(address, size);
+  // arrays in the heap are bounded by the allocation.
+  builtin_context->registerArray(static_cast<const double*>(address), size / sizeof(double), true);
+}
+size_t Runtime::getHeapBytes() const {
+  size_t res = 0;
+  for (const auto& [address, size] : malloc_container) { res += size; }
+  return res;
 }
 }  // namespace mimium
 
 extern "C" {
 void setDspParams(void* runtimeptr, void* dspfn, void* clsaddress, void* memobjaddress,
-                  int in_numchs, int out_numchs) {
+                  int in_numchs, int out_numchs, int latency, void* blockfn) {
   auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
   auto& audiodriver = runtime->getAudioDriver();
-  auto p = std::make_unique<mimium::DspFnInfos>(
-      mimium::DspFnInfos{reinterpret_cast<mimium::DspFnPtr>(dspfn), clsaddress, memobjaddress,
-                         in_numchs, out_numchs});  // NOLINT
+  auto p = std::make_unique<mimium::DspFnInfos>(mimium::DspFnInfos{
+      reinterpret_cast<mimium::DspFnPtr>(dspfn), clsaddress, memobjaddress, in_numchs, out_numchs,
+      latency, reinterpret_cast<mimium::DspBlockFnPtr>(blockfn)});  // NOLINT
   audiodriver.setDspFnInfos(std::move(p));
 }
 
-NO_SANITIZE void addTask(void* runtimeptr, double time, void* addresstofn, double arg) {
+NO_SANITIZE void addTask(void* runtimeptr, double time, void* addresstofn, void* payload,
+                         int64_t size, void* addresstocls) {
   auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  if (runtime->isPreparing()) { return; }
   mimium::Scheduler& sch = runtime->getAudioDriver().getScheduler();
-  sch.addTask(time, addresstofn, arg, nullptr);
+  sch.addTask(time, addresstofn, payload, static_cast<size_t>(size), addresstocls);
 }
-NO_SANITIZE void addTask_cls(void* runtimeptr, double time, void* addresstofn, double arg,
-                             void* addresstocls) {
+// called by `eventseq` builtin. the arrays in the heap of the runtime live as long as the
+// scheduler, while the others(e.g. on the stack of the calling function) are copied.
+NO_SANITIZE void mimium_addeventstream(void* runtimeptr, void* addresstofn, double* times,
+                                       double* values, double size) {
   auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  if (runtime->isPreparing()) { return; }
   mimium::Scheduler& sch = runtime->getAudioDriver().getScheduler();
-  sch.addTask(time, addresstofn, arg, addresstocls);
+  auto const& ctx = runtime->getBuiltinContext();
+  auto count = static_cast<size_t>(std::max(0.0, size));
+  const auto times_extent = ctx.findArray(times);
+  const auto values_extent = ctx.findArray(values);
+  const bool owned = times_extent && values_extent;
+  if (owned) { count = std::min({count, times_extent->size, values_extent->size}); }
+  if (!sch.addEventStream(addresstofn, times, values, count, !owned)) {
+    mimium::Logger::debug_log("eventseq was ignored as the times are not sorted",
+                              mimium::Logger::WARNING);
+  }
 }
 double mimium_getnow(void* runtimeptr) {
   auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
@@ -65,4 +154,9 @@ void* mimium_malloc(void* runtimeptr, size_t size) {
   runtime->pushMalloc(address, size);
   return address;
 }
-}
\ No newline at end of file
+
+void* mimium_getbuiltincontext(void* runtimeptr) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  return &runtime->useBuiltinContext();
+}
+}
@@ -12,22 +12,37 @@
 #include "runtime/scheduler.hpp"
 
 namespace mimium {
+namespace builtin {
+class Context;
+}
 class AudioDriver;
 class ExecutionEngine;
 class MIMIUM_DLL_PUBLIC Runtime {
  public:
   explicit Runtime(std::unique_ptr<AudioDriver> a, std::unique_ptr<ExecutionEngine> e);
 
-  virtual ~Runtime() {
-    for (auto&& [address, size] : malloc_container) { free(address); }
-  };
+  virtual ~Runtime();
 
   virtual void runMainFun();
+  // sets up the audio driver and evaluates dsp once so that builtins allocate their states(see
+  // prepareDsp()). called by start() if it has not been called before.
+  void prepare();
   virtual void start();
   AudioDriver& getAudioDriver();
+  // states of builtins.
+  builtin::Context& getBuiltinContext() { return *builtin_context; }
+  [[nodiscard]] const builtin::Context& getBuiltinContext() const { return *builtin_context; }
+  // requested by generated code calling builtins which take the context.
+  builtin::Context& useBuiltinContext();
+  [[nodiscard]] bool usesBuiltinContext() const { return uses_builtin_context; }
+  // true while dsp is evaluated before the audio thread starts, see prepareDsp().
+  [[nodiscard]] bool isPreparing() const;
   [[nodiscard]] bool hasDsp() const { return hasdsp; }
   [[nodiscard]] bool hasDspCls() const { return hasdspcls; }
   void pushMalloc(void* address, size_t size);
+  // number and total size of the allocations by mimium_malloc.
+  [[nodiscard]] size_t getHeapCount() const { return malloc_container.size(); }
+  [[nodiscard]] size_t getHeapBytes() const;
 
  protected:
   std::unique_ptr<AudioDriver> audiodriver;
@@ -35,16 +50,24 @@ class MIMIUM_DLL_PUBLIC Runtime {
   bool hasdsp = false;
   bool hasdspcls = false;
   std::list<std::pair<void*, size_t>> malloc_container{};
+  std::unique_ptr<builtin::Context> builtin_context;
+  bool uses_builtin_context = false;
+  bool prepared = false;
+  void prepareDsp();
 };
 
 extern "C" {
 MIMIUM_DLL_PUBLIC void setDspParams(void* runtimeptr, void* dspfn, void* clsaddress,
-                                    void* memobjaddress, int in_numchs, int out_numchs);
-MIMIUM_DLL_PUBLIC void addTask(void* runtimeptr, double time, void* addresstofn, double arg);
-MIMIUM_DLL_PUBLIC void addTask_cls(void* runtimeptr, double time, void* addresstofn, double arg,
-                                   void* addresstocls);
+                                    void* memobjaddress, int in_numchs, int out_numchs,
+                                    int latency, void* blockfn);
+// addresstofn is a trampoline taking the copy of the payload and the address to closure.
+MIMIUM_DLL_PUBLIC void addTask(void* runtimeptr, double time, void* addresstofn, void* payload,
+                               int64_t size, void* addresstocls);
 MIMIUM_DLL_PUBLIC double mimium_getnow(void* runtimeptr);
+MIMIUM_DLL_PUBLIC void mimium_addeventstream(void* runtimeptr, void* addresstofn, double* times,
+                                             double* values, double size);
 MIMIUM_DLL_PUBLIC void* mimium_malloc(void* runtimeptr, size_t size);
+MIMIUM_DLL_PUBLIC void* mimium_getbuiltincontext(void* runtimeptr);
 }
 
 }  // namespace mimium
\ No newline at end of file
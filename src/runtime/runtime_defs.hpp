@@ -3,10 +3,17 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #pragma once
+#include <cstddef>
 namespace mimium {
 
 // outputresult,input, clsaddress,memobjaddress
 using DspFnPtr = void (*)(double*, const double*, void*, void*);
+// same as DspFnPtr with number of frames, processes consecutive frames at once.
+using DspBlockFnPtr = void (*)(double*, const double*, void*, void*, int);
+// maximum number of frames for a call of the block function.
+inline constexpr int max_dspblock = 64;
+// maximum size in bytes of arguments of a function call with `@`, which are copied into the task.
+inline constexpr size_t task_payload_size = 32;
 
 // Information set by definition of dsp function.
 // number of in&out channels are determined by type of dsp function.
@@ -17,6 +24,12 @@ struct DspFnInfos {
   void* memobj_address = nullptr;
   int in_numchs = 0;
   int out_numchs = 0;
+  // samples of delay added by lookahead. scheduled events are delayed by the same amount.
+  int latency = 0;
+  // null if the dsp function depends on time(e.g. uses `now` or `@`).
+  DspBlockFnPtr block_fn = nullptr;
+  // frames passed to block_fn at once, less than or equal to max_dspblock.
+  int block_size = max_dspblock;
 };
 
 // Information of AudioDriver(e.g. Hardware Device).
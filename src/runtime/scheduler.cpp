@@ -3,44 +3,106 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "scheduler.hpp"
+#include <algorithm>
+#include <cstring>
 
 namespace mimium {
 
+namespace {
+// events of streams call plain functions taking the value.
+void callWithValue(const void* payload, void* addresstofn) {
+  double value = 0.0;
+  std::memcpy(&value, payload, sizeof(double));
+  reinterpret_cast<void (*)(double)>(addresstofn)(value);  // NOLINT
+}
+std::vector<std::pair<int64_t, TaskType>> reserveTasks(size_t size) {
+  std::vector<std::pair<int64_t, TaskType>> res;
+  res.reserve(size);
+  return res;
+}
+}  // namespace
+
+Scheduler::Scheduler() : wc(), tasks(Greater{}, reserveTasks(reserved_tasks)) {}
+
 bool Scheduler::Greater::operator()(const key_type& l, const key_type& r) const {
   return l.first > r.first;
 }
 
 // return value: shouldstop
 bool Scheduler::incrementTime() {
-  bool hastask = !tasks.empty();
-  bool shouldplay = hasdsp || hastask;
+  bool shouldplay = hasdsp || hasTask();
   if (!shouldplay) { return true; }
 
   time += 1;
-  if (hastask && time > tasks.top().first) { executeTask(tasks.top().second); }
+  if (!streams.empty() && time >= next_refill) { refillStreams(); }
+  if (!tasks.empty() && time > tasks.top().first) { executeTask(tasks.top().second); }
   return false;
 }
-void Scheduler::addTask(double time, void* addresstofn, double arg, void* addresstocls) {
-  tasks.emplace(static_cast<int64_t>(time), TaskType{addresstofn, arg, addresstocls});
+bool Scheduler::advanceBlock(int64_t n) {
+  if (!hasdsp) { return false; }
+  if (!streams.empty() && time + n >= next_refill) { refillStreams(); }
+  if (!tasks.empty() && tasks.top().first < time + n) { return false; }
+  time += n;
+  return true;
+}
+void Scheduler::addTask(double time, void* addresstofn, const void* payload, size_t size,
+                        void* addresstocls) {
+  assert(size <= task_payload_size);
+  TaskType task{addresstofn, addresstocls, {}};
+  std::memcpy(task.payload.data(), payload, size);
+  tasks.emplace(static_cast<int64_t>(time), task);
 }
 
-void Scheduler::executeTask(const TaskType& task) {
-  // todo
-  const auto& [addresstofn, arg, addresstocls] = task;
+bool Scheduler::addEventStream(void* addresstofn, const double* times, const double* values,
+                               size_t size, bool copy) {
+  if (!std::is_sorted(times, std::next(times, size))) { return false; }
+  if (size == 0) { return true; }
+  auto& stream = streams.emplace_back(EventStream{addresstofn, times, values, size});
+  if (copy) {
+    // the data of a moved vector stays at the same address.
+    stream.copied.assign(times, std::next(times, size));
+    stream.copied.insert(stream.copied.end(), values, std::next(values, size));
+    stream.times = stream.copied.data();
+    stream.values = std::next(stream.copied.data(), size);
+  }
+  refillStream(stream);
+  if (stream.cursor == size) { streams.pop_back(); }
+  return true;
+}
 
-  if (addresstocls == nullptr) {
-    auto fn = reinterpret_cast<void (*)(double)>(addresstofn);//NOLINT
-    fn(arg);
-  } else {
-    auto fn = reinterpret_cast<void (*)(double, void*)>(addresstofn);//NOLINT
-    fn(arg, addresstocls);
+void Scheduler::refillStream(EventStream& stream) {
+  const int64_t limit = time + stream_window;
+  while (stream.cursor < stream.size) {
+    const auto t = static_cast<int64_t>(stream.times[stream.cursor]);
+    if (t >= limit) { break; }
+    TaskType task{reinterpret_cast<void*>(&callWithValue), stream.addresstofn, {}};  // NOLINT
+    std::memcpy(task.payload.data(), &stream.values[stream.cursor], sizeof(double));
+    tasks.emplace(t, task);
+    stream.cursor++;
   }
+}
+
+void Scheduler::refillStreams() {
+  for (auto& stream : streams) { refillStream(stream); }
+  streams.erase(std::remove_if(streams.begin(), streams.end(),
+                               [](EventStream const& s) { return s.cursor == s.size; }),
+                streams.end());
+  // refill at the half of the window so that queued events never run out.
+  next_refill = time + stream_window / 2;
+}
+
+void Scheduler::executeTask(const TaskType& task) {
+  // the task is popped before the call as the function may add tasks.
+  const TaskType current = task;
   tasks.pop();
-  if (tasks.empty() && !hasdsp) {
+  auto fn = reinterpret_cast<void (*)(const void*, void*)>(current.addresstofn);  // NOLINT
+  fn(current.payload.data(), current.addresstocls);
+  if (tasks.empty() && streams.empty() && !hasdsp) {
     stop();
   } else {
-    // recursive call until all tasks have been done!
-    if (time >= tasks.top().first) { this->executeTask(tasks.top().second); }
+    // recursive call until all tasks due in this sample have been done. tasks are due in the
+    // sample after their time, as in incrementTime.
+    if (!tasks.empty() && time > tasks.top().first) { this->executeTask(tasks.top().second); }
   }
 }
 
@@ -4,40 +4,69 @@
 
 #pragma once
 
+#include <array>
 #include <queue>
 #include <utility>
 #include "export.hpp"
 #include "basic/helper_functions.hpp"
+#include "runtime/runtime_defs.hpp"
 // #include "sndfile.h"
 
 namespace mimium {
 struct TaskType {
+  // void(const void* payload, void* addresstocls), which unpacks the payload into arguments.
   void* addresstofn;
-  // int64_t tasktypeid;
-  double arg;
   void* addresstocls;
+  // arguments copied inline so that scheduling a call does not allocate.
+  alignas(double) std::array<char, task_payload_size> payload;
+};
+
+// Sequence of events held in arrays. Events are moved into the task queue lazily, only within a
+// window from the current time.
+struct EventStream {
+  void* addresstofn;
+  const double* times;  // sorted
+  const double* values;
+  size_t size;
+  size_t cursor = 0;
+  // copy of the times and the values when the arrays may be released before the events end.
+  std::vector<double> copied{};
 };
 
 class MIMIUM_DLL_PUBLIC Scheduler {  // scheduler interface
  public:
-  explicit Scheduler() : wc() {}
+  explicit Scheduler();
 
   virtual ~Scheduler() = default;
   virtual void start(bool hasdsp);
   virtual void stop();
 
-  bool hasTask() { return !tasks.empty(); }
+  bool hasTask() { return !tasks.empty() || !streams.empty(); }
 
   // tick the time and return if scheduler should be stopped
   bool incrementTime();
 
-  // time,address to fun, arg(double), addresstoclosure,
-  void addTask(double time, void* addresstofn, double arg, void* addresstocls);
+  // time, address to trampoline, arguments and its size, addresstoclosure.
+  void addTask(double time, void* addresstofn, const void* payload, size_t size,
+               void* addresstocls);
+  // events after the window are not queued until the time approaches, so the arrays are read
+  // until the last event is queued unless they are copied. returns false without adding the
+  // stream if times is not sorted.
+  bool addEventStream(void* addresstofn, const double* times, const double* values, size_t size,
+                      bool copy = false);
+  static constexpr int64_t stream_window = 4096;
+  // the queue is reserved for this number of tasks.
+  static constexpr size_t reserved_tasks = 1024;
 
   // if dsp function exists
   bool hasdsp = false;
   [[nodiscard]] auto getTime() const { return time; }
   auto& getWaitController() { return wc; }
+  // delays the clock so that events and `now` are aligned with the output delayed by lookahead.
+  // must be called before start.
+  void setLatency(int64_t latency) { time = -latency; }
+  // advance time by n samples at once if no task is executed in the period.
+  bool advanceBlock(int64_t n);
 
  protected:
   using key_type = std::pair<int64_t, TaskType>;
@@ -48,6 +77,10 @@ class MIMIUM_DLL_PUBLIC Scheduler {  // scheduler interface
   using queue_type = std::priority_queue<key_type, std::vector<key_type>, Greater>;
   int64_t time = 0;
   queue_type tasks;
+  std::vector<EventStream> streams;
+  int64_t next_refill = 0;
+  void refillStream(EventStream& stream);
+  void refillStreams();
   virtual void executeTask(const TaskType& task);
 };
 
@@ -1,6 +1,7 @@
 #include "basic/ast_to_string.hpp"
 #include "basic/mir.hpp"
 #include "compiler/ast_loader.hpp"
+#include "compiler/lookahead_resolver.hpp"
 #include "compiler/mirgenerator.hpp"
 #include "compiler/scanner.hpp"
 #include "compiler/symbolrenamer.hpp"
@@ -41,4 +42,21 @@ TEST(mirgen, basic) {  // NOLINT
 )";
   EXPECT_EQ(mir::toString(mir), target);
 }
+TEST(mirgen, lookahead) {  // NOLINT
+  PREP(test_lookahead)
+  auto mir = mirgenerator.generate(*newast);
+  LookaheadResolver resolver;
+  EXPECT_EQ(resolver.process(mir), 64);
+  // each call reads a delay of latency - n
+  auto str = mir::toString(mir);
+  EXPECT_NE(str.find(".lookahead = 64.000000"), std::string::npos);
+  EXPECT_NE(str.find(".lookahead = 48.000000"), std::string::npos);
+  EXPECT_NE(str.find(".lookahead = 0.000000"), std::string::npos);
+}
+TEST(mirgen, lookahead_nonconstant) {  // NOLINT
+  PREP(test_lookahead_invalid)
+  auto mir = mirgenerator.generate(*newast);
+  LookaheadResolver resolver;
+  EXPECT_THROW(resolver.process(mir), std::runtime_error);
+}
 }  // namespace mimium
\ No newline at end of file
@@ -52,3 +52,49 @@ TEST(cli, optionstage) {  // NOLINT
   EXPECT_EQ(appoption.output_path, std::nullopt);
   EXPECT_FALSE(appoption.is_verbose);
 }
+
+TEST(cli, optionprofile) {  // NOLINT
+  std::vector<const char*> args = {"/usr/local/mimium", "test_tuple.mmm", "--profile-generate",
+                                   "tuple.prof", "--profile-use", "old.prof"};
+  auto [appoption, climode] = mmmcli::CliApp::OptionParser()(args.size(), args.data());
+  EXPECT_EQ(climode, mmmcli::CliAppMode::Run);
+  EXPECT_EQ(appoption.input.value().filepath, "test_tuple.mmm");
+  EXPECT_EQ(appoption.runtime_option.profile_generate.value(), "tuple.prof");
+  EXPECT_EQ(appoption.runtime_option.profile_use.value(), "old.prof");
+}
+TEST(cli, optionhotcode) {  // NOLINT
+  std::vector<const char*> args = {"/usr/local/mimium", "--huge-pages", "--lock-code",
+                                   "test_tuple.mmm"};
+  auto [appoption, climode] = mmmcli::CliApp::OptionParser()(args.size(), args.data());
+  EXPECT_EQ(climode, mmmcli::CliAppMode::Run);
+  EXPECT_EQ(appoption.input.value().filepath, "test_tuple.mmm");
+  EXPECT_TRUE(appoption.runtime_option.huge_pages);
+  EXPECT_TRUE(appoption.runtime_option.lock_code);
+}
+TEST(cli, optionautotune) {  // NOLINT
+  std::vector<const char*> args = {"/usr/local/mimium", "--autotune", "--tune-cache",
+                                   "tune.txt", "test_tuple.mmm"};
+  auto [appoption, climode] = mmmcli::CliApp::OptionParser()(args.size(), args.data());
+  EXPECT_EQ(climode, mmmcli::CliAppMode::Run);
+  EXPECT_EQ(appoption.input.value().filepath, "test_tuple.mmm");
+  EXPECT_TRUE(appoption.runtime_option.autotune);
+  EXPECT_EQ(appoption.runtime_option.tune_cache.value(), "tune.txt");
+}
+TEST(cli, optionbudget) {  // NOLINT
+  std::vector<const char*> args = {"/usr/local/mimium", "--cpu-budget", "25", "--budget-samplerate",
+                                   "96000", "--budget-error", "test_tuple.mmm"};
+  auto [appoption, climode] = mmmcli::CliApp::OptionParser()(args.size(), args.data());
+  EXPECT_EQ(climode, mmmcli::CliAppMode::Run);
+  EXPECT_DOUBLE_EQ(appoption.runtime_option.cpu_budget.value(), 25.0);
+  EXPECT_DOUBLE_EQ(appoption.runtime_option.budget_samplerate, 96000.0);
+  EXPECT_TRUE(appoption.runtime_option.budget_error);
+  std::vector<const char*> invalid = {"/usr/local/mimium", "--cpu-budget", "half"};
+  EXPECT_THROW(mmmcli::CliApp::OptionParser()(invalid.size(), invalid.data()), mimium::CliAppError);
+}
+TEST(cli, optionmemreport) {  // NOLINT
+  std::vector<const char*> args = {"/usr/local/mimium", "--mem-report", "test_tuple.mmm"};
+  auto [appoption, climode] = mmmcli::CliApp::OptionParser()(args.size(), args.data());
+  EXPECT_EQ(climode, mmmcli::CliAppMode::Run);
+  EXPECT_EQ(appoption.input.value().filepath, "test_tuple.mmm");
+  EXPECT_TRUE(appoption.mem_report);
+}
@@ -0,0 +1,478 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <thread>
+#include "compiler/builtin/arrayops.hpp"
+#include "compiler/builtin/context.hpp"
+#include "compiler/builtin/convolver.hpp"
+#include "compiler/builtin/datafile.hpp"
+#include "compiler/builtin/fft.hpp"
+#include "compiler/builtin/oversampler.hpp"
+#include "compiler/builtin/recurrence.hpp"
+#include "compiler/builtin/resampler.hpp"
+#include "compiler/builtin/sos.hpp"
+#include "compiler/builtin/stft.hpp"
+#include "compiler/builtin/wavetable.hpp"
+#include "compiler/ffi.hpp"
+#include "gtest/gtest.h"
+
+namespace mimium::builtin {
+
+std::vector<double> makeNoise(size_t size, unsigned int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::vector<double> res(size);
+  for (auto& v : res) { v = dist(gen); }
+  return res;
+}
+
+TEST(builtin_dsp, fft_matches_dft) {  // NOLINT
+  const size_t size = 64;
+  auto input = makeNoise(size, 1);
+  RealFFT fft(size);
+  std::vector<double> re(fft.getNumBins());
+  std::vector<double> im(fft.getNumBins());
+  fft.forward(input.data(), re.data(), im.data());
+  for (size_t k = 0; k < fft.getNumBins(); k++) {
+    double dft_re = 0;
+    double dft_im = 0;
+    for (size_t t = 0; t < size; t++) {
+      const double phase = -2 * M_PI * static_cast<double>(k * t) / size;
+      dft_re += input[t] * std::cos(phase);
+      dft_im += input[t] * std::sin(phase);
+    }
+    EXPECT_NEAR(re[k], dft_re, 1e-9);
+    EXPECT_NEAR(im[k], dft_im, 1e-9);
+  }
+  std::vector<double> output(size);
+  fft.inverse(re.data(), im.data(), output.data());
+  for (size_t t = 0; t < size; t++) { EXPECT_NEAR(output[t], input[t], 1e-12); }
+}
+
+TEST(builtin_dsp, fft_invalid_size) {  // NOLINT
+  EXPECT_THROW(RealFFT fft(48), std::runtime_error);
+}
+
+TEST(builtin_dsp, convolver_matches_direct_form) {  // NOLINT
+  // impulse responses which have head, head+partitioned, and head+partitioned+tail.
+  for (size_t irsize : {5, 100, 1000}) {
+    auto ir = makeNoise(irsize, 2);
+    auto input = makeNoise(4000, 3);
+    Convolver conv(std::make_shared<const ConvolverIR>(ir.data(), irsize, 16, 64), false);
+    for (size_t n = 0; n < input.size(); n++) {
+      double expect = 0;
+      for (size_t k = 0; k < irsize && k <= n; k++) { expect += ir[k] * input[n - k]; }
+      ASSERT_NEAR(conv.process(input[n]), expect, 1e-9) << "irsize " << irsize << ", at " << n;
+    }
+  }
+}
+
+TEST(builtin_dsp, convolver_worker) {  // NOLINT
+  const size_t irsize = 1000;
+  auto ir = makeNoise(irsize, 2);
+  auto input = makeNoise(2000, 3);
+  auto shared_ir = std::make_shared<const ConvolverIR>(ir.data(), irsize, 16, 64);
+  std::vector<double> expect(input.size());
+  {
+    Convolver conv(shared_ir, false);
+    for (size_t n = 0; n < input.size(); n++) { expect[n] = conv.process(input[n]); }
+  }
+  // the worker finishes a tail block while the caller sleeps.
+  Convolver conv(shared_ir);
+  for (size_t n = 0; n < input.size(); n++) {
+    if (n % 64 == 0) { std::this_thread::sleep_for(std::chrono::milliseconds(5)); }
+    ASSERT_NEAR(conv.process(input[n]), expect[n], 1e-9) << "at " << n;
+  }
+  ASSERT_EQ(conv.getMissedBlocks(), 0U);
+  // without waiting, the tail is muted instead of blocking the caller.
+  Convolver fast(shared_ir);
+  const auto begin = std::chrono::steady_clock::now();
+  for (auto v : input) { fast.process(v); }
+  ASSERT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(1));
+}
+
+TEST(builtin_dsp, context_cache_by_contents) {  // NOLINT
+  Context ctx;
+  auto a = makeNoise(100, 5);
+  auto b = a;
+  int made = 0;
+  auto make = [&]() { return std::make_unique<const int>(made++); };
+  auto from_a = ctx.getCached<int>("test", a.data(), a.size(), make);
+  // arrays at other addresses share the object if the contents are the same.
+  ASSERT_EQ(ctx.getCached<int>("test", b.data(), b.size(), make), from_a);
+  ASSERT_NE(ctx.getCached<int>("other", b.data(), b.size(), make), from_a);
+  b[10] += 1.0;
+  ASSERT_NE(ctx.getCached<int>("test", b.data(), b.size(), make), from_a);
+  ASSERT_NE(ctx.getCached<int>("test", a.data(), 50, make), from_a);
+  ASSERT_EQ(made, 4);
+  // objects without getBytes() are counted by their size.
+  ASSERT_EQ(ctx.getSharedCount(), 4U);
+  ASSERT_EQ(ctx.getSharedBytes(), 4 * sizeof(int));
+}
+
+TEST(builtin_dsp, context_prepare) {  // NOLINT
+  Context ctx;
+  std::array<void*, 2> slots{};
+  auto make = [&]() { return std::make_unique<int>(1); };
+  ctx.beginPrepare();
+  ASSERT_TRUE(ctx.isPreparing());
+  auto* state = ctx.getState<int>(&slots[0], make);
+  // the slot holds the state and it is not created again.
+  ASSERT_EQ(ctx.getState<int>(&slots[0], make), state);
+  auto prepared = ctx.endPrepare();
+  ASSERT_EQ(prepared.size(), 1U);
+  ASSERT_EQ(prepared[0].first, &slots[0]);
+  ASSERT_EQ(prepared[0].second, state);
+  ctx.setRunning(true);
+  ctx.getState<int>(&slots[1], make);
+  ASSERT_EQ(ctx.getLateCount(), 1U);
+  ASSERT_EQ(ctx.getStateCount(), 2U);
+  ASSERT_EQ(ctx.getStateBytes(), 2 * sizeof(int));
+}
+
+TEST(builtin_dsp, context_state_bytes) {  // NOLINT
+  // buffers of states are counted, while the impulse response is shared.
+  Context ctx;
+  const std::vector<double> ir(5000, 0.1);
+  std::array<void*, 2> slots{};
+  for (auto& slot : slots) {
+    ctx.getState<Convolver>(&slot, [&]() { return createConvolver(ctx, ir.data(), ir.size()); });
+  }
+  ASSERT_EQ(ctx.getSharedCount(), 1U);
+  ASSERT_GE(ctx.getSharedBytes(), ir.size() * sizeof(double));
+  // input and output of the tail blocks and the jobs.
+  const size_t tail = Convolver::default_tail_block * sizeof(double);
+  ASSERT_GE(ctx.getStateBytes(), 2 * (2 + 2 * Convolver::num_jobs) * tail);
+  double* array = ctx.allocateArray(10);
+  ASSERT_NE(array, nullptr);
+  ASSERT_EQ(ctx.getArrayCount(), 1U);
+  ASSERT_EQ(ctx.getArrayBytes(), 10 * sizeof(double));
+}
+
+TEST(builtin_dsp, stft_resynthesis) {  // NOLINT
+  const size_t fftsize = 256;
+  auto input = makeNoise(2000, 4);
+  for (auto window : {WindowType::Hann, WindowType::Hamming, WindowType::Blackman}) {
+    Stft stft(fftsize, fftsize / 4, window);
+    ASSERT_EQ(stft.getLatency(), fftsize);
+    for (size_t n = 0; n < input.size(); n++) {
+      auto res = stft.process(input[n], [](double* /*mag*/, double* /*phase*/, double nbins) {
+        ASSERT_EQ(nbins, fftsize / 2 + 1);
+      });
+      const double expect = n >= fftsize ? input[n - fftsize] : 0.0;
+      ASSERT_NEAR(res, expect, 1e-9);
+    }
+  }
+}
+
+TEST(builtin_dsp, stft_modifies_frame) {  // NOLINT
+  // zeroing the magnitudes of all bins silences the output.
+  const size_t fftsize = 64;
+  Stft stft(fftsize, fftsize / 4, WindowType::Hann);
+  for (auto in : makeNoise(1000, 5)) {
+    auto res = stft.process(in, [](double* mag, double* /*phase*/, double nbins) {
+      std::fill(mag, mag + static_cast<size_t>(nbins), 0.0);
+    });
+    ASSERT_EQ(res, 0.0);
+  }
+}
+
+TEST(builtin_dsp, resampler_interpolates_sine) {  // NOLINT
+  // a low frequency sine should be reconstructed at fractional positions
+  const double omega = 2.0 * M_PI * 0.01;
+  std::vector<double> input(1000);
+  for (size_t n = 0; n < input.size(); n++) { input[n] = std::sin(omega * n); }
+  for (auto q : {ResampleQuality::Fast, ResampleQuality::Medium, ResampleQuality::High,
+                 ResampleQuality::Best}) {
+    const auto& kernel = SincKernel::get(q);
+    const double tolerance = q == ResampleQuality::Fast ? 1e-2 : 2e-3;
+    for (double pos = 100.0; pos < 900.0; pos += 0.37) {
+      ASSERT_NEAR(kernel.read(input.data(), input.size(), pos), std::sin(omega * pos), tolerance);
+    }
+  }
+  auto up = resample(input.data(), input.size(), 1, 2.0, ResampleQuality::Best);
+  ASSERT_EQ(up.size(), getResampledSize(input.size(), 2.0));
+  for (size_t n = 200; n < 1800; n++) { ASSERT_NEAR(up[n], std::sin(omega * n * 0.5), 2e-3); }
+}
+
+TEST(builtin_dsp, resampler_suppresses_alias) {  // NOLINT
+  // downsampling by 4 must remove a tone above the new nyquist frequency
+  const double omega = 2.0 * M_PI * 0.2;
+  std::vector<double> input(4000);
+  for (size_t n = 0; n < input.size(); n++) { input[n] = std::sin(omega * n); }
+  auto down = resample(input.data(), input.size(), 1, 0.25, ResampleQuality::High);
+  for (size_t n = 100; n < 900; n++) { ASSERT_LT(std::abs(down[n]), 1e-2); }
+}
+
+TEST(builtin_dsp, wavetable_band_limited) {  // NOLINT
+  Context ctx;
+  auto osc = createOscillator(ctx, Waveform::Saw);
+  ASSERT_EQ(osc->table, createOscillator(ctx, Waveform::Saw)->table);
+  ASSERT_NE(osc->table, createOscillator(ctx, Waveform::Square)->table);
+  // shared across runtimes too.
+  Context other;
+  ASSERT_EQ(osc->table, createOscillator(other, Waveform::Saw)->table);
+  const auto& saw = *osc->table;
+  for (size_t level = 0; level < MipMappedTable::num_levels; level++) {
+    const double* table = saw.getTable(level);
+    const size_t harmonics = MipMappedTable::max_harmonics >> level;
+    for (size_t i = 0; i < MipMappedTable::table_size; i += 37) {
+      const double phase = 2.0 * M_PI * i / MipMappedTable::table_size;
+      double expect = 0.0;
+      for (size_t k = 1; k <= harmonics; k++) {
+        expect += (k % 2 == 1 ? 2.0 : -2.0) / (M_PI * k) * std::sin(phase * k);
+      }
+      ASSERT_NEAR(table[i], expect, 1e-9);
+    }
+  }
+  // highest harmonic of the selected level stays below nyquist frequency
+  for (double freq = 10.0; freq < 24000.0; freq *= 1.1) {
+    const double inc = freq / 48000.0;
+    const size_t level = MipMappedTable::getLevel(inc);
+    if (level < MipMappedTable::num_levels - 1) {
+      ASSERT_LT((MipMappedTable::max_harmonics >> level) * inc, 0.5);
+    }
+    if (level > 0) { ASSERT_GE((MipMappedTable::max_harmonics >> (level - 1)) * inc, 0.5); }
+  }
+}
+
+TEST(builtin_dsp, wavetable_from_array) {  // NOLINT
+  std::vector<double> cycle(100);
+  for (size_t i = 0; i < cycle.size(); i++) { cycle[i] = std::sin(2.0 * M_PI * i / 100.0); }
+  Context ctx;
+  auto osc = createOscillator(ctx, cycle.data(), cycle.size());
+  const auto& table = *osc->table;
+  for (double phase = 0.0; phase < 1.0; phase += 0.013) {
+    ASSERT_NEAR(table.read(phase, 0.01), std::sin(2.0 * M_PI * phase), 1e-3);
+  }
+  // shared by the contents, not by the address of the array.
+  auto copy = cycle;
+  ASSERT_EQ(createOscillator(ctx, copy.data(), copy.size())->table, osc->table);
+  cycle[0] = 1.0;
+  ASSERT_NE(createOscillator(ctx, cycle.data(), cycle.size())->table, osc->table);
+  for (int i = 0; i < 1000; i++) {
+    osc->process(-1000.0, 48000.0);
+    ASSERT_TRUE(osc->phase >= 0.0 && osc->phase < 1.0);
+  }
+}
+
+TEST(builtin_dsp, sos_matches_direct_form) {  // NOLINT
+  // two sections of lowpass and peaking filter
+  const std::vector<double> coeffs = {0.0675, 0.1349, 0.0675, -1.1430, 0.4128,
+                                      1.0324, -1.8271, 0.8155, -1.8271, 0.8479};
+  auto input = makeNoise(500, 5);
+  std::vector<double> expect = input;
+  for (size_t s = 0; s < 2; s++) {
+    const double* c = &coeffs[s * 5];
+    double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;  // NOLINT
+    for (auto& v : expect) {
+      const double y = c[0] * v + c[1] * x1 + c[2] * x2 - c[3] * y1 - c[4] * y2;
+      x2 = x1;
+      x1 = v;
+      y2 = y1;
+      y1 = y;
+      v = y;
+    }
+  }
+  std::vector<double> state(sos::state_size, 0.0);
+  SosFilter multi(3, 48000.0);
+  for (size_t n = 0; n < input.size(); n++) {
+    ASSERT_NEAR(sos::process(input[n], coeffs.data(), 2, state.data(), 48000.0), expect[n],
+                1e-12);
+    const double frame[3] = {input[n], 0.0, -input[n]};
+    const double* out = multi.process(frame, coeffs.data(), 2);
+    ASSERT_NEAR(out[0], expect[n], 1e-12);
+    ASSERT_NEAR(out[1], 0.0, 1e-12);
+    ASSERT_NEAR(out[2], -expect[n], 1e-12);
+  }
+}
+
+TEST(builtin_dsp, sos_coefficient_smoothing) {  // NOLINT
+  std::vector<double> state(sos::state_size, 0.0);
+  const double gain1[] = {1.0, 0.0, 0.0, 0.0, 0.0};
+  const double gain2[] = {2.0, 0.0, 0.0, 0.0, 0.0};
+  ASSERT_DOUBLE_EQ(sos::process(1.0, gain1, 1, state.data(), 48000.0), 1.0);
+  // moves smoothly toward the new gain, and converges within a second
+  double prev = 1.0;
+  for (int n = 0; n < 48000; n++) {
+    const double res = sos::process(1.0, gain2, 1, state.data(), 48000.0);
+    ASSERT_GE(res, prev);
+    ASSERT_LT(res - prev, 0.01);
+    prev = res;
+  }
+  ASSERT_NEAR(prev, 2.0, 1e-6);
+}
+
+TEST(builtin_dsp, array_operations) {  // NOLINT
+  // odd size to cover remainder loops
+  const size_t size = 103;
+  auto a = makeNoise(size, 6);
+  auto b = makeNoise(size, 7);
+  Context ctx;
+  double* dst = ctx.allocateArray(size);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(dst) % simd_alignment, 0U);
+  array::add(dst, a.data(), b.data(), size);
+  for (size_t i = 0; i < size; i++) { ASSERT_DOUBLE_EQ(dst[i], a[i] + b[i]); }
+  array::scale(dst, dst, 2.0, 1.0, size);  // in-place
+  for (size_t i = 0; i < size; i++) { ASSERT_DOUBLE_EQ(dst[i], (a[i] + b[i]) * 2.0 + 1.0); }
+  double dot = 0.0;
+  double sum = 0.0;
+  for (size_t i = 0; i < size; i++) {
+    dot += a[i] * b[i];
+    sum += a[i];
+  }
+  ASSERT_NEAR(array::dot(a.data(), b.data(), size), dot, 1e-12);
+  ASSERT_NEAR(array::sum(a.data(), size), sum, 1e-12);
+  ASSERT_EQ(array::min(a.data(), size), *std::min_element(a.begin(), a.end()));
+  ASSERT_EQ(array::max(a.data(), size), *std::max_element(a.begin(), a.end()));
+  ASSERT_EQ(array::max(a.data(), 0), 0.0);
+  array::map(dst, a.data(), size, [](double x) { return x * x; });
+  ASSERT_NEAR(array::fold(dst, size, 0.0, [](double acc, double x) { return acc + x; }),
+              array::dot(a.data(), a.data(), size), 1e-12);
+}
+
+TEST(builtin_dsp, array_extents) {  // NOLINT
+  Context ctx;
+  double* a = ctx.allocateArray(8);
+  ASSERT_EQ(ctx.clampSize(a, 100), 8U);
+  ASSERT_EQ(ctx.clampSize(a + 5, 100), 3U);
+  ASSERT_EQ(ctx.clampSize(a, 4, true), 4U);
+  const std::vector<double> file(16, 1.0);
+  ctx.registerArray(file.data(), file.size(), false);
+  ASSERT_EQ(ctx.clampSize(file.data(), 100), 16U);
+  ASSERT_EQ(ctx.getRejectedWrites(), 0U);
+  ASSERT_EQ(ctx.clampSize(file.data() + 1, 10, true), 0U);
+  ASSERT_EQ(ctx.getRejectedWrites(), 1U);
+  // empty file still has an element, which must not be read.
+  const std::vector<double> empty(1, 0.0);
+  ctx.registerArray(empty.data(), 0, false);
+  ASSERT_EQ(ctx.clampSize(empty.data(), 10), 0U);
+  // arrays of unknown extent are trusted.
+  std::vector<double> local(4);
+  ASSERT_EQ(ctx.clampSize(local.data(), 4, true), 4U);
+}
+
+TEST(builtin_dsp, recurrence_matches_serial) {  // NOLINT
+  // lengths not multiple of the lanes to check the tail.
+  const size_t size = 61;
+  auto input = makeNoise(size, 9);
+  std::vector<double> output(size);
+  // one pole lowpass
+  double y1 = 0.3;
+  double expect = y1;
+  recurrence::firstOrder(input.data(), output.data(), size, 0.99, y1);
+  for (size_t n = 0; n < size; n++) {
+    expect = input[n] + 0.99 * expect;
+    ASSERT_NEAR(output[n], expect, 1e-12);
+  }
+  ASSERT_EQ(y1, output.back());
+  // resonator with poles near the unit circle
+  const double b1 = 2 * 0.999 * std::cos(0.1);
+  const double b2 = -0.999 * 0.999;
+  double s1 = -0.2;
+  double s2 = 0.5;
+  double e1 = s1;
+  double e2 = s2;
+  recurrence::secondOrder(input.data(), output.data(), size, b1, b2, s1, s2);
+  for (size_t n = 0; n < size; n++) {
+    const double y = input[n] + b1 * e1 + b2 * e2;
+    e2 = e1;
+    e1 = y;
+    ASSERT_NEAR(output[n], y, 1e-9);
+  }
+  ASSERT_EQ(s1, output[size - 1]);
+  ASSERT_EQ(s2, output[size - 2]);
+}
+
+TEST(builtin_dsp, oversampler_passes_band) {  // NOLINT
+  for (size_t factor : {2, 4, 8}) {
+    Oversampler os(factor, 0, 48000.0);
+    // impulse through an identity region peaks at the latency.
+    std::vector<double> output(200);
+    for (size_t n = 0; n < output.size(); n++) {
+      os.upsample(n == 0 ? 1.0 : 0.0);
+      output[n] = os.downsample();
+    }
+    const auto peak = std::max_element(output.begin(), output.end()) - output.begin();
+    ASSERT_EQ(static_cast<size_t>(peak), Oversampler::latency);
+    // symmetric around the peak.
+    ASSERT_NEAR(output[peak - 1], output[peak + 1], 1e-12);
+    // dc
+    double res = 0.0;
+    for (size_t n = 0; n < 200; n++) {
+      os.upsample(1.0);
+      res = os.downsample();
+    }
+    ASSERT_NEAR(res, 1.0, 1e-3);
+  }
+}
+
+TEST(builtin_dsp, oversampler_skipped_while_preparing) {  // NOLINT
+  Oversampler prepared(2, 0, 48000.0);
+  Oversampler fresh(2, 0, 48000.0);
+  prepared.skip()[0] = 1.0;
+  ASSERT_EQ(prepared.downsample(), 0.0);
+  for (size_t n = 0; n < 100; n++) {
+    const double input = n == 0 ? 1.0 : 0.0;
+    prepared.upsample(input);
+    fresh.upsample(input);
+    ASSERT_EQ(prepared.downsample(), fresh.downsample()) << n;
+  }
+}
+
+TEST(builtin_dsp, oversampler_suppresses_aliases) {  // NOLINT
+  for (size_t factor : {2, 4, 8}) {
+    Oversampler os(factor, 0, 48000.0);
+    // a tone above the original nyquist frequency made in the region does not fold back.
+    const double freq = 0.7 / static_cast<double>(factor);
+    double peak = 0.0;
+    for (size_t n = 0; n < 400; n++) {
+      double* frame = os.upsample(0.0);
+      for (size_t k = 0; k < factor; k++) {
+        frame[k] = std::sin(2.0 * M_PI * freq * static_cast<double>(n * factor + k));
+      }
+      const double res = os.downsample();
+      if (n > 100) { peak = std::max(peak, std::abs(res)); }
+    }
+    ASSERT_LT(peak, 1e-3);
+  }
+}
+
+TEST(builtin_dsp, datafile_mapped) {  // NOLINT
+  const std::string filename = "datafile_test.f64";
+  auto table = makeNoise(5000, 8);
+  {
+    std::ofstream file(filename, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(table.data()),
+               static_cast<std::streamsize>(table.size() * sizeof(double)));
+  }
+  ASSERT_EQ(DataFile::getSize(filename), table.size());
+  {
+    Context ctx;
+    auto data = DataFile::load(ctx, filename);
+    ASSERT_EQ(data.size, table.size());
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(data.data) % simd_alignment, 0U);
+    for (size_t i = 0; i < table.size(); i++) { ASSERT_EQ(data.data[i], table[i]); }
+    ASSERT_EQ(ctx.getMappedBytes(), table.size() * sizeof(double));
+    ASSERT_TRUE(ctx.findArray(data.data)->writable);
+    // each load is a private copy, and the file is not modified.
+    auto other = DataFile::load(ctx, filename);
+    ASSERT_NE(other.data, data.data);
+    data.data[0] = 42.0;
+    ASSERT_EQ(other.data[0], table[0]);
+    ASSERT_EQ(DataFile::load(ctx, filename).data[0], table[0]);
+  }
+  std::remove(filename.c_str());
+
+  Context ctx;
+  auto missing = DataFile::load(ctx, "not_existing_file.f64");
+  ASSERT_EQ(missing.size, 0U);
+  ASSERT_NE(missing.data, nullptr);
+  ASSERT_EQ(DataFile::getSize("not_existing_file.f64"), 0U);
+  ASSERT_EQ(ctx.getMappedBytes(), 0U);
+  ASSERT_TRUE(DataFile::isAudioFile("kick.WAV"));
+  ASSERT_FALSE(DataFile::isAudioFile("table.f64"));
+}
+
+}  // namespace mimium::builtin
@@ -0,0 +1,724 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <cstring>
+#include <sstream>
+#include "compiler/builtin/context.hpp"
+#include "compiler/builtin/convolver.hpp"
+#include "compiler/builtin/oversampler.hpp"
+#include "offline_render.hpp"
+
+#include "gtest/gtest.h"
+
+namespace mimium {
+
+namespace {
+
+struct Result {
+  std::vector<double> samples;
+  size_t states = 0;
+  size_t late = 0;
+  // if dsp.block was generated.
+  bool has_block = false;
+};
+
+Result run(std::string const& source, int numblocks = 1, bool block = true) {
+  auto driver = std::make_unique<AudioDriverOffline>(numblocks, 64);
+  driver->setRecordOutput(true);
+  driver->setBlockProcessing(block);
+  auto& driver_ref = *driver;
+  Runtime runtime(std::move(driver), test::compileSource(source, "runtime_test.mmm"));
+  runtime.runMainFun();
+  const bool has_block = driver_ref.getDspFnInfos()->block_fn != nullptr;
+  runtime.start();
+  auto& ctx = runtime.getBuiltinContext();
+  return Result{driver_ref.getRecordedOutput(), ctx.getStateCount(), ctx.getLateCount(),
+                has_block};
+}
+
+// dsp.block has to produce the same output as dsp called sample by sample.
+void expectBlockEquivalent(std::string const& source, int numblocks) {
+  auto block = run(source, numblocks, true);
+  auto serial = run(source, numblocks, false);
+  ASSERT_TRUE(block.has_block);
+  ASSERT_EQ(block.samples.size(), serial.samples.size());
+  for (size_t n = 0; n < serial.samples.size(); n++) {
+    EXPECT_NEAR(block.samples[n], serial.samples[n], 1e-12) << n;
+  }
+}
+
+// scheduler exposing the queue, and recording the events of streams.
+class StreamScheduler : public Scheduler {
+ public:
+  [[nodiscard]] size_t getQueued() const { return tasks.size(); }
+  [[nodiscard]] size_t getStreams() const { return streams.size(); }
+  // pairs of the time when called and the value.
+  static inline std::vector<std::pair<int64_t, double>> fired;
+  static inline StreamScheduler* current = nullptr;
+  static void record(double value) { fired.emplace_back(current->getTime(), value); }
+  static void recordTask(const void* payload, void* /*cls*/) {
+    double value = 0.0;
+    std::memcpy(&value, payload, sizeof(double));
+    record(value);
+  }
+  // runs until the time, by blocks while no event is due as the audio driver does.
+  void runUntil(int64_t end) {
+    while (getTime() < end) {
+      if (getTime() + 64 > end || !advanceBlock(64)) { incrementTime(); }
+    }
+  }
+};
+
+}  // namespace
+
+TEST(runtime, builtin_states_prepared) {  // NOLINT
+  // the state of convolve is created before the audio starts, and the memory object of dsp is
+  // restored after the preparation.
+  auto res = run(R"(
+ir = [1,0.5,0.25]
+fn counter(){
+    return self+1
+}
+fn dsp(){
+    c = counter()
+    r = convolve(1,ir,3)
+    return (c,r)
+}
+)");
+  ASSERT_EQ(res.states, 1U);
+  ASSERT_EQ(res.late, 0U);
+  const std::vector<double> expect = {1, 1, 2, 1.5, 3, 1.75, 4, 1.75};
+  for (size_t i = 0; i < expect.size(); i++) { EXPECT_DOUBLE_EQ(res.samples[i], expect[i]); }
+}
+
+TEST(runtime, prepare_prints_nothing) {  // NOLINT
+  // dsp is evaluated once more while preparing the state of convolve, which must not be seen: it
+  // prints the same as without convolve, once per sample.
+  auto print = [](std::string const& expr) {
+    testing::internal::CaptureStdout();
+    auto res = run(R"(
+ir = [1,0.5,0.25]
+fn dsp(){
+    println(now)
+    r = )" + expr + R"(
+    return (r,r)
+}
+)");
+    return std::pair(res.states, testing::internal::GetCapturedStdout());
+  };
+  const auto [states, printed] = print("convolve(1,ir,3)");
+  const auto [nostates, expect] = print("1");
+  ASSERT_EQ(states, 1U);
+  ASSERT_EQ(nostates, 0U);
+  EXPECT_EQ(std::count(printed.cbegin(), printed.cend(), '\n'), 64);
+  EXPECT_EQ(printed, expect);
+}
+
+TEST(runtime, builtin_states_late) {  // NOLINT
+  // not called at the first sample.
+  auto res = run(R"(
+ir = [1,0.5,0.25]
+fn dsp(){
+    r = if(now>10) convolve(1,ir,3) else 0
+    return (r,r)
+}
+)");
+  ASSERT_EQ(res.states, 1U);
+  ASSERT_EQ(res.late, 1U);
+}
+
+TEST(runtime, stft_latency_compensated) {  // NOLINT
+  // the stft of 16 samples is delayed by 16 more samples to be aligned with the lookahead of 32.
+  auto res = run(R"(
+fn pass(x){
+    return x
+}
+fn keep(mag,phase,nbins){
+    m = arraymap(mag,mag,nbins,pass)
+}
+fn dsp(){
+    i = if(now==0) 1 else 0
+    s = stft(i,16,4,0,keep)
+    l = lookahead(i,32)
+    return (s,l)
+}
+)", 2);
+  ASSERT_EQ(res.states, 1U);
+  ASSERT_EQ(res.late, 0U);
+  // now reaches 0 after the latency.
+  const size_t impulse = 31;
+  for (size_t n = 0; n < 128; n++) {
+    EXPECT_NEAR(res.samples[n * 2], n == impulse + 32 ? 1.0 : 0.0, 1e-9) << n;
+    EXPECT_NEAR(res.samples[n * 2 + 1], n == impulse ? 1.0 : 0.0, 1e-9) << n;
+  }
+}
+
+TEST(runtime, lookahead_dry_path_delayed) {  // NOLINT
+  // the input passed through and the input mixed with a lookahead are delayed by the latency.
+  test::RenderOptions opt;
+  opt.numblocks = 2;
+  opt.framesize = 64;
+  opt.noise_seed = 1;
+  auto res = test::render(test::compileSource(R"(
+fn dsp(input:(float,float)){
+    x,y = input
+    l = lookahead(x,16)
+    return (l, x, l+x*0.5)
+}
+)",
+                                              "runtime_test.mmm"),
+                          opt);
+  ASSERT_EQ(res.channels, 3);
+  for (size_t n = 0; n + 16 < 128; n++) {
+    const double ahead = res.samples[n * 3];
+    const double dry = res.samples[(n + 16) * 3 + 1];
+    EXPECT_NE(ahead, 0.0);
+    EXPECT_DOUBLE_EQ(ahead, dry) << n;
+    EXPECT_DOUBLE_EQ(res.samples[n * 3 + 2], ahead + res.samples[n * 3 + 1] * 0.5) << n;
+  }
+}
+
+TEST(runtime, oversample_states_and_latency) {  // NOLINT
+  // each call site has its own state of the counter, called factor times per sample. the dry
+  // sine is delayed by the latency of the filters to be aligned with the oversampled one.
+  auto res = run(R"(
+fn counter(x){
+    return self+1
+}
+fn pass(x){
+    return x
+}
+fn phasor(freq){
+    return (self+freq)%1
+}
+fn dsp(){
+    s = sin(phasor(0.002)*6.283185307179586)
+    return (oversample(counter,0,2), oversample(counter,0,4), oversample(pass,s,2), s)
+}
+)",
+                 4);
+  ASSERT_EQ(res.states, 3U);
+  ASSERT_EQ(res.late, 0U);
+  const size_t channels = 4;
+  for (size_t n = 64; n + 1 < res.samples.size() / channels; n++) {
+    const auto* frame = &res.samples[n * channels];
+    const auto* next = &res.samples[(n + 1) * channels];
+    EXPECT_NEAR(next[0] - frame[0], 2.0, 1e-6) << n;
+    EXPECT_NEAR(next[1] - frame[1], 4.0, 1e-6) << n;
+    EXPECT_NEAR(frame[2], frame[3], 1e-4) << n;
+  }
+  // the dry path is delayed by the latency.
+  EXPECT_EQ(res.samples[3], 0.0);
+}
+
+TEST(runtime, samplerate_per_runtime) {  // NOLINT
+  // 6000Hz has a period of 8 samples at 48kHz and 4 samples at 24kHz.
+  const std::string source = R"(
+fn dsp(){
+    s = blsaw(6000)
+    return (s,s)
+}
+)";
+  for (auto [rate, period] : {std::pair(48000.0, 8U), std::pair(24000.0, 4U)}) {
+    test::RenderOptions opt;
+    opt.numblocks = 1;
+    opt.framesize = 64;
+    opt.samplerate = rate;
+    auto res = test::render(test::compileSource(source, "runtime_test.mmm"), opt);
+    for (size_t n = 0; n + period < 64; n++) {
+      EXPECT_NEAR(res.samples[n * 2], res.samples[(n + period) * 2], 1e-9) << rate;
+    }
+    EXPECT_GT(std::abs(res.samples[0] - res.samples[period / 4 * 2]), 0.1) << rate;
+  }
+}
+
+TEST(runtime, array_size_clamped) {  // NOLINT
+  auto res = run(R"(
+a = newarray(4)
+b = arrayfill(a,1,100)
+fn dsp(){
+    s = arraysum(b,100)
+    return (s,s)
+}
+)");
+  ASSERT_EQ(res.samples[0], 4.0);
+}
+
+TEST(runtime, fixed_array_size_clamped) {  // NOLINT
+  // literals and arrays on the stack are bounded by the length of their type.
+  auto res = run(R"(
+a = [1,2,3]
+b = [4,5]
+c = arrayfill(a,1,100)
+fn local(x){
+    l = [x,x]
+    f = arraycopy(l,a,1000)
+    return arraysum(l,1000)
+}
+fn dsp(){
+    return (arraysum(a,100)+arraysum(b,100),local(7))
+}
+)");
+  ASSERT_EQ(res.samples[0], 12.0);
+  ASSERT_EQ(res.samples[1], 2.0);
+}
+
+TEST(runtime, newarray_per_call_site) {  // NOLINT
+  // each call site of newarray allocates once while preparing, and its array starts with zeros
+  // even though the preparation wrote to it.
+  auto driver = std::make_unique<AudioDriverOffline>(3, 64);
+  driver->setRecordOutput(true);
+  auto& driver_ref = *driver;
+  Runtime runtime(std::move(driver), test::compileSource(R"(
+fn filled(x){
+    return arraysum(arrayfill(newarray(4),x,4),4)
+}
+fn dsp(){
+    a = newarray(1)
+    v = a[0]
+    a[0] = 5
+    return (v,filled(2))
+}
+)",
+                                                         "runtime_test.mmm"));
+  runtime.runMainFun();
+  runtime.prepare();
+  auto const& ctx = runtime.getBuiltinContext();
+  ASSERT_EQ(ctx.getArrayCount(), 2U);
+  runtime.start();
+  EXPECT_EQ(ctx.getArrayCount(), 2U);
+  EXPECT_EQ(ctx.getLateCount(), 0U);
+  auto const& samples = driver_ref.getRecordedOutput();
+  EXPECT_EQ(samples[0], 0.0);
+  EXPECT_EQ(samples[2], 5.0);
+  EXPECT_EQ(samples[1], 8.0);
+  EXPECT_EQ(samples.back(), 8.0);
+}
+
+TEST(runtime, loadwav_private_copy) {  // NOLINT
+  // loaded files are cached, while writes to the samples of a call are not seen by other calls and
+  // runtimes.
+  const std::string source = R"(
+a = loadwav("test_mono.wav")
+a[0] = 42
+b = loadwav("test_mono.wav")
+fn dsp(){
+    return (a[0],b[0])
+}
+)";
+  auto res = run(source);
+  auto other = run(source);
+  ASSERT_EQ(res.samples[0], 42.0);
+  ASSERT_NE(res.samples[1], 42.0);
+  ASSERT_EQ(other.samples[0], 42.0);
+  ASSERT_EQ(other.samples[1], res.samples[1]);
+}
+
+TEST(runtime, builtin_context_unused) {  // NOLINT
+  auto res = run(R"(
+fn dsp(){
+    return (1,2)
+}
+)");
+  ASSERT_EQ(res.states, 0U);
+  ASSERT_EQ(res.samples[0], 1.0);
+}
+
+TEST(runtime, memory_of_prepared_builtins) {  // NOLINT
+  // states are created by prepare() before the audio starts, the transformed impulse response is
+  // shared by the two convolvers, and the array of newarray is held by the context with its state.
+  auto driver = std::make_unique<AudioDriverOffline>(2, 64);
+  Runtime runtime(std::move(driver), test::compileSource(R"(
+ir = [1,0.5,0.25]
+a = newarray(100)
+fn pass(x){
+    return x
+}
+fn dsp(){
+    l = convolve(1,ir,3)
+    r = convolve(0,ir,3)
+    return (l,oversample(pass,r,2))
+}
+)",
+                                                         "runtime_test.mmm"));
+  runtime.runMainFun();
+  auto const& ctx = runtime.getBuiltinContext();
+  EXPECT_EQ(ctx.getStateCount(), 1U);
+  EXPECT_EQ(ctx.getArrayCount(), 1U);
+  EXPECT_EQ(ctx.getArrayBytes(), 100 * sizeof(double));
+  runtime.prepare();
+  ASSERT_EQ(ctx.getStateCount(), 4U);
+  EXPECT_EQ(ctx.getSharedCount(), 1U);
+  // reversed taps and the history of the direct form fir at least.
+  EXPECT_GE(ctx.getSharedBytes(), sizeof(builtin::ConvolverIR) +
+                                      builtin::Convolver::default_head_block * sizeof(double));
+  const size_t head = builtin::Convolver::default_head_block * sizeof(double);
+  EXPECT_GE(ctx.getStateBytes(), 2 * (sizeof(builtin::Convolver) + head * 4) +
+                                     sizeof(builtin::Oversampler) +
+                                     builtin::Oversampler::taps_per_phase * 2 * sizeof(double));
+  const size_t bytes = ctx.getStateBytes();
+  runtime.start();
+  EXPECT_EQ(ctx.getStateCount(), 4U);
+  EXPECT_EQ(ctx.getLateCount(), 0U);
+  EXPECT_EQ(ctx.getStateBytes(), bytes);
+}
+
+TEST(runtime, memory_report_static) {  // NOLINT
+  // each call of fbdelay has its own delay buffer, distinguished by the index in the path. the
+  // engine is released without running mimium_main.
+  MemoryReport report;
+  test::compileSource(R"(
+fn fbdelay(input:float,time:float){
+    return delay(input+self*0.5,time)
+}
+fn dsp(){
+    return (fbdelay(1,10),fbdelay(0,20))
+}
+)",
+                      "runtime_test.mmm", true, nullptr, &report);
+  ASSERT_TRUE(report.has_static);
+  EXPECT_EQ(report.delay_count, 2U);
+  std::vector<std::string> delays;
+  size_t sum = 0;
+  for (const auto& m : report.memobjs) {
+    sum += m.bytes;
+    if (m.isdelay) { delays.emplace_back(m.path); }
+  }
+  EXPECT_EQ(delays, (std::vector<std::string>{"dsp/fbdelay0/delay", "dsp/fbdelay0[1]/delay"}));
+  EXPECT_EQ(sum, report.memobj_bytes);
+  EXPECT_GT(report.delay_bytes, 0U);
+  EXPECT_LE(report.delay_bytes, report.memobj_bytes);
+}
+
+TEST(runtime, memory_report_print) {  // NOLINT
+  MemoryReport report;
+  MemoryReport::Measured m;
+  m.heap_bytes = 100;
+  m.sample_bytes = 1000;
+  m.mapped_bytes = 1 << 20;
+  m.state_count = 3;
+  m.state_bytes = 2048;
+  m.shared_count = 1;
+  m.shared_bytes = 24;
+  m.array_count = 1;
+  m.array_bytes = 800;
+  m.code_bytes = 4096;
+  m.data_bytes = 8;
+  report.measured = m;
+  std::ostringstream ss;
+  report.print(ss);
+  const auto out = ss.str();
+  EXPECT_EQ(out.find("compile time"), std::string::npos);
+  EXPECT_NE(out.find("after preparing dsp"), std::string::npos);
+  EXPECT_NE(out.find("2.0 KiB in 3\n"), std::string::npos) << out;
+  EXPECT_NE(out.find("800 B in 1\n"), std::string::npos) << out;
+  EXPECT_NE(out.find("1.0 MiB\n"), std::string::npos) << out;
+  // mapped files are excluded from the total.
+  EXPECT_EQ(MemoryReport::getTotal(m), 100U + 1000 + 2048 + 24 + 800 + 4096 + 8);
+  EXPECT_NE(out.find("7.9 KiB\n"), std::string::npos) << out;
+}
+
+TEST(runtime, idle_skips_silent_calls) {  // NOLINT
+  // `now` is 1 at the first sample. the decay goes below the threshold at the 7th sample, and the
+  // call sleeps 8 samples later.
+  // the constant frequency does not keep it awake, and the next trigger wakes it.
+  const std::string source = R"(
+fn voice(trig,freq){
+    IDLE
+    return max(trig, self*0.5)*min(freq,1)
+}
+fn dsp(){
+    t = if(now==1 || now==41) 1 else 0
+    v = voice(t,220)
+    return (v,v)
+}
+)";
+  auto replace = [&](std::string const& idle) {
+    auto res = source;
+    res.replace(res.find("IDLE"), 4, idle);
+    return res;
+  };
+  auto idle = run(replace("idle(0.01,8)"));
+  auto awake = run(replace(""));
+  size_t skipped = 0;
+  for (size_t n = 0; n < 64; n++) {
+    const double v = idle.samples[n * 2];
+    if (v != awake.samples[n * 2]) {
+      // only the silent tail differs, where the function returns 0.
+      EXPECT_EQ(v, 0.0) << n;
+      EXPECT_LT(awake.samples[n * 2], 0.01) << n;
+      skipped++;
+    }
+  }
+  EXPECT_GT(skipped, 20U);
+  EXPECT_EQ(idle.samples[40 * 2], 1.0);
+  EXPECT_EQ(idle.samples[41 * 2], 0.5);
+}
+
+TEST(runtime, advance_block) {  // NOLINT
+  StreamScheduler sch;
+  StreamScheduler::current = &sch;
+  StreamScheduler::fired.clear();
+  // blocks are not used without dsp.
+  sch.start(false);
+  ASSERT_FALSE(sch.advanceBlock(64));
+  sch.start(true);
+  auto* taskfn = reinterpret_cast<void*>(&StreamScheduler::recordTask);  // NOLINT
+  const double value = 1.0;
+  // a task is executed in the sample after its time, which is the last sample of the block.
+  sch.addTask(63, taskfn, &value, sizeof(double), nullptr);
+  ASSERT_FALSE(sch.advanceBlock(64));
+  ASSERT_EQ(sch.getTime(), 0);
+  sch.runUntil(64);
+  ASSERT_EQ(StreamScheduler::fired.size(), 1U);
+  EXPECT_EQ(StreamScheduler::fired[0].first, 64);
+  // the task after the block does not stop it.
+  sch.addTask(128, taskfn, &value, sizeof(double), nullptr);
+  ASSERT_TRUE(sch.advanceBlock(64));
+  ASSERT_EQ(sch.getTime(), 128);
+  ASSERT_EQ(StreamScheduler::fired.size(), 1U);
+  ASSERT_FALSE(sch.advanceBlock(64));
+  sch.incrementTime();
+  ASSERT_EQ(StreamScheduler::fired.size(), 2U);
+  EXPECT_EQ(StreamScheduler::fired[1].first, 129);
+  ASSERT_TRUE(sch.advanceBlock(64));
+}
+
+TEST(runtime, block_equals_serial_stateful) {  // NOLINT
+  // a nonlinear recurrence, a first order recurrence on it, a delay and stateless parts around
+  // them.
+  expectBlockEquivalent(R"(
+fn phasor(freq){
+    return (self+freq)%1
+}
+fn lpf(x,a){
+    return x*(1-a)+self*a
+}
+fn dsp(){
+    p = phasor(0.013)*2-1
+    f = lpf(p,0.9)
+    d = delay(f*0.5,37)
+    return (f*f, d+p*0.25)
+}
+)",
+                        8);
+}
+
+TEST(runtime, recurrence_block_equals_serial) {  // NOLINT
+  // recurrences on noise input are evaluated by mimium_recurrence1/2 in dsp.block.
+  auto source = R"(
+a = 0.9
+fn lpf(x,a){
+    return x*(1-a)+self*a
+}
+fn reso(x){
+    return x+1.6*self-0.8*mem(self)
+}
+fn dsp(input:(float,float)){
+    l,r = input
+    return (lpf(l,a), reso(r))
+}
+)";
+  test::RenderOptions opt;
+  opt.numblocks = 4;
+  opt.noise_seed = 1;
+  auto block = test::render(test::compileSource(source, "runtime_test.mmm"), opt);
+  opt.block = false;
+  auto serial = test::render(test::compileSource(source, "runtime_test.mmm"), opt);
+  ASSERT_EQ(block.samples.size(), serial.samples.size());
+  for (size_t n = 0; n < serial.samples.size(); n++) {
+    EXPECT_NEAR(block.samples[n], serial.samples[n], 1e-9) << n;
+  }
+}
+
+TEST(runtime, offline_driver_measures_and_evicts) {  // NOLINT
+  // evicting caches between blocks does not change the output, and only dsp is timed.
+  auto source = R"(
+fn lpf(x,a){
+    return x*(1-a)+self*a
+}
+fn dsp(input:(float,float)){
+    l,r = input
+    return (lpf(l,0.5), r)
+}
+)";
+  test::RenderOptions opt;
+  opt.numblocks = 4;
+  opt.noise_seed = 1;
+  auto plain = test::render(test::compileSource(source, "runtime_test.mmm"), opt);
+  opt.evict_bytes = 1024 * 1024;
+  auto evicted = test::render(test::compileSource(source, "runtime_test.mmm"), opt);
+  EXPECT_EQ(plain.samples, evicted.samples);
+  EXPECT_GT(plain.elapsed, 0.0);
+  EXPECT_GT(evicted.elapsed, 0.0);
+  opt.record = false;
+  auto unrecorded = test::render(test::compileSource(source, "runtime_test.mmm"), opt);
+  EXPECT_TRUE(unrecorded.samples.empty());
+  EXPECT_EQ(unrecorded.channels, 2);
+}
+
+TEST(runtime, block_equals_serial_scheduled) {  // NOLINT
+  // the gain is changed by tasks in the middle of blocks, where the driver falls back to dsp.
+  const std::string source = R"(
+gain = 1
+fn setgain(g){
+    gain = g
+}
+setgain(0.5)@100
+setgain(0.25)@130
+setgain(2)@300
+fn lpf(x,a){
+    return x*(1-a)+self*a
+}
+fn dsp(){
+    s = lpf(gain,0.5)
+    return (s,gain)
+}
+)";
+  expectBlockEquivalent(source, 8);
+  auto res = run(source, 8);
+  // the sample n is computed at the time n+1.
+  EXPECT_EQ(res.samples[99 * 2 + 1], 1.0);
+  EXPECT_EQ(res.samples[100 * 2 + 1], 0.5);
+  EXPECT_EQ(res.samples[300 * 2 + 1], 2.0);
+}
+
+TEST(runtime, scheduled_call_payload) {  // NOLINT
+  // payloads of 24 bytes, larger than a pointer.
+  auto res = run(R"(
+a = 0
+b = 0
+c = 0
+fn set3(x:float,y:float,z:float)->void{
+    a = x
+    b = y
+    c = z
+}
+fn settuple(t:(float,float),z:float)->void{
+    x,y = t
+    a = x+z
+    b = y
+}
+set3(1,2,3)@10
+set3(2,4,6)@20
+set3(3,6,9)@30
+settuple((10,20),5)@40
+fn dsp(){
+    return (a,b+c)
+}
+)");
+  // the sample n is computed at the time n+1.
+  const std::vector<std::pair<double, double>> expect = {
+      {0, 0}, {1, 5}, {2, 10}, {3, 15}, {15, 29}};
+  for (size_t i = 0; i < expect.size(); i++) {
+    const size_t n = i * 10;
+    EXPECT_EQ(res.samples[n * 2], expect[i].first) << n;
+    EXPECT_EQ(res.samples[n * 2 + 1], expect[i].second) << n;
+  }
+}
+
+TEST(runtime, event_stream_window) {  // NOLINT
+  // an event every 1000 samples. only the ones within the window are queued, and the rest are
+  // queued at every half of the window.
+  std::vector<double> times;
+  std::vector<double> values;
+  for (int i = 0; i < 20; i++) {
+    times.push_back(i * 1000.0);
+    values.push_back(i);
+  }
+  StreamScheduler sch;
+  StreamScheduler::current = &sch;
+  StreamScheduler::fired.clear();
+  sch.start(true);
+  auto* fn = reinterpret_cast<void*>(&StreamScheduler::record);  // NOLINT
+  sch.addEventStream(fn, times.data(), values.data(), times.size());
+  static_assert(Scheduler::stream_window == 4096);
+  ASSERT_EQ(sch.getQueued(), 5U);  // 0 to 4000
+  sch.runUntil(Scheduler::stream_window / 2 - 1);
+  ASSERT_EQ(sch.getQueued(), 2U);  // 3000 and 4000
+  sch.runUntil(Scheduler::stream_window / 2);
+  ASSERT_EQ(sch.getQueued(), 4U);  // refilled with 5000 and 6000
+  sch.runUntil(30000);
+  ASSERT_EQ(sch.getQueued(), 0U);
+  ASSERT_EQ(sch.getStreams(), 0U);
+  ASSERT_EQ(StreamScheduler::fired.size(), times.size());
+  for (size_t i = 0; i < times.size(); i++) {
+    // events are executed in the sample after their time, the same as tasks.
+    EXPECT_EQ(StreamScheduler::fired[i].first, static_cast<int64_t>(times[i]) + 1) << i;
+    EXPECT_EQ(StreamScheduler::fired[i].second, values[i]);
+  }
+}
+
+TEST(runtime, event_stream_order_across_refills) {  // NOLINT
+  // two streams interleaved with each other and with a task, including a gap longer than the
+  // window and events at the boundary of it.
+  const std::vector<double> times_a = {0, 2047, 2048, 4095, 4096, 20000, 20001};
+  const std::vector<double> times_b = {10, 4095.5, 6143, 6144, 19999};
+  std::vector<double> values_a;
+  std::vector<double> values_b;
+  for (auto t : times_a) { values_a.push_back(t); }
+  for (auto t : times_b) { values_b.push_back(t); }
+  StreamScheduler sch;
+  StreamScheduler::current = &sch;
+  StreamScheduler::fired.clear();
+  sch.start(true);
+  auto* fn = reinterpret_cast<void*>(&StreamScheduler::record);  // NOLINT
+  sch.addEventStream(fn, times_a.data(), values_a.data(), times_a.size());
+  sch.addEventStream(fn, times_b.data(), values_b.data(), times_b.size());
+  const double task_time = 5000;
+  auto* taskfn = reinterpret_cast<void*>(&StreamScheduler::recordTask);  // NOLINT
+  sch.addTask(task_time, taskfn, &task_time, sizeof(double), nullptr);
+  sch.runUntil(30000);
+  std::vector<int64_t> expect = {static_cast<int64_t>(task_time)};
+  for (auto t : times_a) { expect.push_back(static_cast<int64_t>(t)); }
+  for (auto t : times_b) { expect.push_back(static_cast<int64_t>(t)); }
+  std::sort(expect.begin(), expect.end());
+  ASSERT_EQ(StreamScheduler::fired.size(), expect.size());
+  for (size_t i = 0; i < expect.size(); i++) {
+    EXPECT_EQ(StreamScheduler::fired[i].first, expect[i] + 1) << i;
+    EXPECT_EQ(static_cast<int64_t>(StreamScheduler::fired[i].second), expect[i]) << i;
+  }
+}
+
+TEST(runtime, event_stream_copied_and_sorted) {  // NOLINT
+  // arrays which may be released before the events end are copied, and unsorted times are
+  // refused.
+  std::vector<double> times = {10, 20};
+  std::vector<double> values = {1, 2};
+  StreamScheduler sch;
+  StreamScheduler::current = &sch;
+  StreamScheduler::fired.clear();
+  sch.start(true);
+  auto* fn = reinterpret_cast<void*>(&StreamScheduler::record);  // NOLINT
+  ASSERT_TRUE(sch.addEventStream(fn, times.data(), values.data(), times.size(), true));
+  times = {0, 0};
+  values = {0, 0};
+  const std::vector<double> unsorted = {30, 25};
+  ASSERT_FALSE(sch.addEventStream(fn, unsorted.data(), values.data(), unsorted.size()));
+  ASSERT_EQ(sch.getStreams(), 0U);
+  sch.runUntil(100);
+  const std::vector<std::pair<int64_t, double>> expect = {{11, 1}, {21, 2}};
+  ASSERT_EQ(StreamScheduler::fired, expect);
+}
+
+TEST(runtime, eventseq_local_arrays) {  // NOLINT
+  // the arrays made in play are released when it returns, and the unsorted sequence is ignored.
+  testing::internal::CaptureStdout();
+  run(R"(
+fn show(x){
+    println(x)
+}
+fn play(b){
+    eventseq(show,[b,b+10],[b*2,b*3],2)
+}
+play(5)
+eventseq(show,[40,30],[3,4],2)
+fn dsp(){
+    return (0,0)
+}
+)");
+  ASSERT_EQ(testing::internal::GetCapturedStdout(), "10\n15\n");
+}
+
+}  // namespace mimium
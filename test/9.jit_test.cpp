@@ -0,0 +1,605 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "basic/error_def.hpp"
+#include "compiler/codegen/llvm_header.hpp"
+#include "libmimium.hpp"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Verifier.h"
+#include "offline_render.hpp"
+#include "runtime/executionengine/llvm/autotuner.hpp"
+#include "runtime/executionengine/llvm/dsp_cost.hpp"
+#include "runtime/executionengine/llvm/mimium_llvm_orcjit.hpp"
+
+#include "gtest/gtest.h"
+
+// tests of the passes and the components of the jit engine on llvm ir, without running it.
+
+namespace mimium {
+
+namespace {
+
+struct CompiledModule {
+  std::unique_ptr<llvm::LLVMContext> ctx;
+  std::unique_ptr<llvm::Module> module;
+};
+
+CompiledModule compileModule(std::string const& source) {
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  Compiler compiler;
+  compiler.setFilePath(fs::absolute("jit_test.mmm").string());
+  auto ast_u = compiler.renameSymbols(compiler.loadSource(source));
+  compiler.typeInfer(ast_u);
+  auto mir = compiler.closureConvert(compiler.generateMir(ast_u));
+  compiler.generateLLVMIr(mir, compiler.collectMemoryObjs(mir));
+  return CompiledModule{compiler.moveLLVMCtx(), compiler.moveLLVMModule()};
+}
+
+// compiles the source and runs the pipeline of the jit on it.
+CompiledModule optimizeSource(std::string const& source, TuneConfig const& config = {}) {
+  auto res = compileModule(source);
+  llvm::orc::MimiumJIT::optimize(*res.module, config);
+  return res;
+}
+
+bool hasBlock(llvm::Function const& f, llvm::StringRef prefix) {
+  return std::any_of(f.begin(), f.end(),
+                     [&](auto const& bb) { return bb.getName().startswith(prefix); });
+}
+
+// the widest vector of doubles computed in the function, 0 if not vectorized.
+unsigned getVectorWidth(llvm::Function& f) {
+  unsigned res = 0;
+  for (auto& inst : llvm::instructions(f)) {
+    auto* type = llvm::dyn_cast<llvm::VectorType>(inst.getType());
+    if (type != nullptr && type->getElementType()->isDoubleTy() &&
+        llvm::isa<llvm::BinaryOperator>(inst)) {
+      res = std::max<unsigned>(res, type->getElementCount().getKnownMinValue());
+    }
+  }
+  return res;
+}
+
+// stateless parts before and after a stateful builtin.
+const std::string split_source = R"(
+fn dsp(input:(float,float)){
+    l,r = input
+    a = l*0.5+r*0.25
+    d = delay(a,100)
+    return (d*d, a*3)
+}
+)";
+
+size_t countCalls(llvm::Function& f, llvm::StringRef name) {
+  return std::count_if(llvm::inst_begin(f), llvm::inst_end(f), [&](llvm::Instruction& inst) {
+    auto* call = llvm::dyn_cast<llvm::CallInst>(&inst);
+    return call != nullptr && call->getCalledFunction() != nullptr &&
+           call->getCalledFunction()->getName() == name;
+  });
+}
+
+llvm::Function* findFunction(llvm::Module& m, llvm::StringRef prefix) {
+  for (auto& f : m) {
+    if (f.getName().startswith(prefix) && !f.isDeclaration()) { return &f; }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST(jit, frame_loop_split) {  // NOLINT
+  auto unoptimized = compileModule(split_source);
+  auto* blockfn = unoptimized.module->getFunction("dsp.block");
+  ASSERT_NE(blockfn, nullptr);
+  // the frame loop is found only after dsp is inlined.
+  ASSERT_FALSE(SampleLoopSplitter::run(*blockfn));
+  auto compiled = optimizeSource(split_source);
+  blockfn = compiled.module->getFunction("dsp.block");
+  ASSERT_NE(blockfn, nullptr);
+  EXPECT_TRUE(hasBlock(*blockfn, "frame.pre"));
+  EXPECT_TRUE(hasBlock(*blockfn, "frame.state"));
+  EXPECT_TRUE(hasBlock(*blockfn, "frame.post"));
+  EXPECT_FALSE(llvm::verifyFunction(*blockfn, &llvm::errs()));
+  // the stateless loops are vectorized across samples.
+  EXPECT_GE(getVectorWidth(*blockfn), 2U);
+}
+
+TEST(jit, frame_loop_vectorize_hints) {  // NOLINT
+  TuneConfig config;
+  config.vectorize.width = 4;
+  auto compiled = optimizeSource(split_source, config);
+  EXPECT_EQ(getVectorWidth(*compiled.module->getFunction("dsp.block")), 4U);
+}
+
+TEST(jit, frame_loop_recurrences) {  // NOLINT
+  // a one-pole lowpass and a two-pole resonator, whose coefficients are given by globals.
+  auto compiled = optimizeSource(R"(
+a = 0.9
+fn lpf(x,a){
+    return x*(1-a)+self*a
+}
+fn reso(x){
+    return x+1.6*self-0.8*mem(self)
+}
+fn dsp(input:(float,float)){
+    l,r = input
+    return (lpf(l,a), reso(r))
+}
+)");
+  auto& blockfn = *compiled.module->getFunction("dsp.block");
+  EXPECT_EQ(countCalls(blockfn, "mimium_recurrence1"), 1U);
+  EXPECT_EQ(countCalls(blockfn, "mimium_recurrence2"), 1U);
+  EXPECT_TRUE(hasBlock(blockfn, "frame.scan"));
+  EXPECT_FALSE(llvm::verifyFunction(blockfn, &llvm::errs()));
+}
+
+TEST(jit, frame_loop_nonlinear_recurrence) {  // NOLINT
+  // self in a nonlinear expression stays in the stateful loop.
+  auto compiled = optimizeSource(R"(
+fn phasor(x){
+    return (self+x)%1
+}
+fn dsp(input:(float,float)){
+    l,r = input
+    p = phasor(l)
+    return (p,p)
+}
+)");
+  auto& blockfn = *compiled.module->getFunction("dsp.block");
+  EXPECT_EQ(countCalls(blockfn, "mimium_recurrence1"), 0U);
+  EXPECT_EQ(countCalls(blockfn, "mimium_recurrence2"), 0U);
+  EXPECT_FALSE(hasBlock(blockfn, "frame.scan"));
+}
+
+TEST(jit, profile_instrument_and_apply) {  // NOLINT
+  // now is never negative, so that cold is never called and hot is called in every sample.
+  const std::string source = R"(
+fn cold(x){
+    return x*2
+}
+fn hot(x){
+    return x+1
+}
+fn choose(n){
+    if(n<0){
+        return cold(n)
+    }else{
+        return hot(n)
+    }
+}
+fn dsp(){
+    v = choose(now)
+    return (v,v)
+}
+)";
+  const auto path = fs::temp_directory_path() / "mimium_jit_test.profile";
+  auto engine = test::compileSource(source, "jit_test.mmm");
+  engine->setProfileOutput(path.string());
+  test::RenderOptions opt;
+  opt.numblocks = 2;
+  opt.framesize = 64;
+  test::render(std::move(engine), opt);
+  auto profile = DspProfile::load(path.string());
+  fs::remove(path);
+  const uint64_t samples = 128;
+  auto compiled = compileModule(source);
+  auto* choose = findFunction(*compiled.module, "choose");
+  auto* cold = findFunction(*compiled.module, "cold");
+  auto* hot = findFunction(*compiled.module, "hot");
+  ASSERT_TRUE(choose != nullptr && cold != nullptr && hot != nullptr);
+  auto const& counts = profile.getFunctions();
+  EXPECT_EQ(counts.at("dsp").entry, samples);
+  auto const& choose_counts = counts.at(choose->getName().str());
+  ASSERT_EQ(choose_counts.branches.size(), 1U);
+  EXPECT_EQ(choose_counts.branches[0].first, 0U);
+  EXPECT_EQ(choose_counts.branches[0].second, samples);
+  EXPECT_EQ(counts.at(cold->getName().str()).entry, 0U);
+  EXPECT_EQ(counts.at(hot->getName().str()).entry, samples);
+
+  profile.apply(*compiled.module);
+  EXPECT_TRUE(cold->hasFnAttribute(llvm::Attribute::Cold));
+  EXPECT_TRUE(hot->hasFnAttribute(llvm::Attribute::AlwaysInline));
+  EXPECT_EQ(choose->getEntryCount()->getCount(), samples);
+  auto* br = llvm::cast<llvm::BranchInst>(choose->getEntryBlock().getTerminator());
+  uint64_t taken = 0;
+  uint64_t nottaken = 0;
+  ASSERT_TRUE(br->extractProfMetadata(taken, nottaken));
+  // weights are offset by one.
+  EXPECT_EQ(taken, 1U);
+  EXPECT_EQ(nottaken, samples + 1);
+  // the block calling cold is moved to the end.
+  EXPECT_EQ(&choose->back(), br->getSuccessor(0));
+  EXPECT_FALSE(llvm::verifyFunction(*choose, &llvm::errs()));
+}
+
+TEST(jit, scheduled_call_payload_in_entry) {  // NOLINT
+  // the payload of a call with @ in a branch is allocated in the entry block.
+  auto compiled = compileModule(R"(
+fn set3(x:float,y:float,z:float)->void{
+    println(x+y+z)
+}
+fn schedule(n:float)->void{
+    if(n>0){
+        set3(n,n,n)@(n*10)
+    }
+}
+schedule(1)
+)");
+  size_t payloads = 0;
+  for (auto& f : *compiled.module) {
+    for (auto& inst : llvm::instructions(f)) {
+      if (llvm::isa<llvm::AllocaInst>(inst) && inst.getName().endswith(".payload")) {
+        EXPECT_EQ(inst.getParent(), &f.getEntryBlock()) << f.getName().str();
+        payloads++;
+      }
+    }
+  }
+  EXPECT_EQ(payloads, 1U);
+}
+
+TEST(jit, symbols_registered) {  // NOLINT
+  auto const& symbols = LLVMJitExecutionEngine::getSymbols();
+  auto expectRegistered = [&](std::string const& name, std::string const& what) {
+    auto iter = symbols.find(name);
+    ASSERT_NE(iter, symbols.cend()) << name << " of " << what;
+    ASSERT_NE(iter->second, nullptr) << name << " of " << what;
+  };
+  for (auto&& [name, info] : LLVMBuiltin::ftable) {
+    if (!info.target_fnname.empty()) { expectRegistered(info.target_fnname, name); }
+  }
+  // functions declared by the code generator and the passes, including the runtime functions
+  // declared in every module.
+  auto compiled = optimizeSource(R"(
+fn lpf(x,a){
+    return x*(1-a)+self*a
+}
+fn drive(x){
+    return tanh(x*4)
+}
+fn note(x:float)->void{
+    println(x)
+}
+note(1)@10
+fn dsp(input:(float,float)){
+    l,r = input
+    return (lpf(l,0.9), oversample(drive,r,2))
+}
+)");
+  for (auto& f : *compiled.module) {
+    if (f.isDeclaration() && !f.isIntrinsic()) { expectRegistered(f.getName().str(), "module"); }
+  }
+}
+
+TEST(jit, ir_file_round_trip) {  // NOLINT
+  const std::string source = R"(
+fn unused(x){
+    return x*3
+}
+fn lpf(x,a){
+    return x*(1-a)+self*a
+}
+fn dsp(input:(float,float)){
+    l,r = input
+    return (lpf(l,0.9), r)
+}
+)";
+  test::RenderOptions opt;
+  opt.numblocks = 2;
+  opt.noise_seed = 1;
+  auto expect = test::render(test::compileSource(source, "jit_test.mmm"), opt);
+  for (const auto* ext : {".bc", ".ll"}) {
+    const auto path = fs::temp_directory_path() / (std::string("mimium_jit_test") + ext);
+    {
+      auto compiled = compileModule(source);
+      ASSERT_NE(findFunction(*compiled.module, "unused"), nullptr);
+      std::error_code ec;
+      llvm::raw_fd_ostream out(path.string(), ec);
+      ASSERT_FALSE(ec) << ec.message();
+      if (std::string(ext) == ".bc") {
+        llvm::WriteBitcodeToFile(*compiled.module, out);
+      } else {
+        compiled.module->print(out, nullptr);
+      }
+    }
+    {
+      llvm::LLVMContext ctx;
+      auto loaded = LLVMJitExecutionEngine::loadIRFile(path.string(), ctx);
+      // functions not reachable from the entry points are dropped.
+      EXPECT_EQ(findFunction(*loaded, "unused"), nullptr) << ext;
+      EXPECT_NE(findFunction(*loaded, "lpf"), nullptr) << ext;
+      EXPECT_NE(loaded->getFunction("mimium_main"), nullptr) << ext;
+      EXPECT_FALSE(loaded->materializeAll()) << ext;
+      EXPECT_FALSE(llvm::verifyModule(*loaded, &llvm::errs())) << ext;
+    }
+    auto res = test::render(std::make_unique<LLVMJitExecutionEngine>(path.string()), opt);
+    fs::remove(path);
+    ASSERT_EQ(res.samples.size(), expect.samples.size()) << ext;
+    for (size_t n = 0; n < expect.samples.size(); n++) {
+      EXPECT_EQ(res.samples[n], expect.samples[n]) << ext << " " << n;
+    }
+  }
+  llvm::LLVMContext ctx;
+  EXPECT_THROW(LLVMJitExecutionEngine::loadIRFile("not_existing_file.bc", ctx),  // NOLINT
+               mimium::RuntimeError);
+}
+
+TEST(jit, hot_code_separate_region) {  // NOLINT
+  const std::string source = R"(
+fn lpf(x,a){
+    return x*(1-a)+self*a
+}
+fn dsp(input:(float,float)){
+    l,r = input
+    return (lpf(l,0.9), r)
+}
+)";
+  using Options = HotCodeMemoryManager::Options;
+  for (auto const& options : {Options{true, false, false}, Options{true, true, false},
+                              Options{true, false, true}, Options{false, false, false}}) {
+    auto compiled = compileModule(source);
+    llvm::orc::MimiumJIT jit(std::move(compiled.ctx), llvm::orc::MimiumJIT::NORMAL);
+    jit.setCodeMemoryOptions(options);
+    ASSERT_FALSE(jit.addSymbols(LLVMJitExecutionEngine::getSymbols()));
+    ASSERT_FALSE(jit.addModule(std::move(compiled.module)));
+    auto address = [&](llvm::StringRef name) {
+      auto sym = jit.lookup(name);
+      EXPECT_TRUE(static_cast<bool>(sym)) << name.str();
+      if (!sym) {
+        llvm::consumeError(sym.takeError());
+        return uintptr_t(0);
+      }
+      return static_cast<uintptr_t>(sym->getAddress());
+    };
+    auto const& usage = jit.getCodeUsage();
+    const auto main = address("mimium_main");
+    const auto dsp = address("dsp");
+    const auto block = address("dsp.block");
+    const uintptr_t begin = usage.hot_begin;
+    const size_t size = usage.hot_size;
+    auto is_hot = [&](uintptr_t addr) { return addr >= begin && addr < begin + size; };
+    if (!options.separate) {
+      EXPECT_EQ(size, 0U);
+      continue;
+    }
+    ASSERT_GT(size, 0U);
+    EXPECT_TRUE(is_hot(dsp));
+    EXPECT_TRUE(is_hot(block));
+    EXPECT_FALSE(is_hot(main));
+    if (options.huge_pages) { EXPECT_EQ(begin % (2 * 1024 * 1024), 0U); }
+    // locking may be refused by the limit of the system, and the region is used anyway.
+    if (!options.lock) { EXPECT_FALSE(usage.hot_locked); }
+  }
+}
+
+// simulates the failures of the system calls.
+class FailingMemoryManager : public HotCodeMemoryManager {
+ public:
+  FailingMemoryManager(Options options, std::shared_ptr<Usage> usage, bool fail_map,
+                       bool fail_huge, bool fail_lock)
+      : HotCodeMemoryManager(options, std::move(usage)),
+        fail_map(fail_map),
+        fail_huge(fail_huge),
+        fail_lock(fail_lock) {}
+
+ protected:
+  llvm::sys::MemoryBlock mapRegion(size_t size, unsigned flags, std::error_code& ec) override {
+    if (fail_map) {
+      ec = std::make_error_code(std::errc::not_enough_memory);
+      return {};
+    }
+    return HotCodeMemoryManager::mapRegion(size, flags, ec);
+  }
+  bool adviseHugePages(void* addr, size_t size) override {
+    return !fail_huge && HotCodeMemoryManager::adviseHugePages(addr, size);
+  }
+  bool lockRegion(void* addr, size_t size) override {
+    return !fail_lock && HotCodeMemoryManager::lockRegion(addr, size);
+  }
+
+ private:
+  bool fail_map;
+  bool fail_huge;
+  bool fail_lock;
+};
+
+TEST(jit, hot_code_fallbacks) {  // NOLINT
+  const HotCodeMemoryManager::Options options{true, true, true};
+  for (const int failure : {0, 1, 2}) {
+    auto usage = std::make_shared<HotCodeMemoryManager::Usage>();
+    FailingMemoryManager manager(options, usage, failure == 0, failure == 1, failure == 2);
+    auto* hot = manager.allocateCodeSection(100, 16, 0, ".text.mimium.hot");
+    auto* cold = manager.allocateCodeSection(100, 16, 1, ".text");
+    ASSERT_NE(hot, nullptr) << failure;
+    ASSERT_NE(cold, nullptr) << failure;
+    // sections are writable until finalized.
+    std::fill_n(hot, 100, 0);
+    const auto begin = usage->hot_begin.load();
+    const auto addr = reinterpret_cast<uintptr_t>(hot);
+    if (failure == 0) {
+      // allocated among other code.
+      EXPECT_EQ(usage->hot_size, 0U);
+    } else {
+      EXPECT_EQ(addr, begin);
+      EXPECT_EQ(begin % (2 * 1024 * 1024), 0U);
+      EXPECT_NE(reinterpret_cast<uintptr_t>(cold), begin);
+    }
+    // failing to map or lock leaves the region unlocked.
+    if (failure != 1) { EXPECT_FALSE(usage->hot_locked) << failure; }
+    EXPECT_EQ(usage->code, 200U);
+    std::string err;
+    EXPECT_FALSE(manager.finalizeMemory(&err)) << err;
+  }
+}
+
+TEST(jit, tune_cache_round_trip) {  // NOLINT
+  const auto path = (fs::temp_directory_path() / "mimium_jit_test_tune.txt").string();
+  const std::string source = R"(
+fn lpf(x){
+    return x*0.5+self*0.5
+}
+fn dsp(){
+    return (lpf(1), 0)
+}
+)";
+  const auto lpf = compileModule(source);
+  const auto gain = compileModule("fn dsp(){ return (0.5, 0) }");
+  const auto key = TuneCache::getKey(*lpf.module);
+  EXPECT_EQ(key, TuneCache::getKey(*compileModule(source).module));
+  EXPECT_NE(key, TuneCache::getKey(*gain.module));
+  TuneConfig config;
+  config.inline_level = 3;
+  config.vectorize.width = 4;
+  config.vectorize.interleave = 2;
+  config.block_size = 16;
+  TuneCache cache;
+  cache.insert(key, config);
+  cache.save(path);
+  auto loaded = TuneCache::load(path);
+  ASSERT_TRUE(loaded.find(key).has_value());
+  EXPECT_EQ(loaded.find(key).value(), config);
+  EXPECT_FALSE(loaded.find(TuneCache::getKey(*gain.module)).has_value());
+  // files of another format are ignored.
+  std::ofstream(path) << "something else\n" << key << " 3 4 2 16\n";
+  EXPECT_FALSE(TuneCache::load(path).find(key).has_value());
+  fs::remove(path);
+  EXPECT_FALSE(TuneCache::load(path).find(key).has_value());
+}
+
+TEST(jit, autotune_discards_candidate_output) {  // NOLINT
+  // mimium_main runs for each candidate, but prints only in the real run.
+  auto compiled = compileModule(R"(
+println(1)
+fn lpf(x,a){
+    return x*(1-a)+self*a
+}
+fn dsp(input:(float,float)){
+    l,r = input
+    return (lpf(l,0.9), r)
+}
+)");
+  std::ostringstream captured;
+  auto* out = std::cout.rdbuf(captured.rdbuf());
+  const auto config = AutoTuner::tune(*compiled.module);
+  std::cout.rdbuf(out);
+  EXPECT_EQ(captured.str(), "");
+  // a candidate differs from the default in one option, searched in turn.
+  EXPECT_TRUE(config.inline_level == 1 || config.inline_level == 2 || config.inline_level == 3);
+  EXPECT_TRUE(config.vectorize.width <= 8);
+  EXPECT_TRUE(config.vectorize.interleave <= 4);
+  EXPECT_TRUE(config.block_size == 16 || config.block_size == 32 ||
+              config.block_size == TuneConfig{}.block_size);
+  EXPECT_EQ(Logger::current_report_level, Logger::WARNING);
+}
+
+TEST(jit, cost_table_covers_builtins) {  // NOLINT
+  // builtins not called for each sample.
+  const std::vector<std::string> excluded = {"printdouble",       "printlndouble",
+                                             "printlnstr",        "mimium_addeventstream",
+                                             "mimium_idle",       "mimium_newarray",
+                                             "mimium_loaddata",   "mimium_loaddatasize"};
+  for (auto&& [name, info] : LLVMBuiltin::ftable) {
+    const auto& target = info.target_fnname;
+    if (target.empty() || target.rfind("libsndfile_", 0) == 0 ||
+        std::find(excluded.begin(), excluded.end(), target) != excluded.end()) {
+      continue;
+    }
+    EXPECT_TRUE(DspCostEstimator::hasCallCost(target)) << name << " " << target;
+  }
+  // helpers called by generated code.
+  for (const auto* name : {"mimium_oversample_up", "mimium_oversample_down",
+                           "mimium_recurrence1", "mimium_recurrence2"}) {
+    EXPECT_TRUE(DspCostEstimator::hasCallCost(name)) << name;
+  }
+}
+
+TEST(jit, cost_estimate_sizes) {  // NOLINT
+  // the cost of a builtin processing an array grows with the constant size.
+  auto estimate = [](int size) {
+    auto compiled = optimizeSource(R"(
+ir = newarray(4096)
+fn dsp(input:(float,float)){
+    l,r = input
+    return (convolve(l,ir,)" + std::to_string(size) +
+                                   R"(), r)
+}
+)");
+    auto report =
+        DspCostEstimator::estimate(*compiled.module, llvm::orc::MimiumJIT::getHostTargetMachine());
+    EXPECT_TRUE(report.has_value());
+    return report ? report->per_sample : 0.0;
+  };
+  const double small = estimate(64);
+  const double large = estimate(4096);
+  EXPECT_GT(small, 300.0);
+  EXPECT_GT(large - small, 100.0);
+}
+
+TEST(jit, cost_estimate_block) {  // NOLINT
+  auto& tm = llvm::orc::MimiumJIT::getHostTargetMachine();
+  auto estimate = [&](std::string const& source, int block_size) {
+    auto compiled = optimizeSource(source);
+    return DspCostEstimator::estimate(*compiled.module, tm, block_size).value();
+  };
+  const std::string sine = R"(
+fn dsp(input:(float,float)){
+    l,r = input
+    return (sin(l), r)
+}
+)";
+  auto serial = estimate(sine, 0);
+  auto block = estimate(sine, 64);
+  EXPECT_EQ(serial.block_size, 0);
+  EXPECT_EQ(serial.functions.front().name, "dsp");
+  EXPECT_EQ(block.block_size, 64);
+  EXPECT_EQ(block.functions.front().name, "dsp.block");
+  EXPECT_EQ(block.channels, 4);
+  // sin of vectors is counted for each lane, and the remainder loop does not run for 64 frames.
+  EXPECT_GT(block.per_sample, 35.0);
+  EXPECT_LT(block.per_sample, serial.per_sample + 17.5);
+  // the recurrence is evaluated by a call for the block.
+  auto lpf = estimate(R"(
+fn lpf(x,a){
+    return x*(1-a)+self*a
+}
+fn dsp(input:(float,float)){
+    l,r = input
+    return (lpf(l,0.9), r)
+}
+)",
+                      64);
+  EXPECT_GT(lpf.per_sample, 9.5);
+}
+
+TEST(jit, cost_check_message) {  // NOLINT
+  DspCostEstimator::Report report;
+  report.functions = {{"dsp", 80.0, 100.0}, {"lpf", 20.0, 20.0}};
+  report.per_sample = 100.0;
+  report.block_size = 64;
+  // 1% of 1000MHz at 48kHz is 208.3 cycles.
+  auto within = DspCostEstimator::check(report, CostBudget{0.01, 48000.0, 1000.0, false});
+  EXPECT_FALSE(within.exceeded);
+  EXPECT_NE(within.message.find("208.3 cycles"), std::string::npos) << within.message;
+  EXPECT_NE(within.message.find("blocks of 64 frames"), std::string::npos) << within.message;
+  EXPECT_NE(within.message.find("lpf: 20.0 cycles per call"), std::string::npos)
+      << within.message;
+  EXPECT_TRUE(DspCostEstimator::check(report, CostBudget{0.001, 48000.0, 1000.0, false}).exceeded);
+}
+
+TEST(jit, frame_loop_not_split_without_block) {  // NOLINT
+  // dsp depending on time is called sample by sample, and has no block function.
+  auto compiled = optimizeSource(R"(
+fn dsp(){
+    return (now,now)
+}
+)");
+  EXPECT_EQ(compiled.module->getFunction("dsp.block"), nullptr);
+  EXPECT_NE(compiled.module->getFunction("dsp"), nullptr);
+}
+
+}  // namespace mimium
@@ -0,0 +1,375 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// measures how the compile time of each stage scales with the size of synthetic programs along
+// the axes of program_generator.hpp, in milliseconds. the exponent of the fit of time against
+// size over the larger half of the sweep is printed for each stage, marked with "!" if
+// superlinear. with --fuzz, random programs mixing the axes are compiled and the ones whose
+// compile time or memory explodes are saved as regression cases. each of them is compiled in a
+// child process(except on windows, where the time and memory limits are not checked) so that its
+// peak memory is measured alone and a compile not finishing is killed.
+// usage: BenchCompile [--max n] [--repeat r] [--csv file]
+//        BenchCompile --emit <size|depth|closures|tuple> <n>
+//        BenchCompile --fuzz [count] [--seed s] [--max n] [--out dir] [--time-limit seconds]
+//                     [--mem-limit MiB]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include "offline_render.hpp"
+#include "program_generator.hpp"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <csignal>
+#endif
+
+namespace {
+
+constexpr std::array<const char*, 8> stage_names = {
+    "parse", "rename", "typeinfer", "mirgen", "closure", "memobjs", "codegen", "jit"};
+using StageTimes = std::array<double, stage_names.size()>;
+
+// exponents above this are reported as superlinear.
+constexpr double superlinear = 1.5;
+
+// compiles the source and runs one block, and returns milliseconds spent in each stage.
+StageTimes compile(std::string const& src) {
+  using clock = std::chrono::steady_clock;
+  StageTimes res{};
+  auto begin = clock::now();
+  auto lap = [&](size_t stage) {
+    const auto now = clock::now();
+    res[stage] = std::chrono::duration<double, std::milli>(now - begin).count();
+    begin = now;
+  };
+  auto engine = mimium::test::compileSource(src, "generated.mmm", true, lap);
+  mimium::test::RenderOptions opt;
+  opt.numblocks = 1;
+  opt.record = false;
+  mimium::test::render(std::move(engine), opt);
+  lap(mimium::test::compile_stages.size());
+  return res;
+}
+
+double getTotal(StageTimes const& times) {
+  double total = 0.0;
+  for (auto t : times) { total += t; }
+  return total;
+}
+
+#ifndef _WIN32
+// ru_maxrss in KiB.
+long toKiB(rusage const& usage) {
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+#endif
+
+struct Isolated {
+  enum class Status { Ok, Error, Timeout };
+  Status status = Status::Ok;
+  StageTimes times{};
+  std::string error;
+  // peak resident set size of the child in KiB, 0 if unknown.
+  long peak_rss = 0;
+};
+
+// compiles the source in a child process. ru_maxrss of a process only rises, so the peak memory
+// of an input is not told apart from the previous ones in the same process. the one of a child
+// counts only the pages it touched.
+Isolated compileIsolated(std::string const& src, double time_limit) {
+  Isolated res;
+#ifdef _WIN32
+  static_cast<void>(time_limit);
+  try {
+    res.times = compile(src);
+  } catch (std::exception& e) {
+    res.status = Isolated::Status::Error;
+    res.error = e.what();
+  }
+#else
+  std::array<int, 2> fds{};
+  if (pipe(fds.data()) != 0) { throw std::runtime_error("failed to create a pipe"); }
+  std::fflush(stdout);
+  const pid_t pid = fork();
+  if (pid < 0) { throw std::runtime_error("failed to fork"); }
+  if (pid == 0) {
+    // the result is written as a status byte, the times and the error message.
+    close(fds[0]);
+    char ok = 1;
+    StageTimes times{};
+    std::string message;
+    try {
+      times = compile(src);
+    } catch (std::exception& e) {
+      ok = 0;
+      message = e.what();
+    }
+    std::string out(1, ok);
+    out.append(reinterpret_cast<const char*>(times.data()), sizeof(times));
+    out.append(message);
+    for (size_t pos = 0; pos < out.size();) {
+      const auto n = write(fds[1], out.data() + pos, out.size() - pos);
+      if (n <= 0) { break; }
+      pos += n;
+    }
+    _exit(0);
+  }
+  close(fds[1]);
+  pollfd pfd{fds[0], POLLIN, 0};
+  std::string in;
+  if (poll(&pfd, 1, static_cast<int>(time_limit * 1000.0)) <= 0) {
+    kill(pid, SIGKILL);
+    res.status = Isolated::Status::Timeout;
+  } else {
+    std::array<char, 4096> buf{};
+    for (ssize_t n = 0; (n = read(fds[0], buf.data(), buf.size())) > 0;) {
+      in.append(buf.data(), n);
+    }
+  }
+  close(fds[0]);
+  int status = 0;
+  rusage usage{};
+  wait4(pid, &status, 0, &usage);
+  res.peak_rss = toKiB(usage);
+  if (res.status == Isolated::Status::Timeout) { return res; }
+  if (in.size() < 1 + sizeof(StageTimes)) {
+    res.status = Isolated::Status::Error;
+    res.error = WIFSIGNALED(status) ? "killed by signal " + std::to_string(WTERMSIG(status))
+                                    : "exited without a result";
+    return res;
+  }
+  std::memcpy(res.times.data(), in.data() + 1, sizeof(StageTimes));
+  if (in[0] == 0) {
+    res.status = Isolated::Status::Error;
+    res.error = in.substr(1 + sizeof(StageTimes));
+  }
+#endif
+  return res;
+}
+
+// slope of the least squares fit of log(y) against log(x).
+double fitExponent(std::vector<double> const& x, std::vector<double> const& y) {
+  double sx = 0.0;
+  double sy = 0.0;
+  double sxx = 0.0;
+  double sxy = 0.0;
+  const auto n = static_cast<double>(x.size());
+  for (size_t idx = 0; idx < x.size(); idx++) {
+    const double lx = std::log(x[idx]);
+    const double ly = std::log(std::max(y[idx], 1e-6));
+    sx += lx;
+    sy += ly;
+    sxx += lx * lx;
+    sxy += lx * ly;
+  }
+  const double denom = n * sxx - sx * sx;
+  return denom > 0.0 ? (n * sxy - sx * sy) / denom : 0.0;
+}
+
+struct Options {
+  int max = 256;
+  int repeat = 3;
+  std::string csv;
+  int count = 1000;
+  unsigned int seed = 0;
+  fs::path out = "test/regression/compile_time";
+  double time_limit = 10.0;
+  long mem_limit = 512;
+};
+
+int sweep(Options const& opt) {
+  std::ofstream csv;
+  if (!opt.csv.empty()) {
+    csv.open(opt.csv);
+    csv << "axis,n,bytes";
+    for (const auto* name : stage_names) { csv << "," << name; }
+    csv << ",total,peak_rss_kib\n";
+  }
+  for (auto axis : mimium::bench::all_axes) {
+    std::printf("%-8s %6s %8s", "axis", "n", "bytes");
+    for (const auto* name : stage_names) { std::printf(" %9s", name); }
+    std::printf(" %9s\n", "total");
+    std::vector<double> sizes;
+    std::vector<StageTimes> results;
+    for (int n = 1; n <= opt.max; n *= 2) {
+      const auto src = mimium::bench::generateProgram(axis, n);
+      StageTimes best{};
+      best.fill(std::numeric_limits<double>::max());
+      for (int count = 0; count < opt.repeat; count++) {
+        const auto times = compile(src);
+        for (size_t idx = 0; idx < best.size(); idx++) {
+          best[idx] = std::min(best[idx], times[idx]);
+        }
+      }
+      const auto name = mimium::bench::getAxisName(axis);
+      std::printf("%-8s %6d %8zu", name.data(), n, src.size());
+      for (auto t : best) { std::printf(" %9.3f", t); }
+      std::printf(" %9.3f\n", getTotal(best));
+      if (csv.is_open()) {
+        csv << name << "," << n << "," << src.size();
+        for (auto t : best) { csv << "," << t; }
+        const auto peak = compileIsolated(src, std::numeric_limits<int>::max() / 1000.0).peak_rss;
+        csv << "," << getTotal(best) << "," << peak << "\n";
+      }
+      sizes.emplace_back(n);
+      results.emplace_back(best);
+    }
+    // fixed costs dominate small programs.
+    const size_t from = sizes.size() / 2;
+    if (sizes.size() - from < 2) { continue; }
+    const std::vector<double> x(std::next(sizes.begin(), from), sizes.end());
+    std::printf("%-8s %6s %8s", "", "", "exponent");
+    for (size_t idx = 0; idx <= stage_names.size(); idx++) {
+      std::vector<double> y;
+      for (size_t pos = from; pos < results.size(); pos++) {
+        y.emplace_back(idx < stage_names.size() ? results[pos][idx] : getTotal(results[pos]));
+      }
+      const double e = fitExponent(x, y);
+      std::printf(" %8.2f%s", e, e > superlinear ? "!" : " ");
+    }
+    std::printf("\n\n");
+  }
+  return 0;
+}
+
+void saveCase(fs::path const& dir, std::string const& src, std::string const& reason,
+              std::string const& message) {
+  fs::create_directories(dir);
+  char hash[17];
+  std::snprintf(hash, sizeof(hash), "%016zx", std::hash<std::string>{}(src));
+  const auto path = dir / (reason + "-" + hash + ".mmm");
+  std::ofstream(path) << "// " << message << "\n" << src;
+  std::printf("flagged %s: %s\n", path.string().c_str(), message.c_str());
+}
+
+double getMedian(std::vector<double> values) {
+  auto mid = std::next(values.begin(), values.size() / 2);
+  std::nth_element(values.begin(), mid, values.end());
+  return *mid;
+}
+
+int fuzz(Options const& opt) {
+  // cost per byte of a stage above this times the median so far is flagged.
+  constexpr double cost_factor = 20.0;
+  // number of inputs before the median is trusted.
+  constexpr size_t warmup = 16;
+  // stages faster than this are not flagged, as timer noise dominates.
+  constexpr double noise_ms = 1.0;
+  std::mt19937 rng(opt.seed);
+  std::array<std::vector<double>, stage_names.size()> costs;
+  int flagged = 0;
+  for (int count = 0; count < opt.count; count++) {
+    const auto src = mimium::bench::generateRandomProgram(rng, opt.max);
+    const auto result = compileIsolated(src, opt.time_limit);
+    if (result.status == Isolated::Status::Timeout) {
+      saveCase(opt.out, src, "timeout",
+               "compile did not finish in " + std::to_string(opt.time_limit) + " s");
+      flagged++;
+      continue;
+    }
+    if (result.status == Isolated::Status::Error) {
+      saveCase(opt.out, src, "error", "compile failed: " + result.error);
+      flagged++;
+      continue;
+    }
+    const auto& times = result.times;
+    const long peak = result.peak_rss / 1024;
+    if (peak > opt.mem_limit) {
+      saveCase(opt.out, src, "memory", "peak memory was " + std::to_string(peak) + " MiB");
+      flagged++;
+      continue;
+    }
+    bool exploded = false;
+    for (size_t idx = 0; idx < stage_names.size() && !exploded; idx++) {
+      const double cost = times[idx] / static_cast<double>(src.size());
+      if (costs[idx].size() >= warmup && times[idx] > noise_ms) {
+        const double ratio = cost / getMedian(costs[idx]);
+        if (ratio > cost_factor) {
+          saveCase(opt.out, src, stage_names[idx],
+                   std::string(stage_names[idx]) + " took " + std::to_string(times[idx]) +
+                       " ms for " + std::to_string(src.size()) + " bytes, " +
+                       std::to_string(ratio) + " times the median per byte");
+          exploded = true;
+        }
+      }
+    }
+    if (exploded) {
+      flagged++;
+      continue;
+    }
+    for (size_t idx = 0; idx < stage_names.size(); idx++) {
+      costs[idx].emplace_back(times[idx] / static_cast<double>(src.size()));
+    }
+  }
+  std::printf("%d inputs, %d flagged\n", opt.count, flagged);
+  return flagged > 0 ? 1 : 0;
+}
+
+int emit(std::string_view axisname, int n) {
+  for (auto axis : mimium::bench::all_axes) {
+    if (mimium::bench::getAxisName(axis) == axisname) {
+      std::cout << mimium::bench::generateProgram(axis, n);
+      return 0;
+    }
+  }
+  std::cerr << "unknown axis " << axisname << std::endl;
+  return 1;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  Options opt;
+  bool fuzzmode = false;
+  const std::vector<std::string_view> args(std::next(argv), std::next(argv, argc));
+  auto next = [&](size_t& idx) -> std::string {
+    if (idx + 1 >= args.size()) {
+      std::cerr << "missing value for " << args[idx] << std::endl;
+      std::exit(1);
+    }
+    return std::string(args[++idx]);
+  };
+  for (size_t idx = 0; idx < args.size(); idx++) {
+    const auto arg = args[idx];
+    if (arg == "--emit") {
+      const auto axis = next(idx);
+      return emit(axis, std::stoi(next(idx)));
+    }
+    if (arg == "--fuzz") {
+      fuzzmode = true;
+      if (idx + 1 < args.size() && args[idx + 1].substr(0, 2) != "--") {
+        opt.count = std::stoi(next(idx));
+      }
+    } else if (arg == "--max") {
+      opt.max = std::stoi(next(idx));
+    } else if (arg == "--repeat") {
+      opt.repeat = std::stoi(next(idx));
+    } else if (arg == "--csv") {
+      opt.csv = next(idx);
+    } else if (arg == "--seed") {
+      opt.seed = static_cast<unsigned int>(std::stoul(next(idx)));
+    } else if (arg == "--out") {
+      opt.out = next(idx);
+    } else if (arg == "--time-limit") {
+      opt.time_limit = std::stod(next(idx));
+    } else if (arg == "--mem-limit") {
+      opt.mem_limit = std::stol(next(idx));
+    } else {
+      std::cerr << "unknown option " << arg << std::endl;
+      return 1;
+    }
+  }
+  return fuzzmode ? fuzz(opt) : sweep(opt);
+}
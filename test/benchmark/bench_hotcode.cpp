@@ -0,0 +1,45 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// measures the cost of dsp of patches with the code of dsp placed among other code, in a separate
+// region, and in a separate region on locked huge pages, in nanoseconds per sample. caches are
+// evicted between blocks as in a process doing other work between audio callbacks.
+// usage: BenchHotCode [patch.mmm ...] (default: examples/demo.mmm examples/spectralgate.mmm)
+
+#include <cstdio>
+#include "offline_render.hpp"
+
+namespace {
+
+struct Layout {
+  bool separate;
+  bool huge_pages;
+};
+
+double run(fs::path const& path, Layout layout) {
+  auto engine = mimium::test::compileFile(path);
+  engine->setHotCodeOptions(layout.separate, layout.huge_pages, layout.huge_pages);
+  mimium::test::RenderOptions opt;
+  // 10 seconds at 48kHz, with 8MiB written between blocks
+  opt.numblocks = 48000 * 10 / 256;
+  opt.record = false;
+  opt.evict_bytes = 8 * 1024 * 1024;
+  return mimium::test::render(std::move(engine), opt).elapsed;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  std::vector<fs::path> patches = {"examples/demo.mmm", "examples/spectralgate.mmm"};
+  if (argc > 1) { patches.assign(std::next(argv), std::next(argv, argc)); }
+  std::printf("%-32s %12s %12s %12s\n", "patch", "mixed", "hot", "hot+huge");
+  for (auto&& path : patches) {
+    const double mixed = run(path, {false, false});
+    const double hot = run(path, {true, false});
+    const double huge = run(path, {true, true});
+    std::printf("%-32s %9.2f ns %9.2f ns %9.2f ns\n", path.filename().string().c_str(), mixed,
+                hot, huge);
+  }
+  return 0;
+}
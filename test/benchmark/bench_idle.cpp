@@ -0,0 +1,62 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// measures the cost of decaying voices triggered once a second at different times, with and
+// without idle(), in nanoseconds per sample. each voice is asleep for about 70% of the time.
+// usage: BenchIdle [voices ...] (default: 8 32 128)
+
+#include <cstdio>
+#include <sstream>
+#include "offline_render.hpp"
+
+namespace {
+
+std::string makePatch(int voices, bool idle) {
+  std::ostringstream ss;
+  ss << "fn voice(trig,freq){\n";
+  if (idle) { ss << "    idle(0.0001,4800)\n"; }
+  ss << "    env = max(trig, self*0.999)\n"
+     << "    return sin(now*freq*2*3.141595/48000)*env\n"
+     << "}\n"
+     << "fn pulse(period,offset){\n"
+     << "    return if((now+offset)%period < 1) 1 else 0\n"
+     << "}\n"
+     << "fn dsp(){\n"
+     << "    r = 0";
+  for (int i = 0; i < voices; i++) {
+    ss << "+voice(pulse(48000," << i * 48000 / voices << ")," << 110 + i * 10 << ")";
+  }
+  ss << "\n    out = r*0.01\n"
+     << "    return (out,out)\n"
+     << "}\n";
+  return ss.str();
+}
+
+double run(int voices, bool idle) {
+  // 10 seconds at 48kHz
+  auto driver = std::make_unique<mimium::AudioDriverOffline>(48000 * 10 / 256, 256);
+  auto& driver_ref = *driver;
+  mimium::Runtime runtime(std::move(driver),
+                          mimium::test::compileSource(makePatch(voices, idle), "bench_idle.mmm"));
+  runtime.runMainFun();
+  runtime.start();
+  return driver_ref.getElapsed();
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  std::vector<int> voices = {8, 32, 128};
+  if (argc > 1) {
+    voices.clear();
+    for (int i = 1; i < argc; i++) { voices.push_back(std::atoi(argv[i])); }
+  }
+  std::printf("%8s %12s %12s %8s\n", "voices", "awake", "idle", "saved");
+  for (int n : voices) {
+    const double awake = run(n, false);
+    const double idle = run(n, true);
+    std::printf("%8d %9.2f ns %9.2f ns %7.1f%%\n", n, awake, idle, 100.0 * (1.0 - idle / awake));
+  }
+  return 0;
+}
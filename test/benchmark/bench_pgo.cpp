@@ -0,0 +1,43 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// measures the cost of dsp of patches compiled with and without the profile of an instrumented
+// run, in nanoseconds per sample.
+// usage: BenchPgo [patch.mmm ...] (default: examples/adsr.mmm examples/lpf.mmm)
+
+#include <cstdio>
+#include "offline_render.hpp"
+
+namespace {
+
+enum class Mode { Plain, Generate, Use };
+
+double run(fs::path const& path, Mode mode, std::string const& profile) {
+  auto engine = mimium::test::compileFile(path);
+  if (mode == Mode::Generate) { engine->setProfileOutput(profile); }
+  if (mode == Mode::Use) { engine->setProfileInput(profile); }
+  mimium::test::RenderOptions opt;
+  // 10 seconds at 48kHz
+  opt.numblocks = 48000 * 10 / 256;
+  opt.record = false;
+  return mimium::test::render(std::move(engine), opt).elapsed;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  std::vector<fs::path> patches = {"examples/adsr.mmm", "examples/lpf.mmm"};
+  if (argc > 1) { patches.assign(std::next(argv), std::next(argv, argc)); }
+  const std::string profile = (fs::temp_directory_path() / "mimium_bench_pgo.prof").string();
+  std::printf("%-32s %12s %12s %8s\n", "patch", "plain", "profiled", "gain");
+  for (auto&& path : patches) {
+    const double plain = run(path, Mode::Plain, profile);
+    run(path, Mode::Generate, profile);
+    const double profiled = run(path, Mode::Use, profile);
+    std::printf("%-32s %9.2f ns %9.2f ns %7.1f%%\n", path.filename().string().c_str(), plain,
+                profiled, (plain / profiled - 1.0) * 100.0);
+  }
+  fs::remove(profile);
+  return 0;
+}
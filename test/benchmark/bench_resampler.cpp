@@ -0,0 +1,52 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// measures the cost of the resampler for each quality preset, in nanoseconds per output sample.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include "compiler/builtin/resampler.hpp"
+
+using namespace mimium::builtin;  // NOLINT
+
+template <typename F>
+double measure(size_t num_samples, F&& fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / num_samples;
+}
+
+int main() {
+  const size_t size = 48000 * 10;
+  mimium::AlignedVector<double> src(size);
+  for (size_t i = 0; i < size; i++) { src[i] = std::sin(0.01 * i); }
+  const char* names[] = {"fast", "medium", "high", "best"};
+  volatile double sink = 0.0;
+  std::printf("%-8s %12s %12s %12s\n", "quality", "read(1.0)", "read(2.5)", "44.1k->48k");
+  for (int q = 0; q < 4; q++) {
+    auto quality = static_cast<ResampleQuality>(q);
+    const auto& kernel = SincKernel::get(quality);
+    const size_t n = size / 4;
+    double normal = measure(n, [&] {
+      double acc = 0.0;
+      for (size_t i = 0; i < n; i++) { acc += kernel.read(src.data(), size, i * 1.37, 1.0); }
+      sink = acc;
+    });
+    double stretched = measure(n, [&] {
+      double acc = 0.0;
+      for (size_t i = 0; i < n; i++) { acc += kernel.read(src.data(), size, i * 2.5, 2.5); }
+      sink = acc;
+    });
+    const double ratio = 48000.0 / 44100.0;
+    double offline = measure(getResampledSize(size, ratio), [&] {
+      auto res = resample(src.data(), size, 1, ratio, quality);
+      sink = res[0];
+    });
+    std::printf("%-8s %9.2f ns %9.2f ns %9.2f ns\n", names[q], normal, stretched, offline);
+  }
+  (void)sink;
+  return 0;
+}
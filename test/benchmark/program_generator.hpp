@@ -0,0 +1,133 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mimium::bench {
+
+// generator of synthetic programs to measure how the compile time scales. a program of an axis
+// with the size n grows in that direction only, so that the cost of each stage can be plotted
+// against n.
+enum class Axis {
+  // number of functions, each calling the previous one and having a feedback.
+  Size,
+  // nesting depth of if statements in one function.
+  Depth,
+  // number of distinct closures, each capturing a global variable of its own. closures defined in
+  // functions are not generated, as the closure conversion does not support them yet.
+  Closures,
+  // width of a tuple constructed and destructured in one function.
+  TupleWidth
+};
+
+constexpr std::array<Axis, 4> all_axes = {Axis::Size, Axis::Depth, Axis::Closures,
+                                          Axis::TupleWidth};
+
+inline std::string_view getAxisName(Axis axis) {
+  switch (axis) {
+    case Axis::Size: return "size";
+    case Axis::Depth: return "depth";
+    case Axis::Closures: return "closures";
+    case Axis::TupleWidth: return "tuple";
+  }
+  return "";
+}
+
+namespace detail {
+
+// writes the definitions of a fragment of the axis to out, and returns an expression of float
+// using them. names in the fragment start with prefix.
+inline std::string writeFragment(std::ostream& out, Axis axis, int n, std::string const& prefix) {
+  switch (axis) {
+    case Axis::Size: {
+      out << "fn " << prefix << "0(x){\n    return x*0.5+self*0.25\n}\n";
+      for (int idx = 1; idx < n; idx++) {
+        out << "fn " << prefix << idx << "(x){\n    y = " << prefix << idx - 1
+            << "(x)*0.5\n    return y+self*0.25\n}\n";
+      }
+      return prefix + std::to_string(n - 1) + "(1.0)";
+    }
+    case Axis::Depth: {
+      // indentation is not deepened to keep the source linear in n.
+      out << "fn " << prefix << "(x){\n    res = 0\n";
+      for (int idx = 0; idx < n; idx++) { out << "    if(x>" << idx << "){\n    res = res+1\n"; }
+      for (int idx = 0; idx < n; idx++) { out << "    }else{\n    res = res-1\n    }\n"; }
+      out << "    return res\n}\n";
+      return prefix + "(1.0)";
+    }
+    case Axis::Closures: {
+      for (int idx = 0; idx < n; idx++) {
+        out << prefix << "k" << idx << " = " << idx << "\n"
+            << prefix << idx << " = |x|{ x*" << prefix << "k" << idx << "+" << idx << " }\n";
+      }
+      out << "fn " << prefix << "sum(x){\n    acc0 = " << prefix << "0(x)\n";
+      for (int idx = 1; idx < n; idx++) {
+        out << "    acc" << idx << " = acc" << idx - 1 << "+" << prefix << idx << "(x)\n";
+      }
+      out << "    return acc" << n - 1 << "\n}\n";
+      return prefix + "sum(1.0)";
+    }
+    case Axis::TupleWidth: {
+      // a tuple has at least 2 elements.
+      const int width = std::max(n, 2);
+      out << "fn " << prefix << "(x){\n    t = (";
+      for (int idx = 0; idx < width; idx++) { out << (idx > 0 ? "," : "") << "x+" << idx; }
+      out << ")\n    ";
+      for (int idx = 0; idx < width; idx++) { out << (idx > 0 ? "," : "") << "v" << idx; }
+      out << " = t\n    return ";
+      for (int idx = 0; idx < width; idx++) { out << (idx > 0 ? "+" : "") << "v" << idx; }
+      out << "\n}\n";
+      return prefix + "(1.0)";
+    }
+  }
+  return "0";
+}
+
+// dsp returns the sum of the expressions to both channels.
+inline void writeDsp(std::ostream& out, std::vector<std::string> const& exprs) {
+  out << "fn dsp(){\n    out = ";
+  for (size_t idx = 0; idx < exprs.size(); idx++) { out << (idx > 0 ? "+" : "") << exprs[idx]; }
+  out << "\n    return (out,out)\n}\n";
+}
+
+}  // namespace detail
+
+// a program of the axis with the size n (n >= 1).
+inline std::string generateProgram(Axis axis, int n) {
+  std::ostringstream out;
+  out << "// " << getAxisName(axis) << " " << n << "\n";
+  const auto expr = detail::writeFragment(out, axis, std::max(n, 1), "g");
+  detail::writeDsp(out, {expr});
+  return out.str();
+}
+
+// a program mixing fragments of random axes with random sizes up to maxsize, for fuzzing.
+inline std::string generateRandomProgram(std::mt19937& rng, int maxsize) {
+  std::ostringstream out;
+  std::uniform_int_distribution<int> numfragments(1, 4);
+  std::uniform_int_distribution<size_t> axisdist(0, all_axes.size() - 1);
+  // sizes are log-uniform so that small and large fragments appear as often.
+  std::uniform_real_distribution<double> logsize(0.0, std::log2(std::max(maxsize, 1)));
+  std::vector<std::string> exprs;
+  const int count = numfragments(rng);
+  for (int idx = 0; idx < count; idx++) {
+    const auto axis = all_axes[axisdist(rng)];
+    const int n = static_cast<int>(std::exp2(logsize(rng)));
+    out << "// " << getAxisName(axis) << " " << n << "\n";
+    exprs.emplace_back(detail::writeFragment(out, axis, n, "g" + std::to_string(idx) + "_"));
+  }
+  detail::writeDsp(out, exprs);
+  return out.str();
+}
+
+}  // namespace mimium::bench
@@ -1,5 +1,8 @@
 #include "compiler/compiler.hpp"
-#include "runtime/JIT/runtime_jit.hpp"
+
+// inputs taking longer than -timeout or more memory than -rss_limit_mb are saved by libfuzzer as
+// timeout-* and oom-* artifacts. copy them to test/regression/compile_time to keep them as
+// regression cases.
 
 extern "C" int LLVMFuzzerTestOneInput(std::uint8_t const* data, std::size_t size) {
   std::string src((char*)data, size);
@@ -18,10 +21,6 @@ extern "C" int LLVMFuzzerTestOneInput(std::uint8_t const* data, std::size_t size
       auto memobjs = compiler->collectMemoryObjs(mircc);
       auto& llvmir = compiler->generateLLVMIr(mircc,memobjs);
     }
-    auto module  = compiler->moveLLVMModule();
-    auto ctx = compiler->moveLLVMCtx();
-    auto runtime = std::make_unique<mimium::Runtime_LLVM>(std::move(ctx));
-    module->setDataLayout(runtime->getJitEngine().getDataLayout());
   } catch (std::runtime_error& e) {
     // std::cerr << e.what() << std::endl;
   }
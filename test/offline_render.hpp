@@ -0,0 +1,100 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <array>
+#include <functional>
+#include "compiler/codegen/llvm_header.hpp"
+#include "libmimium.hpp"
+#include "runtime/backend/offline/driver_offline.hpp"
+
+// helpers for tests and benchmarks to compile programs in the process and render them with
+// AudioDriverOffline.
+
+namespace mimium::test {
+
+constexpr std::array<const char*, 7> compile_stages = {
+    "parse", "rename", "typeinfer", "mirgen", "closure", "memobjs", "codegen"};
+
+// compiles the source into a jit engine as the cli does, calling on_stage with the index of
+// compile_stages after each stage. the static memory report is copied to `report` if given.
+inline std::unique_ptr<LLVMJitExecutionEngine> compileSource(
+    std::string const& source, fs::path const& path, bool optimize = true,
+    std::function<void(size_t)> const& on_stage = nullptr, MemoryReport* report = nullptr) {
+  size_t stage = 0;
+  auto lap = [&]() {
+    if (on_stage) { on_stage(stage); }
+    stage++;
+  };
+  Compiler compiler;
+  compiler.setFilePath(fs::absolute(path).string());
+  auto ast = compiler.loadSource(source);
+  lap();
+  auto ast_u = compiler.renameSymbols(ast);
+  lap();
+  compiler.typeInfer(ast_u);
+  lap();
+  auto mir = compiler.generateMir(ast_u);
+  lap();
+  auto mir_cc = compiler.closureConvert(mir);
+  lap();
+  auto funobjs = compiler.collectMemoryObjs(mir_cc);
+  lap();
+  compiler.generateLLVMIr(mir_cc, funobjs);
+  lap();
+  if (report != nullptr) { *report = compiler.getMemoryReport(); }
+  return std::make_unique<LLVMJitExecutionEngine>(compiler.moveLLVMCtx(),
+                                                  compiler.moveLLVMModule(), path.string(),
+                                                  optimize);
+}
+
+// includes are searched from the current directory, as the cli does.
+inline std::unique_ptr<LLVMJitExecutionEngine> compileFile(fs::path const& path,
+                                                           bool optimize = true) {
+  Preprocessor preprocessor(fs::current_path());
+  return compileSource(preprocessor.process(path).source, path, optimize);
+}
+
+struct RenderOptions {
+  int numblocks = 16;
+  int framesize = 256;
+  double samplerate = 48000;
+  // input is silence if not set.
+  std::optional<unsigned int> noise_seed = std::nullopt;
+  // number of output channels of the device, the one of dsp if 0.
+  int device_outs = 0;
+  // false to call dsp sample by sample instead of dsp.block.
+  bool block = true;
+  // false not to keep the output, e.g. for benchmarks.
+  bool record = true;
+  // bytes written between blocks to evict caches(see AudioDriverOffline::setEvictBytes).
+  size_t evict_bytes = 0;
+};
+
+struct Rendered {
+  // interleaved output of all blocks.
+  std::vector<double> samples;
+  int channels = 0;
+  // nanoseconds per sample, excluding the first block.
+  double elapsed = 0.0;
+};
+
+// runs mimium_main and renders the dsp.
+inline Rendered render(std::unique_ptr<LLVMJitExecutionEngine> engine,
+                       RenderOptions const& opt = {}) {
+  auto driver = std::make_unique<AudioDriverOffline>(opt.numblocks, opt.framesize, opt.samplerate);
+  if (opt.noise_seed) { driver->setNoiseInput(opt.noise_seed.value()); }
+  driver->setRecordOutput(opt.record);
+  driver->setEvictBytes(opt.evict_bytes);
+  if (opt.device_outs > 0) { driver->setDeviceChannels(0, opt.device_outs); }
+  driver->setBlockProcessing(opt.block);
+  auto& driver_ref = *driver;
+  Runtime runtime(std::move(driver), std::move(engine));
+  runtime.runMainFun();
+  runtime.start();
+  return Rendered{driver_ref.getRecordedOutput(), driver_ref.getNumOutputs(),
+                  driver_ref.getElapsed()};
+}
+
+}  // namespace mimium::test
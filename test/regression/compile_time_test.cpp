@@ -0,0 +1,110 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include "benchmark/program_generator.hpp"
+#include "offline_render.hpp"
+
+#include "gtest/gtest.h"
+
+// compile-time regression test. programs of each axis of test/benchmark/program_generator.hpp
+// are generated in two sizes and compiled up to llvm ir, and the compile time has to grow
+// no faster than n^max_exponent between them, which does not depend on the speed of the machine.
+// the larger one is also run for a block.
+// inputs saved by "BenchCompile --fuzz" in test/regression/compile_time are compiled and run too,
+// and their compile time per byte is compared with the one of a generated program.
+
+#ifndef COMPILE_TIME_DIR
+#define COMPILE_TIME_DIR ""
+#endif
+
+namespace {
+
+using mimium::bench::Axis;
+
+constexpr int small_size = 64;
+constexpr int large_size = 256;
+// the stages are close to linear. a stage going quadratic exceeds it by far.
+constexpr double max_exponent = 1.5;
+// saved inputs may be this many times slower per byte than a generated program.
+constexpr double max_cost_factor = 20.0;
+// the best of the runs is taken against noise.
+constexpr int num_runs = 3;
+
+// milliseconds to compile the source up to llvm ir.
+double measureCompile(std::string const& src) {
+  using clock = std::chrono::steady_clock;
+  double best = std::numeric_limits<double>::max();
+  for (int run = 0; run < num_runs; run++) {
+    const auto begin = clock::now();
+    double elapsed = 0.0;
+    mimium::test::compileSource(src, "generated.mmm", false, [&](size_t stage) {
+      if (stage + 1 == mimium::test::compile_stages.size()) {
+        elapsed = std::chrono::duration<double, std::milli>(clock::now() - begin).count();
+      }
+    });
+    best = std::min(best, elapsed);
+  }
+  return best;
+}
+
+// runs mimium_main and a block of dsp, whose output has to be finite.
+void expectRuns(std::string const& src, std::string const& name) {
+  mimium::test::RenderOptions opt;
+  opt.numblocks = 1;
+  const auto rendered = mimium::test::render(mimium::test::compileSource(src, name + ".mmm"), opt);
+  ASSERT_FALSE(rendered.samples.empty()) << name;
+  for (auto s : rendered.samples) { ASSERT_TRUE(std::isfinite(s)) << name; }
+}
+
+std::vector<fs::path> listSavedCases() {
+  std::vector<fs::path> res;
+  if (!fs::is_directory(COMPILE_TIME_DIR)) { return res; }
+  for (auto&& entry : fs::directory_iterator(COMPILE_TIME_DIR)) {
+    if (entry.path().extension() == ".mmm") { res.emplace_back(entry.path()); }
+  }
+  std::sort(res.begin(), res.end());
+  return res;
+}
+
+}  // namespace
+
+class CompileTime : public testing::TestWithParam<Axis> {};
+
+TEST_P(CompileTime, scalesAndRuns) {  // NOLINT
+  const auto small = measureCompile(mimium::bench::generateProgram(GetParam(), small_size));
+  const auto src = mimium::bench::generateProgram(GetParam(), large_size);
+  const auto large = measureCompile(src);
+  const double exponent = std::log(large / small) / std::log(double(large_size) / small_size);
+  EXPECT_LE(exponent, max_exponent) << small << " ms for " << small_size << ", " << large
+                                    << " ms for " << large_size;
+  expectRuns(src, std::string(mimium::bench::getAxisName(GetParam())));
+}
+
+INSTANTIATE_TEST_SUITE_P(regression, CompileTime,  // NOLINT
+                         testing::ValuesIn(mimium::bench::all_axes),
+                         [](const auto& info) {
+                           return std::string(mimium::bench::getAxisName(info.param));
+                         });
+
+TEST(CompileTimeSaved, withinCostOfGenerated) {  // NOLINT
+  const auto cases = listSavedCases();
+  if (cases.empty()) { return; }
+  const auto reference = mimium::bench::generateProgram(Axis::Size, large_size);
+  const double cost = measureCompile(reference) / static_cast<double>(reference.size());
+  for (auto const& path : cases) {
+    std::ostringstream src;
+    src << std::ifstream(path).rdbuf();
+    const auto name = path.stem().string();
+    const double elapsed = measureCompile(src.str());
+    EXPECT_LE(elapsed / static_cast<double>(src.str().size()), cost * max_cost_factor)
+        << name << " took " << elapsed << " ms to compile";
+    expectRuns(src.str(), name);
+  }
+}
@@ -0,0 +1,203 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <cmath>
+#include <cstdlib>
+#include <future>
+#include <map>
+#include "compiler/builtin/oversampler.hpp"
+#include "offline_render.hpp"
+#include "sndfile.h"
+
+#include "gtest/gtest.h"
+#include "gtest/internal/gtest-port.h"
+
+// golden-audio regression test. each patch in test/regression/golden is compiled in this process
+// with and without optimization, and rendered for a fixed number of frames with noise as the
+// input. the output is compared with the reference "<name>.wav" next to the patch, and a missing
+// reference is a failure. patches are rendered concurrently before the tests are checked.
+// to write the references from the unoptimized output, run with MIMIUM_UPDATE_GOLDEN=1.
+
+#ifndef GOLDEN_DIR
+#define GOLDEN_DIR ""
+#endif
+
+namespace {
+
+using mimium::test::Rendered;
+
+constexpr int num_blocks = 16;
+constexpr int frame_size = 256;
+constexpr int sample_rate = 48000;
+constexpr unsigned int noise_seed = 1234;
+// fast-math and vectorization change the order of operations.
+constexpr double tolerance = 1e-6;
+
+bool isUpdateMode() {
+  const char* env = std::getenv("MIMIUM_UPDATE_GOLDEN");
+  return env != nullptr && std::string(env) == "1";
+}
+
+// device_outs is the number of output channels of the device, the one of dsp if 0.
+mimium::test::RenderOptions getOptions(int device_outs = 0) {
+  mimium::test::RenderOptions opt;
+  opt.numblocks = num_blocks;
+  opt.framesize = frame_size;
+  opt.samplerate = sample_rate;
+  opt.noise_seed = noise_seed;
+  opt.device_outs = device_outs;
+  return opt;
+}
+
+Rendered render(fs::path const& path, bool optimize) {
+  return mimium::test::render(mimium::test::compileFile(path, optimize), getOptions());
+}
+
+std::optional<Rendered> readReference(fs::path const& path) {
+  SF_INFO info{};
+  auto* file = sf_open(path.string().c_str(), SFM_READ, &info);
+  if (file == nullptr) { return std::nullopt; }
+  Rendered res;
+  res.channels = info.channels;
+  res.samples.resize(info.frames * info.channels);
+  sf_readf_double(file, res.samples.data(), info.frames);
+  sf_close(file);
+  return res;
+}
+
+void writeAudio(fs::path const& path, Rendered const& audio) {
+  SF_INFO info{};
+  info.samplerate = sample_rate;
+  info.channels = audio.channels;
+  info.format = SF_FORMAT_WAV | SF_FORMAT_DOUBLE;
+  auto* file = sf_open(path.string().c_str(), SFM_WRITE, &info);
+  ASSERT_NE(file, nullptr) << "failed to write " << path << " : " << sf_strerror(nullptr);
+  sf_writef_double(file, audio.samples.data(),
+                   static_cast<sf_count_t>(audio.samples.size() / audio.channels));
+  sf_close(file);
+}
+
+}  // namespace
+
+// test names are "<mode>/<patch>".
+class GoldenAudio : public testing::TestWithParam<std::string> {
+ public:
+  static void SetUpTestSuite() {
+    const auto* suite = testing::UnitTest::GetInstance()->current_test_suite();
+    for (int idx = 0; idx < suite->total_test_count(); idx++) {
+      const auto* info = suite->GetTestInfo(idx);
+      if (!info->should_run()) { continue; }
+      const std::string name = info->name();
+      const auto slash = name.find('/');
+      const bool optimize = name.substr(0, slash) == "optimized";
+      const fs::path patch = fs::path(GOLDEN_DIR) / (name.substr(slash + 1) + ".mmm");
+      renders.emplace(name, std::async(std::launch::async, render, patch, optimize).share());
+    }
+  }
+  static void TearDownTestSuite() { renders.clear(); }
+
+ protected:
+  static Rendered getRendered() {
+    const auto* info = testing::UnitTest::GetInstance()->current_test_info();
+    return renders.at(info->name()).get();
+  }
+  static fs::path getReferencePath() { return fs::path(GOLDEN_DIR) / (GetParam() + ".wav"); }
+  static void check(Rendered const& actual) {
+    auto reference = readReference(getReferencePath());
+    ASSERT_TRUE(reference) << "no reference " << getReferencePath()
+                           << ", run with MIMIUM_UPDATE_GOLDEN=1 to write it";
+    ASSERT_EQ(actual.channels, reference->channels);
+    ASSERT_EQ(actual.samples.size(), reference->samples.size());
+    double maxerror = 0.0;
+    size_t maxidx = 0;
+    for (size_t idx = 0; idx < actual.samples.size(); idx++) {
+      const double error = std::abs(actual.samples[idx] - reference->samples[idx]);
+      // nan is treated as the largest error.
+      if (!(error <= maxerror)) {
+        maxerror = error;
+        maxidx = idx;
+      }
+    }
+    if (maxerror > tolerance) {
+      // written to the working directory to be compared by ear or in an editor.
+      writeAudio(GetParam() + ".actual.wav", actual);
+      FAIL() << "max error " << maxerror << " at frame " << maxidx / actual.channels
+             << ", channel " << maxidx % actual.channels << ": expected "
+             << reference->samples[maxidx] << ", actual " << actual.samples[maxidx];
+    }
+  }
+
+ private:
+  inline static std::map<std::string, std::shared_future<Rendered>> renders;
+};
+
+TEST_P(GoldenAudio, unoptimized) {  // NOLINT
+  auto actual = getRendered();
+  if (isUpdateMode()) {
+    writeAudio(getReferencePath(), actual);
+    GTEST_SKIP() << "reference written to " << getReferencePath();
+  }
+  check(actual);
+}
+
+TEST_P(GoldenAudio, optimized) {  // NOLINT
+  check(getRendered());
+}
+
+INSTANTIATE_TEST_SUITE_P(regression, GoldenAudio,  // NOLINT
+                         testing::Values("filter", "delay", "oscillators", "multichannel",
+                                         "stereo"),
+                         [](const auto& info) { return info.param; });
+
+// the oscillators are delayed by the latency of oversample to be aligned with the oversampled
+// waveshaper, which would be baked into the reference otherwise unnoticed.
+TEST(GoldenLatency, oscillators) {  // NOLINT
+  const auto actual = render(fs::path(GOLDEN_DIR) / "oscillators.mmm", true);
+  ASSERT_EQ(actual.channels, 2);
+  constexpr size_t latency = mimium::builtin::Oversampler::latency;
+  for (size_t frame = 0; frame < latency; frame++) {
+    ASSERT_EQ(actual.samples[frame * 2], 0.0) << "frame " << frame;
+  }
+  EXPECT_NE(actual.samples[(latency + 1) * 2], 0.0);
+}
+
+// dsp returning an array has a channel per element, interleaved frame by frame. the frames are
+// padded with silence for a device with more channels and truncated for one with less.
+constexpr std::string_view multichannel_source = R"(
+fn dsp(){
+    return [now,now+10000,now+20000,now+30000]
+}
+)";
+
+class MultiChannel : public testing::TestWithParam<std::tuple<int, bool>> {};
+
+TEST_P(MultiChannel, interleave) {  // NOLINT
+  const auto [device_outs, optimize] = GetParam();
+  constexpr int dsp_outs = 4;
+  auto actual = mimium::test::render(
+      mimium::test::compileSource(std::string(multichannel_source), "multichannel.mmm", optimize),
+      getOptions(device_outs));
+  const int outs = device_outs > 0 ? device_outs : dsp_outs;
+  ASSERT_EQ(actual.channels, outs);
+  ASSERT_EQ(actual.samples.size(), static_cast<size_t>(num_blocks * frame_size * outs));
+  for (int frame = 0; frame < num_blocks * frame_size; frame++) {
+    // now is counted up before each sample.
+    const double now = frame + 1;
+    for (int ch = 0; ch < outs; ch++) {
+      const double expected = ch < dsp_outs ? now + ch * 10000.0 : 0.0;
+      ASSERT_EQ(actual.samples[frame * outs + ch], expected)
+          << "frame " << frame << ", channel " << ch;
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(regression, MultiChannel,  // NOLINT
+                         testing::Combine(testing::Values(0, 6, 2), testing::Bool()),
+                         [](const auto& info) {
+                           const int outs = std::get<0>(info.param);
+                           const std::string device =
+                               outs > 0 ? "device" + std::to_string(outs) : "dsp";
+                           return device +
+                                  (std::get<1>(info.param) ? "_optimized" : "_unoptimized");
+                         });
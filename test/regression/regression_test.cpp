@@ -77,6 +77,9 @@ REGRESSION(array_capture, "100\n200\n300\n400\n500\n")
 REGRESSION(array_tofun, "100\n200\n300\n400\n500\n")
 REGRESSION(arrayreturn, "100\n200\n300\n400\n500\n")
 REGRESSION(arraylvar, "600\n700\n800\n")
+REGRESSION(array_dynamic, "100\n200\n300\n")
+REGRESSION(array_builtins, "30\n30\n51\n11\n55\n")
 
 REGRESSION(structtype, "999\n")
-REGRESSION(typealias, "100\n200\n100\n")
\ No newline at end of file
+REGRESSION(typealias, "100\n200\n100\n")
+REGRESSION(time_args, "60\n1000\n103\n0.25\n72\n0.75\n")
\ No newline at end of file